@@ -0,0 +1,91 @@
+// Arduino.h
+// ========================================
+// Subconjunto del core Arduino-ESP32 para el build nativo (host).
+
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include "WString.h"
+#include "NativeHost.h"
+
+using std::isnan;
+
+typedef uint8_t byte;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+int analogRead(uint8_t pin);
+
+uint32_t esp_random();
+
+class IPAddress {
+private:
+  uint8_t octets[4];
+
+public:
+  IPAddress() : octets{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : octets{a, b, c, d} {}
+  uint8_t operator[](int index) const { return octets[index]; }
+  String toString() const {
+    char out[16];
+    snprintf(out, sizeof(out), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+    return String(out);
+  }
+};
+
+class HardwareSerial {
+public:
+  void begin(unsigned long baud);
+  int available();
+  int read();
+  size_t write(uint8_t c);
+  size_t write(const uint8_t* buffer, size_t size);
+  size_t print(const char* str);
+  size_t print(const String& str) { return print(str.c_str()); }
+  size_t print(char c);
+  size_t print(int value) { return print(String(value)); }
+  size_t print(unsigned long value) { return print(String(value)); }
+  size_t print(const IPAddress& ip) { return print(ip.toString()); }
+  size_t println();
+  size_t println(const char* str) { return print(str) + println(); }
+  size_t println(const String& str) { return print(str) + println(); }
+  size_t println(int value) { return print(value) + println(); }
+  size_t println(unsigned long value) { return print(value) + println(); }
+  size_t println(const IPAddress& ip) { return print(ip) + println(); }
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+  void flush();
+};
+
+extern HardwareSerial Serial;
+
+class EspClass {
+public:
+  uint32_t getFreeHeap();
+  uint32_t getMinFreeHeap();
+  uint32_t getMaxAllocHeap();
+  uint64_t getEfuseMac();
+  void restart();
+};
+
+extern EspClass ESP;
+
+#endif
@@ -0,0 +1,25 @@
+// DHT.h
+// ========================================
+// DHT22 simulado: devuelve los valores fijados en la placa activa.
+
+#ifndef NATIVE_DHT_H
+#define NATIVE_DHT_H
+
+#include "Arduino.h"
+
+#define DHT11 11
+#define DHT22 22
+
+class DHT {
+public:
+  DHT(uint8_t pin, uint8_t type) { (void)pin; (void)type; }
+  void begin() {}
+  float readTemperature() {
+    return NativeHost::board().dhtFailure ? NAN : NativeHost::board().dhtTemperature;
+  }
+  float readHumidity() {
+    return NativeHost::board().dhtFailure ? NAN : NativeHost::board().dhtHumidity;
+  }
+};
+
+#endif
@@ -0,0 +1,91 @@
+// FS.h
+// ========================================
+// Archivos de flash simulados: el contenido vive en Board::files de la placa
+// que estaba activa al abrir el archivo.
+
+#ifndef NATIVE_FS_H
+#define NATIVE_FS_H
+
+#include <algorithm>
+
+#include "Arduino.h"
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+class File {
+private:
+  NativeHost::Board* board = nullptr;
+  std::string path;
+  size_t pos = 0;
+  bool writable = false;
+
+  std::string& data() { return board->files[path]; }
+
+public:
+  File() {}
+  File(NativeHost::Board* owner, const char* filePath, const char* mode)
+    : board(owner), path(filePath) {
+    writable = mode[0] != 'r' || mode[1] == '+';
+    if (mode[0] == 'w') data().clear();
+    if (mode[0] == 'a') pos = data().size();
+  }
+
+  explicit operator bool() const { return board != nullptr; }
+
+  size_t write(const uint8_t* buffer, size_t size) {
+    if (!board || !writable) return 0;
+    std::string& content = data();
+    if (pos > content.size()) pos = content.size();
+    content.replace(pos, size, (const char*)buffer, size);
+    pos += size;
+    return size;
+  }
+  size_t write(uint8_t c) { return write(&c, 1); }
+
+  size_t read(uint8_t* buffer, size_t size) {
+    if (!board) return 0;
+    const std::string& content = data();
+    if (pos >= content.size()) return 0;
+    size_t count = std::min(size, content.size() - pos);
+    memcpy(buffer, content.data() + pos, count);
+    pos += count;
+    return count;
+  }
+  int available() { return board && pos < data().size() ? (int)(data().size() - pos) : 0; }
+  bool seek(uint32_t position) {
+    if (!board || position > data().size()) return false;
+    pos = position;
+    return true;
+  }
+  size_t position() const { return pos; }
+  size_t size() { return board ? data().size() : 0; }
+  void flush() {}
+  void close() { board = nullptr; }
+};
+
+class FS {
+public:
+  File open(const char* path, const char* mode = FILE_READ) {
+    NativeHost::Board& board = NativeHost::board();
+    if (mode[0] == 'r' && !board.files.count(path)) return File();
+    return File(&board, path, mode);
+  }
+  bool exists(const char* path) { return NativeHost::board().files.count(path) > 0; }
+  bool remove(const char* path) { return NativeHost::board().files.erase(path) > 0; }
+  size_t totalBytes() { return 1408 * 1024; }  // Partición spiffs de la tabla por defecto
+  size_t usedBytes() {
+    size_t used = 0;
+    for (const auto& file : NativeHost::board().files) used += file.second.size();
+    return used;
+  }
+};
+
+}  // namespace fs
+
+using fs::File;
+
+#endif
@@ -0,0 +1,20 @@
+// HTTPClient.h
+// ========================================
+// Stub de HTTPClient: en nativo no hay backend de activación.
+
+#ifndef NATIVE_HTTP_CLIENT_H
+#define NATIVE_HTTP_CLIENT_H
+
+#include "WiFi.h"
+
+class HTTPClient {
+public:
+  bool begin(const String& url) { (void)url; return true; }
+  void addHeader(const String& name, const String& value) { (void)name; (void)value; }
+  void setTimeout(uint16_t timeout) { (void)timeout; }
+  int POST(const String& payload) { (void)payload; return -1; }
+  String getString() { return String(); }
+  void end() {}
+};
+
+#endif
@@ -0,0 +1,20 @@
+// LittleFS.h
+// ========================================
+
+#ifndef NATIVE_LITTLE_FS_H
+#define NATIVE_LITTLE_FS_H
+
+#include "FS.h"
+
+class LittleFSFS : public fs::FS {
+public:
+  bool begin(bool formatOnFail = false) {
+    (void)formatOnFail;
+    return true;
+  }
+  void end() {}
+};
+
+extern LittleFSFS LittleFS;
+
+#endif
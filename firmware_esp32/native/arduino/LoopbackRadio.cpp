@@ -0,0 +1,107 @@
+// LoopbackRadio.cpp
+// ========================================
+
+#include "LoopbackRadio.h"
+
+#include <algorithm>
+
+const uint8_t RadioTransport::BROADCAST_MAC[MAC_SIZE] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+namespace {
+
+// Radios encendidas (begin) en el proceso
+std::vector<LoopbackRadio*> radios;
+
+}  // namespace
+
+RadioTransport* RadioTransport::platform() {
+  return NativeHost::board().radio;
+}
+
+LoopbackRadio::LoopbackRadio(uint64_t mac) {
+  for (size_t i = 0; i < MAC_SIZE; i++) {
+    address[i] = (uint8_t)(mac >> (8 * (MAC_SIZE - 1 - i)));
+  }
+}
+
+LoopbackRadio::~LoopbackRadio() {
+  radios.erase(std::remove(radios.begin(), radios.end(), this), radios.end());
+}
+
+bool LoopbackRadio::begin(uint8_t channel) {
+  this->channel = channel;
+  if (!started) {
+    radios.push_back(this);
+    started = true;
+  }
+  return true;
+}
+
+void LoopbackRadio::getMacAddress(uint8_t* mac) {
+  memcpy(mac, address, MAC_SIZE);
+}
+
+bool LoopbackRadio::setKeys(const uint8_t* pmk, const uint8_t* lmk) {
+  (void)pmk;  // Solo protege la LMK en el aire
+  if (!started) return false;
+  memcpy(localKey, lmk, KEY_SIZE);
+  encrypted = true;
+  return true;
+}
+
+bool LoopbackRadio::addPeer(const uint8_t* mac) {
+  if (!started) return false;
+  if (!hasPeer(mac)) peers.push_back(std::string((const char*)mac, MAC_SIZE));
+  return true;
+}
+
+bool LoopbackRadio::hasPeer(const uint8_t* mac) const {
+  return std::find(peers.begin(), peers.end(), std::string((const char*)mac, MAC_SIZE)) != peers.end();
+}
+
+bool LoopbackRadio::canDecrypt(const LoopbackRadio& sender) const {
+  // Un par cifrado solo acepta tramas cifradas con su LMK; las de un par no
+  // registrado no se pueden descifrar
+  if (!sender.encrypted) return !(encrypted && hasPeer(sender.address));
+  return encrypted && hasPeer(sender.address) && memcmp(localKey, sender.localKey, KEY_SIZE) == 0;
+}
+
+bool LoopbackRadio::send(const uint8_t* mac, const uint8_t* data, size_t length) {
+  if (!started || !enabled || length > MAX_FRAME_SIZE) return false;
+  sentFrames++;
+
+  bool broadcast = memcmp(mac, BROADCAST_MAC, MAC_SIZE) == 0;
+  bool delivered = false;
+  if (!broadcast) addPeer(mac);
+
+  for (LoopbackRadio* radio : radios) {
+    if (radio == this || !radio->enabled || radio->channel != channel) continue;
+    if (!broadcast && memcmp(mac, radio->address, MAC_SIZE) != 0) continue;
+
+    delivered = true;
+    if (!broadcast && !radio->canDecrypt(*this)) {
+      radio->undecryptedFrames++;
+      continue;
+    }
+
+    Frame frame;
+    memcpy(frame.source, address, MAC_SIZE);
+    frame.data.assign((const char*)data, length);
+    radio->inbox.push_back(frame);
+  }
+
+  // Broadcast no tiene ACK: siempre "enviado"; unicast solo si alguien lo recibió
+  if (delivered) deliveredFrames++;
+  return broadcast || delivered;
+}
+
+size_t LoopbackRadio::receive(uint8_t* mac, uint8_t* data, size_t capacity) {
+  if (inbox.empty()) return 0;
+
+  Frame& frame = inbox.front();
+  size_t length = std::min(frame.data.size(), capacity);
+  memcpy(mac, frame.source, MAC_SIZE);
+  memcpy(data, frame.data.data(), length);
+  inbox.pop_front();
+  return length;
+}
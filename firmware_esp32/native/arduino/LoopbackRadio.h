@@ -0,0 +1,61 @@
+// LoopbackRadio.h
+// ========================================
+// RadioTransport nativo: bus ESP-NOW en memoria entre placas virtuales.
+// Cada placa con radio tiene su LoopbackRadio (Board::radio); una trama llega
+// a las radios del mismo canal cuya MAC coincide (o a todas en broadcast),
+// igual que en el aire, y queda en su cola hasta que el firmware la lee.
+// Con setKeys() el unicast solo se entrega si el receptor tiene al emisor como
+// par y la misma LMK (el ACK llega igual: en el aire se confirma antes de descifrar).
+
+#ifndef NATIVE_LOOPBACK_RADIO_H
+#define NATIVE_LOOPBACK_RADIO_H
+
+#include "radioTransport.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+
+class LoopbackRadio : public RadioTransport {
+public:
+  explicit LoopbackRadio(uint64_t mac);
+  ~LoopbackRadio() override;
+
+  bool begin(uint8_t channel) override;
+  uint8_t getChannel() override { return channel; }
+  void getMacAddress(uint8_t* mac) override;
+  bool setKeys(const uint8_t* pmk, const uint8_t* lmk) override;
+  bool addPeer(const uint8_t* mac) override;
+  bool send(const uint8_t* mac, const uint8_t* data, size_t length) override;
+  size_t receive(uint8_t* mac, uint8_t* data, size_t capacity) override;
+
+  // Radio apagada: no recibe ni confirma (gateway caído)
+  void setEnabled(bool enabled) { this->enabled = enabled; }
+
+  unsigned long getSentFrames() const { return sentFrames; }
+  unsigned long getDeliveredFrames() const { return deliveredFrames; }
+  unsigned long getUndecryptedFrames() const { return undecryptedFrames; }
+
+private:
+  struct Frame {
+    uint8_t source[MAC_SIZE];
+    std::string data;
+  };
+
+  uint8_t address[MAC_SIZE];
+  uint8_t channel = 0;
+  bool started = false;
+  bool enabled = true;
+  bool encrypted = false;
+  uint8_t localKey[KEY_SIZE];
+  std::vector<std::string> peers;  // MAC de los pares registrados
+  std::deque<Frame> inbox;
+  unsigned long sentFrames = 0;
+  unsigned long deliveredFrames = 0;
+  unsigned long undecryptedFrames = 0;
+
+  bool hasPeer(const uint8_t* mac) const;
+  bool canDecrypt(const LoopbackRadio& sender) const;
+};
+
+#endif
@@ -0,0 +1,28 @@
+// NTPClient.h
+// ========================================
+// NTP simulado: la hora epoch la entrega el reloj del host (ver NativeHost).
+
+#ifndef NATIVE_NTP_CLIENT_H
+#define NATIVE_NTP_CLIENT_H
+
+#include "WiFiUdp.h"
+
+class NTPClient {
+private:
+  long offsetSeconds;
+
+public:
+  NTPClient(WiFiUDP& udp, const char* server, long offset = 0, unsigned long interval = 60000)
+    : offsetSeconds(offset) {
+    (void)udp;
+    (void)server;
+    (void)interval;
+  }
+  void begin() {}
+  bool update() { return true; }
+  bool forceUpdate() { return true; }
+  bool isTimeSet() const { return true; }
+  unsigned long getEpochTime() const { return NativeHost::currentEpoch() + offsetSeconds; }
+};
+
+#endif
@@ -0,0 +1,215 @@
+// NativeHost.cpp
+// ========================================
+
+#include "Arduino.h"
+#include "WiFi.h"
+#include "LittleFS.h"
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+HardwareSerial Serial;
+EspClass ESP;
+WiFiClass WiFi;
+LittleFSFS LittleFS;
+
+namespace {
+
+NativeHost::Board defaultBoard;
+NativeHost::Board* activeBoard = &defaultBoard;
+
+const auto startTime = std::chrono::steady_clock::now();
+unsigned long long virtualOffsetMicros = 0;
+bool virtualTime = false;
+uint32_t epochBase = 0;
+
+bool serialEnabled = true;
+void (*restartHandler)() = nullptr;
+
+unsigned long long elapsedMicros() {
+  auto elapsed = std::chrono::steady_clock::now() - startTime;
+  return (unsigned long long)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+}  // namespace
+
+namespace NativeHost {
+
+void selectBoard(Board* board) {
+  activeBoard = board ? board : &defaultBoard;
+}
+
+Board& board() {
+  return *activeBoard;
+}
+
+void setVirtualTime(bool enabled) {
+  virtualTime = enabled;
+}
+
+bool isVirtualTime() {
+  return virtualTime;
+}
+
+void advanceMillis(unsigned long ms) {
+  virtualOffsetMicros += (unsigned long long)ms * 1000ULL;
+}
+
+unsigned long long currentMicros() {
+  // En modo virtual el tiempo solo avanza explícitamente (delay/advanceMillis)
+  return virtualTime ? virtualOffsetMicros : elapsedMicros() + virtualOffsetMicros;
+}
+
+unsigned long currentMillis() {
+  return (unsigned long)(currentMicros() / 1000ULL);
+}
+
+void setEpochBase(uint32_t epochSeconds) {
+  epochBase = epochSeconds;
+}
+
+uint32_t currentEpoch() {
+  if (epochBase == 0) {
+    epochBase = (uint32_t)time(nullptr) - (uint32_t)(currentMicros() / 1000000ULL);
+  }
+  return epochBase + (uint32_t)(currentMicros() / 1000000ULL);
+}
+
+void setRestartHandler(void (*handler)()) {
+  restartHandler = handler;
+}
+
+void requestRestart() {
+  if (restartHandler) {
+    restartHandler();
+    return;
+  }
+  fflush(stdout);
+  std::exit(0);
+}
+
+void setSerialEnabled(bool enabled) {
+  serialEnabled = enabled;
+}
+
+bool isSerialEnabled() {
+  return serialEnabled;
+}
+
+}  // namespace NativeHost
+
+// === Core Arduino ===
+
+unsigned long millis() {
+  return NativeHost::currentMillis();
+}
+
+unsigned long micros() {
+  return (unsigned long)NativeHost::currentMicros();
+}
+
+void delay(unsigned long ms) {
+  if (NativeHost::isVirtualTime()) {
+    NativeHost::advanceMillis(ms);
+  } else {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  }
+}
+
+void yield() {}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin;
+  (void)mode;
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < NativeHost::NUM_PINS ? NativeHost::board().digital[pin] : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin < NativeHost::NUM_PINS) NativeHost::board().digital[pin] = value;
+}
+
+int analogRead(uint8_t pin) {
+  return pin < NativeHost::NUM_PINS ? NativeHost::board().analog[pin] : 0;
+}
+
+uint32_t esp_random() {
+  static std::mt19937 generator{std::random_device{}()};
+  return generator();
+}
+
+// === Serial ===
+
+void HardwareSerial::begin(unsigned long baud) {
+  (void)baud;
+}
+
+int HardwareSerial::available() {
+  return 0;
+}
+
+int HardwareSerial::read() {
+  return -1;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  if (!NativeHost::isSerialEnabled()) return 1;
+  return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+  if (!NativeHost::isSerialEnabled()) return size;
+  return fwrite(buffer, 1, size, stdout);
+}
+
+size_t HardwareSerial::print(const char* str) {
+  return write((const uint8_t*)str, strlen(str));
+}
+
+size_t HardwareSerial::print(char c) {
+  return write((uint8_t)c);
+}
+
+size_t HardwareSerial::println() {
+  return print("\n");
+}
+
+size_t HardwareSerial::printf(const char* format, ...) {
+  if (!NativeHost::isSerialEnabled()) return 0;
+  va_list args;
+  va_start(args, format);
+  int written = vprintf(format, args);
+  va_end(args);
+  return written < 0 ? 0 : (size_t)written;
+}
+
+void HardwareSerial::flush() {
+  fflush(stdout);
+}
+
+// === ESP ===
+
+uint32_t EspClass::getFreeHeap() {
+  return 320 * 1024;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+  return getFreeHeap();
+}
+
+uint32_t EspClass::getMaxAllocHeap() {
+  return getFreeHeap();
+}
+
+uint64_t EspClass::getEfuseMac() {
+  return NativeHost::board().efuseMac;
+}
+
+void EspClass::restart() {
+  NativeHost::requestRestart();
+}
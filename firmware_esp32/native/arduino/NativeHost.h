@@ -0,0 +1,107 @@
+// NativeHost.h
+// ========================================
+// Estado del "hardware" simulado para el build nativo.
+// Cada Board representa un ESP32 virtual: pines, sensores, flash (Preferences)
+// y los transportes MQTT y de radio. Las clases del firmware son estáticas, así
+// que las herramientas nativas seleccionan la placa activa antes de llamar al firmware.
+
+#ifndef NATIVE_HOST_H
+#define NATIVE_HOST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+class RadioTransport;  // src/radioTransport.h (ESP-NOW), ver LoopbackRadio.h
+
+namespace NativeHost {
+
+const int NUM_PINS = 40;
+
+// Transporte MQTT detrás del shim de PubSubClient
+class MqttTransport {
+public:
+  virtual ~MqttTransport() {}
+  virtual bool connect(const char* clientId, const char* username, const char* password) = 0;
+  virtual bool connected() = 0;
+  virtual bool publish(const char* topic, const uint8_t* payload, size_t length, bool retained) = 0;
+  virtual void loop() = 0;
+  virtual int state() = 0;
+  // Comandos entrantes: opcional, los transportes de carga no reciben mensajes
+  virtual bool subscribe(const char* topic) { (void)topic; return false; }
+};
+
+// Socket TCP detrás del shim de WiFiClient (pruebas de protocolo: native/mqtt5_test)
+class SocketTransport {
+public:
+  virtual ~SocketTransport() {}
+  virtual bool connect(const char* host, uint16_t port) = 0;
+  virtual bool connected() = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size) = 0;
+  virtual int available() = 0;
+  virtual int read(uint8_t* buffer, size_t size) = 0;
+  virtual void stop() = 0;
+};
+
+// Punto de acceso visible para el escaneo WiFi simulado
+struct AccessPoint {
+  std::string ssid;
+  int32_t rssi;
+  uint8_t channel;
+  uint8_t bssid[6];
+};
+
+struct Board {
+  // namespace de Preferences -> clave -> valor
+  std::map<std::string, std::map<std::string, std::string>> prefs;
+  // Sistema de archivos en flash (LittleFS): ruta -> contenido
+  std::map<std::string, std::string> files;
+
+  int digital[NUM_PINS] = {0};
+  int analog[NUM_PINS] = {0};
+  float dhtTemperature = 0.0f;
+  float dhtHumidity = 0.0f;
+  bool dhtFailure = false;
+
+  bool wifiConnected = true;
+  uint8_t wifiChannel = 6;
+  // Sin puntos de acceso: begin() acepta cualquier SSID y el escaneo no ve redes.
+  // Con puntos de acceso: begin() solo asocia a un SSID (y BSSID) de la lista.
+  std::vector<AccessPoint> accessPoints;
+  int connectedAp = -1;
+  int16_t scanState = -2;  // WIFI_SCAN_FAILED: sin escaneo
+  uint64_t efuseMac = 0x24d7eb000000ULL;
+
+  MqttTransport* mqtt = nullptr;
+  RadioTransport* radio = nullptr;
+  // Compartido por todos los WiFiClient de la placa; sin él nunca conectan
+  SocketTransport* socket = nullptr;
+};
+
+// Placa activa (todas las llamadas del shim se resuelven contra ella)
+void selectBoard(Board* board);
+Board& board();
+
+// Reloj: millis() = tiempo real transcurrido + desplazamiento virtual.
+// En modo virtual delay() avanza el desplazamiento en lugar de dormir.
+void setVirtualTime(bool enabled);
+bool isVirtualTime();
+void advanceMillis(unsigned long ms);
+unsigned long currentMillis();
+unsigned long long currentMicros();
+void setEpochBase(uint32_t epochSeconds);
+uint32_t currentEpoch();
+
+// ESP.restart(): por defecto termina el proceso
+void setRestartHandler(void (*handler)());
+void requestRestart();
+
+// Serial: permite silenciar los logs cuando se simulan miles de placas
+void setSerialEnabled(bool enabled);
+bool isSerialEnabled();
+
+}  // namespace NativeHost
+
+#endif
@@ -0,0 +1,76 @@
+// Preferences.h
+// ========================================
+// Preferences (NVS) respaldado por el mapa de la placa activa.
+
+#ifndef NATIVE_PREFERENCES_H
+#define NATIVE_PREFERENCES_H
+
+#include "Arduino.h"
+
+class Preferences {
+private:
+  std::string ns;
+  bool started = false;
+
+  std::map<std::string, std::string>& store() { return NativeHost::board().prefs[ns]; }
+
+public:
+  bool begin(const char* name, bool readOnly = false) {
+    (void)readOnly;
+    ns = name;
+    started = true;
+    return true;
+  }
+  void end() { started = false; }
+
+  bool clear() {
+    store().clear();
+    return true;
+  }
+  bool remove(const char* key) { return store().erase(key) > 0; }
+  bool isKey(const char* key) { return store().count(key) > 0; }
+
+  size_t putString(const char* key, const String& value) {
+    store()[key] = value.c_str();
+    return value.length();
+  }
+  size_t putString(const char* key, const char* value) { return putString(key, String(value)); }
+  String getString(const char* key, const String& defaultValue = String()) {
+    auto& values = store();
+    auto it = values.find(key);
+    return it == values.end() ? defaultValue : String(it->second.c_str());
+  }
+
+  size_t putUInt(const char* key, uint32_t value) {
+    store()[key] = std::to_string(value);
+    return sizeof(value);
+  }
+  uint32_t getUInt(const char* key, uint32_t defaultValue = 0) {
+    auto& values = store();
+    auto it = values.find(key);
+    return it == values.end() ? defaultValue : (uint32_t)strtoul(it->second.c_str(), nullptr, 10);
+  }
+
+  size_t putBool(const char* key, bool value) { return putUInt(key, value ? 1 : 0) > 0 ? 1 : 0; }
+  bool getBool(const char* key, bool defaultValue = false) { return getUInt(key, defaultValue ? 1 : 0) != 0; }
+
+  size_t putBytes(const char* key, const void* value, size_t len) {
+    store()[key] = std::string((const char*)value, len);
+    return len;
+  }
+  size_t getBytesLength(const char* key) {
+    auto& values = store();
+    auto it = values.find(key);
+    return it == values.end() ? 0 : it->second.size();
+  }
+  size_t getBytes(const char* key, void* buf, size_t maxLen) {
+    auto& values = store();
+    auto it = values.find(key);
+    if (it == values.end()) return 0;
+    size_t len = it->second.size() < maxLen ? it->second.size() : maxLen;
+    memcpy(buf, it->second.data(), len);
+    return len;
+  }
+};
+
+#endif
@@ -0,0 +1,84 @@
+// PubSubClient.h
+// ========================================
+// PubSubClient nativo: delega en el MqttTransport de la placa activa.
+
+#ifndef NATIVE_PUB_SUB_CLIENT_H
+#define NATIVE_PUB_SUB_CLIENT_H
+
+#include "WiFi.h"
+
+#define MQTT_CONNECTION_TIMEOUT -4
+#define MQTT_CONNECTION_LOST -3
+#define MQTT_CONNECT_FAILED -2
+#define MQTT_DISCONNECTED -1
+#define MQTT_CONNECTED 0
+
+#define MQTT_CALLBACK_SIGNATURE void (*callback)(char*, uint8_t*, unsigned int)
+
+class PubSubClient {
+private:
+  String host;
+  uint16_t port = 0;
+  MQTT_CALLBACK_SIGNATURE = nullptr;
+
+  static NativeHost::MqttTransport* transport() { return NativeHost::board().mqtt; }
+
+public:
+  explicit PubSubClient(WiFiClient& client) { (void)client; }
+
+  PubSubClient& setServer(const char* domain, uint16_t serverPort) {
+    host = domain;
+    port = serverPort;
+    return *this;
+  }
+
+  bool setBufferSize(uint16_t size) {
+    (void)size;
+    return true;
+  }
+
+  // Interfaz de Mqtt5Client (src/mqtt5Client.h): el transporte nativo habla 3.1.1
+  PubSubClient& setReceiveMaximum(uint16_t receiveMaximum) {
+    (void)receiveMaximum;
+    return *this;
+  }
+  uint8_t getProtocolLevel() { return 4; }
+  // Sin medida de latencia de sesión: el transporte nativo no tiene PINGREQ
+  bool ping() { return false; }
+  bool takePingLatency(long& rtt) {
+    (void)rtt;
+    return false;
+  }
+
+  PubSubClient& setCallback(MQTT_CALLBACK_SIGNATURE) {
+    this->callback = callback;
+    return *this;
+  }
+
+  bool connect(const char* id, const char* user, const char* pass) {
+    return transport() && transport()->connect(id, user, pass);
+  }
+  bool connected() { return transport() && transport()->connected(); }
+  int state() { return transport() ? transport()->state() : MQTT_DISCONNECTED; }
+  bool loop() {
+    if (!transport()) return false;
+    transport()->loop();
+    return transport()->connected();
+  }
+  bool publish(const char* topic, const char* payload, bool retained = false) {
+    return publish(topic, (const uint8_t*)payload, strlen(payload), retained);
+  }
+  bool publish(const char* topic, const uint8_t* payload, unsigned int length, bool retained = false) {
+    return transport() && transport()->publish(topic, payload, length, retained);
+  }
+  bool publish(const char* topic, const uint8_t* payload, unsigned int length, bool retained,
+               uint32_t messageExpiry, const char* contentType) {
+    (void)messageExpiry;
+    (void)contentType;
+    return publish(topic, payload, length, retained);
+  }
+  bool subscribe(const char* topic) { return transport() && transport()->subscribe(topic); }
+  void disconnect() {}
+};
+
+#endif
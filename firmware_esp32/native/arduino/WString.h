@@ -0,0 +1,168 @@
+// WString.h
+// ========================================
+// Implementación mínima de String de Arduino para el build nativo (host).
+// Solo cubre la API que usa el firmware y ArduinoJson.
+
+#ifndef NATIVE_WSTRING_H
+#define NATIVE_WSTRING_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#define DEC 10
+#define HEX 16
+
+class String {
+private:
+  std::string buffer;
+
+  static std::string formatInteger(unsigned long long value, unsigned char base, bool negative) {
+    if (value == 0) return "0";
+    char digits[66];
+    int pos = sizeof(digits) - 1;
+    digits[pos] = '\0';
+    while (value > 0 && pos > 1) {
+      unsigned digit = value % base;
+      digits[--pos] = digit < 10 ? char('0' + digit) : char('a' + digit - 10);
+      value /= base;
+    }
+    if (negative) digits[--pos] = '-';
+    return std::string(&digits[pos]);
+  }
+
+  static std::string formatSigned(long long value, unsigned char base) {
+    if (base == 10 && value < 0) {
+      return formatInteger(0ULL - (unsigned long long)value, base, true);
+    }
+    return formatInteger((unsigned long long)value, base, false);
+  }
+
+  static std::string formatFloat(double value, unsigned int decimals) {
+    char out[64];
+    snprintf(out, sizeof(out), "%.*f", (int)decimals, value);
+    return std::string(out);
+  }
+
+public:
+  String() {}
+  String(const char* str) : buffer(str ? str : "") {}
+  String(const char* str, size_t len) : buffer(str ? str : "", str ? len : 0) {}
+  String(const String& other) = default;
+  String(String&& other) = default;
+  explicit String(char c) : buffer(1, c) {}
+  explicit String(bool value) : buffer(value ? "1" : "0") {}
+  explicit String(int value, unsigned char base = DEC) : buffer(formatSigned(value, base)) {}
+  explicit String(unsigned int value, unsigned char base = DEC) : buffer(formatInteger(value, base, false)) {}
+  explicit String(long value, unsigned char base = DEC) : buffer(formatSigned(value, base)) {}
+  explicit String(unsigned long value, unsigned char base = DEC) : buffer(formatInteger(value, base, false)) {}
+  explicit String(long long value, unsigned char base = DEC) : buffer(formatSigned(value, base)) {}
+  explicit String(unsigned long long value, unsigned char base = DEC) : buffer(formatInteger(value, base, false)) {}
+  explicit String(float value, unsigned int decimals = 2) : buffer(formatFloat(value, decimals)) {}
+  explicit String(double value, unsigned int decimals = 2) : buffer(formatFloat(value, decimals)) {}
+
+  String& operator=(const String& other) = default;
+  String& operator=(String&& other) = default;
+  String& operator=(const char* str) {
+    buffer = str ? str : "";
+    return *this;
+  }
+
+  const char* c_str() const { return buffer.c_str(); }
+  unsigned int length() const { return (unsigned int)buffer.size(); }
+  bool isEmpty() const { return buffer.empty(); }
+  bool reserve(unsigned int size) {
+    buffer.reserve(size);
+    return true;
+  }
+
+  bool concat(const String& other) {
+    buffer += other.buffer;
+    return true;
+  }
+  bool concat(const char* str) {
+    if (!str) return false;
+    buffer += str;
+    return true;
+  }
+  bool concat(const char* str, unsigned int len) {
+    if (!str) return false;
+    buffer.append(str, len);
+    return true;
+  }
+  bool concat(char c) {
+    buffer += c;
+    return true;
+  }
+
+  String& operator+=(const String& other) { concat(other); return *this; }
+  String& operator+=(const char* str) { concat(str); return *this; }
+  String& operator+=(char c) { concat(c); return *this; }
+
+  char charAt(unsigned int index) const { return index < buffer.size() ? buffer[index] : 0; }
+  char operator[](unsigned int index) const { return charAt(index); }
+
+  String substring(unsigned int from) const {
+    return from >= buffer.size() ? String() : String(buffer.c_str() + from);
+  }
+  String substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= buffer.size()) return String();
+    if (to > buffer.size()) to = buffer.size();
+    return String(buffer.c_str() + from, to - from);
+  }
+
+  int indexOf(char c, unsigned int from = 0) const {
+    size_t pos = buffer.find(c, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+  }
+  int indexOf(const String& str, unsigned int from = 0) const {
+    size_t pos = buffer.find(str.buffer, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+  }
+  bool startsWith(const String& prefix) const {
+    return buffer.compare(0, prefix.buffer.size(), prefix.buffer) == 0;
+  }
+
+  void trim() {
+    size_t begin = buffer.find_first_not_of(" \t\r\n");
+    size_t end = buffer.find_last_not_of(" \t\r\n");
+    buffer = begin == std::string::npos ? std::string() : buffer.substr(begin, end - begin + 1);
+  }
+
+  long toInt() const { return strtol(buffer.c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(buffer.c_str(), nullptr); }
+
+  bool equals(const String& other) const { return buffer == other.buffer; }
+  bool operator==(const String& other) const { return buffer == other.buffer; }
+  bool operator==(const char* str) const { return buffer == (str ? str : ""); }
+  bool operator!=(const String& other) const { return buffer != other.buffer; }
+  bool operator!=(const char* str) const { return !(*this == str); }
+  bool operator<(const String& other) const { return buffer < other.buffer; }
+
+  friend String operator+(const String& lhs, const String& rhs) {
+    String result(lhs);
+    result.concat(rhs);
+    return result;
+  }
+  friend String operator+(const String& lhs, const char* rhs) {
+    String result(lhs);
+    result.concat(rhs);
+    return result;
+  }
+  friend String operator+(const char* lhs, const String& rhs) {
+    String result(lhs);
+    result.concat(rhs);
+    return result;
+  }
+  friend String operator+(const String& lhs, char rhs) {
+    String result(lhs);
+    result.concat(rhs);
+    return result;
+  }
+};
+
+#endif
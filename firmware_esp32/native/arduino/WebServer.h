@@ -0,0 +1,34 @@
+// WebServer.h
+// ========================================
+// Stub del servidor web del portal de configuración (no se usa en nativo).
+
+#ifndef NATIVE_WEB_SERVER_H
+#define NATIVE_WEB_SERVER_H
+
+#include "WiFi.h"
+
+typedef enum { HTTP_ANY, HTTP_GET, HTTP_POST } HTTPMethod;
+
+class WebServer {
+public:
+  typedef void (*THandlerFunction)();
+
+  explicit WebServer(int port = 80) { (void)port; }
+  void on(const char* uri, THandlerFunction handler) { (void)uri; (void)handler; }
+  void on(const char* uri, HTTPMethod method, THandlerFunction handler) {
+    (void)uri;
+    (void)method;
+    (void)handler;
+  }
+  void onNotFound(THandlerFunction handler) { (void)handler; }
+  void begin() {}
+  void handleClient() {}
+  String arg(const char* name) { (void)name; return String(); }
+  void send(int code, const char* contentType, const String& content) {
+    (void)code;
+    (void)contentType;
+    (void)content;
+  }
+};
+
+#endif
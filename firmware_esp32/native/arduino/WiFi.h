@@ -0,0 +1,116 @@
+// WiFi.h
+// ========================================
+// WiFi simulado: el estado de conexión lo decide la placa activa.
+
+#ifndef NATIVE_WIFI_H
+#define NATIVE_WIFI_H
+
+#include "Arduino.h"
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+// Sin red real: sin SocketTransport en la placa (lo normal) los sockets directos
+// (sondeo de brokers MQTT) nunca conectan y MQTT va por el shim de PubSubClient
+class WiFiClient {
+private:
+  static NativeHost::SocketTransport* socket() { return NativeHost::board().socket; }
+
+public:
+  int connect(const char* host, uint16_t port) { return socket() && socket()->connect(host, port) ? 1 : 0; }
+  int connect(const char* host, uint16_t port, int32_t timeout) { (void)timeout; return connect(host, port); }
+  bool connected() { return socket() && socket()->connected(); }
+  size_t write(const uint8_t* buffer, size_t size) { return socket() ? socket()->write(buffer, size) : 0; }
+  int available() { return socket() ? socket()->available() : 0; }
+  int read(uint8_t* buffer, size_t size) { return socket() ? socket()->read(buffer, size) : -1; }
+  void stop() {
+    if (socket()) socket()->stop();
+  }
+};
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+
+class WiFiClass {
+public:
+  // Con bssid se asocia a ese AP; sin él, al primero de la lista con el SSID
+  // (como el fast scan del ESP32, que no elige el más fuerte)
+  wl_status_t begin(const char* ssid, const char* password = nullptr, int32_t channel = 0,
+                    const uint8_t* bssid = nullptr, bool connect = true) {
+    (void)password;
+    (void)connect;
+    NativeHost::Board& b = NativeHost::board();
+    if (b.accessPoints.empty()) return status();
+
+    b.connectedAp = -1;
+    for (size_t i = 0; i < b.accessPoints.size(); i++) {
+      const NativeHost::AccessPoint& ap = b.accessPoints[i];
+      if (ap.ssid != ssid) continue;
+      if (channel != 0 && ap.channel != channel) continue;
+      if (bssid && memcmp(ap.bssid, bssid, 6) != 0) continue;
+      b.connectedAp = (int)i;
+      break;
+    }
+    return status();
+  }
+  wl_status_t status() {
+    NativeHost::Board& b = NativeHost::board();
+    bool associated = b.accessPoints.empty() || b.connectedAp >= 0;
+    return b.wifiConnected && associated ? WL_CONNECTED : WL_DISCONNECTED;
+  }
+  bool softAP(const char* ssid, const char* password = nullptr) {
+    (void)ssid;
+    (void)password;
+    return true;
+  }
+  IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }
+  IPAddress localIP() { return IPAddress(10, 0, 0, 2); }
+  int8_t RSSI() {
+    const NativeHost::AccessPoint* ap = connectedAp();
+    return ap ? (int8_t)ap->rssi : -60;
+  }
+  uint8_t channel() {
+    const NativeHost::AccessPoint* ap = connectedAp();
+    return ap ? ap->channel : NativeHost::board().wifiChannel;
+  }
+  uint8_t* BSSID() {
+    static uint8_t none[6] = {0};
+    NativeHost::AccessPoint* ap = connectedAp();
+    return ap ? ap->bssid : none;
+  }
+  bool disconnect(bool wifiOff = false) {
+    (void)wifiOff;
+    NativeHost::board().connectedAp = -1;
+    return true;
+  }
+
+  // Escaneo: ve los puntos de acceso de la placa; el asíncrono termina en el siguiente scanComplete()
+  int16_t scanNetworks(bool async = false, bool showHidden = false) {
+    (void)showHidden;
+    NativeHost::Board& b = NativeHost::board();
+    b.scanState = (int16_t)b.accessPoints.size();
+    return async ? WIFI_SCAN_RUNNING : b.scanState;
+  }
+  int16_t scanComplete() { return NativeHost::board().scanState; }
+  void scanDelete() { NativeHost::board().scanState = WIFI_SCAN_FAILED; }
+  String SSID(uint8_t i) { return String(NativeHost::board().accessPoints[i].ssid.c_str()); }
+  int32_t RSSI(uint8_t i) { return NativeHost::board().accessPoints[i].rssi; }
+  int32_t channel(uint8_t i) { return NativeHost::board().accessPoints[i].channel; }
+  uint8_t* BSSID(uint8_t i) { return NativeHost::board().accessPoints[i].bssid; }
+
+private:
+  NativeHost::AccessPoint* connectedAp() {
+    NativeHost::Board& b = NativeHost::board();
+    if (b.connectedAp < 0 || b.connectedAp >= (int)b.accessPoints.size()) return nullptr;
+    return &b.accessPoints[b.connectedAp];
+  }
+};
+
+extern WiFiClass WiFi;
+
+#endif
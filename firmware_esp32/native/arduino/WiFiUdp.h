@@ -0,0 +1,11 @@
+// WiFiUdp.h
+// ========================================
+
+#ifndef NATIVE_WIFI_UDP_H
+#define NATIVE_WIFI_UDP_H
+
+#include "Arduino.h"
+
+class WiFiUDP {};
+
+#endif
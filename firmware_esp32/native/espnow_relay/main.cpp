@@ -0,0 +1,269 @@
+// main.cpp (espnow_relay)
+// ========================================
+// Gateway ESP-NOW y hojas en tiempo virtual sobre LoopbackRadio: cada hoja
+// ejecuta OperationMode en rol "leaf" (descubrimiento, envío) y el gateway
+// reenvía sus lecturas a un broker en memoria. Falla (exit 1) si alguna
+// lectura entregada por una hoja no aparece en su topic devices/{id}/sensors.
+//
+// Las clases del firmware son estáticas: las hojas se ejecutan una tras otra,
+// intercaladas vuelta a vuelta con el gateway.
+//
+// Al final corren dos intrusos con el gateway ya en su caché: uno con la LMK
+// de la flota pero fuera de la lista del gateway y otro en la lista con otra
+// LMK. Falla si el gateway reenvía alguna lectura suya.
+//
+// Uso:
+//   pio run -e native_espnow && .pio/build/native_espnow/program --leaves 4 --minutes 30
+
+#include "alertEvaluator.h"
+#include "espNowGateway.h"
+#include "espNowLeaf.h"
+#include "mqttClient.h"
+#include "operationMode.h"
+#include "samplingScheduler.h"
+#include "sensor.h"
+#include "storage.h"
+
+#include <LoopbackRadio.h>
+#include <NativeHost.h>
+#include <config.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+const unsigned long LOOP_DELAY_MS = 100;  // delay(100) de loop() en main.cpp
+const uint8_t GATEWAY_CHANNEL = 6;
+const uint8_t MOVED_GATEWAY_CHANNEL = 11;
+const uint64_t GATEWAY_MAC = 0x24d7eb000000ULL;
+
+// Broker en memoria: cuenta publicaciones por topic
+class CountingTransport : public NativeHost::MqttTransport {
+public:
+  std::map<std::string, unsigned long> published;
+  std::string lastPayload;
+
+  bool connect(const char* clientId, const char* username, const char* password) override {
+    (void)clientId; (void)username; (void)password;
+    return true;
+  }
+  bool connected() override { return true; }
+  bool publish(const char* topic, const uint8_t* payload, size_t length, bool retained) override {
+    (void)retained;
+    published[topic]++;
+    lastPayload.assign((const char*)payload, length);
+    return true;
+  }
+  void loop() override {}
+  int state() override { return 0; }
+};
+
+struct Node {
+  NativeHost::Board board;
+  std::unique_ptr<LoopbackRadio> radio;
+  std::string deviceId;
+};
+
+void provision(Node& node, const char* role, const char* sensorType, uint64_t mac, size_t index) {
+  char id[25];
+  snprintf(id, sizeof(id), "e5a0%020zx", index);
+  node.deviceId = id;
+
+  auto& prefs = node.board.prefs["device_config"];
+  prefs["ssid"] = "clinic";
+  prefs["password"] = "clinic";
+  prefs["deviceId"] = node.deviceId;
+  prefs["sensorType"] = sensorType;
+  prefs["role"] = role;
+
+  node.board.efuseMac = mac;
+  node.board.wifiChannel = GATEWAY_CHANNEL;
+  node.board.dhtTemperature = 22.0f + 0.5f * (float)index;
+  node.board.dhtHumidity = 45.0f;
+  node.board.analog[MQ4_PIN] = 80;
+  node.radio.reset(new LoopbackRadio(mac));
+  node.board.radio = node.radio.get();
+}
+
+// "prov leaf": la hoja entra en la lista del gateway
+void allowLeaf(Node& gateway, uint64_t mac, const std::string& deviceId, size_t slot) {
+  uint8_t bytes[RadioTransport::MAC_SIZE];
+  for (size_t i = 0; i < RadioTransport::MAC_SIZE; i++) {
+    bytes[i] = (uint8_t)(mac >> (8 * (RadioTransport::MAC_SIZE - 1 - i)));
+  }
+  auto& prefs = gateway.board.prefs["device_config"];
+  prefs["leafMac" + std::to_string(slot)] = std::string((const char*)bytes, sizeof(bytes));
+  prefs["leafId" + std::to_string(slot)] = deviceId;
+}
+
+// Caché de descubrimiento apuntando al gateway real: envía READING sin DISCOVER
+void cacheGateway(Node& leaf, uint8_t channel) {
+  std::string mac("\x24\xd7\xeb\x00\x00\x00", 6);
+  leaf.board.prefs["device_config"]["espnowGateway"] = mac;
+  leaf.board.prefs["device_config"]["espnowChannel"] = std::to_string(channel);
+}
+
+void stepGateway(Node& gateway) {
+  NativeHost::selectBoard(&gateway.board);
+  EspNowGateway::loop();
+  MQTTClient::loop();
+}
+
+// Una hoja en rol "leaf" durante `minutes` de tiempo simulado; devuelve las lecturas entregadas
+unsigned long runLeaf(Node& leaf, Node& gateway, unsigned long minutes) {
+  NativeHost::selectBoard(&leaf.board);
+  Storage::init();
+  Sensor::init();
+  SamplingScheduler::init(Sensor::getSensorType());
+  AlertEvaluator::init(Sensor::getSensorType());
+  OperationMode::start();
+
+  unsigned long sentBefore = EspNowLeaf::getSentCount();
+  unsigned long iterations = minutes * 60000UL / LOOP_DELAY_MS;
+
+  for (unsigned long i = 0; i < iterations; i++) {
+    NativeHost::selectBoard(&leaf.board);
+    Sensor::checkPIRContinuously();
+    OperationMode::loop();
+    stepGateway(gateway);
+    delay(LOOP_DELAY_MS);
+  }
+
+  // Vaciar el último lote del gateway
+  for (unsigned long i = 0; i <= ESPNOW_BATCH_INTERVAL / LOOP_DELAY_MS; i++) {
+    stepGateway(gateway);
+    delay(LOOP_DELAY_MS);
+  }
+
+  NativeHost::selectBoard(&leaf.board);
+  return EspNowLeaf::getSentCount() - sentBefore;
+}
+
+void printUsage() {
+  printf("Usage: espnow_relay [--leaves <n>] [--minutes <n>] [--sensor dht22|mq4] [--verbose]\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t leafCount = 4;
+  unsigned long minutes = 30;
+  const char* sensorType = "dht22";
+  bool verbose = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--verbose") == 0) {
+      verbose = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      printUsage();
+      return 2;
+    }
+    if (strcmp(argv[i], "--leaves") == 0) leafCount = strtoul(argv[++i], nullptr, 10);
+    else if (strcmp(argv[i], "--minutes") == 0) minutes = strtoul(argv[++i], nullptr, 10);
+    else if (strcmp(argv[i], "--sensor") == 0) sensorType = argv[++i];
+    else {
+      printUsage();
+      return 2;
+    }
+  }
+
+  NativeHost::setVirtualTime(true);
+  NativeHost::setEpochBase(1700000000);
+  NativeHost::setSerialEnabled(verbose);
+
+  static CountingTransport broker;
+  static Node gateway;
+  provision(gateway, "gateway", "dht22", GATEWAY_MAC, 0);
+  gateway.board.mqtt = &broker;
+
+  // Un slot de la lista queda para el intruso con otra LMK
+  if (leafCount > ESPNOW_MAX_LEAVES - 1) {
+    fprintf(stderr, "At most %d leaves per gateway\n", ESPNOW_MAX_LEAVES - 1);
+    return 2;
+  }
+
+  std::vector<std::unique_ptr<Node>> leaves;
+  for (size_t i = 0; i < leafCount; i++) {
+    leaves.emplace_back(new Node());
+    provision(*leaves.back(), "leaf", sensorType, 0x24d7eb000100ULL + i, i + 1);
+    allowLeaf(gateway, 0x24d7eb000100ULL + i, leaves.back()->deviceId, i);
+  }
+
+  Node unlisted;
+  provision(unlisted, "leaf", sensorType, 0x24d7eb000200ULL, leafCount + 1);
+
+  Node wrongKey;
+  provision(wrongKey, "leaf", sensorType, 0x24d7eb000201ULL, leafCount + 2);
+  allowLeaf(gateway, 0x24d7eb000201ULL, wrongKey.deviceId, leafCount);
+  wrongKey.board.prefs["device_config"]["espnowLmk"] = std::string("otra-lmk-0000000", 16);
+
+  // Las hojas impares arrancan con un gateway obsoleto en flash (otro canal)
+  for (size_t i = 1; i < leafCount; i += 2) {
+    std::string stale("\x24\xd7\xeb\x00\x09\x99", 6);
+    leaves[i]->board.prefs["device_config"]["espnowGateway"] = stale;
+    leaves[i]->board.prefs["device_config"]["espnowChannel"] = "1";
+  }
+
+  NativeHost::selectBoard(&gateway.board);
+  Storage::init();
+  OperationMode::start();
+
+  bool failed = false;
+  unsigned long totalSent = 0;
+
+  auto check = [&](Node& leaf, unsigned long sent, unsigned long receivedBefore, const char* label) {
+    unsigned long received = broker.published["devices/" + leaf.deviceId + "/sensors"] - receivedBefore;
+    bool ok = sent > 0 && received == sent;
+    printf("%-8s %s: sent %lu, relayed %lu, gateway cached %s%s\n", label, leaf.deviceId.c_str(), sent,
+           received, leaf.board.prefs["device_config"].count("espnowGateway") ? "yes" : "no",
+           ok ? "" : "  <-- MISMATCH");
+    if (!ok) failed = true;
+    totalSent += sent;
+  };
+
+  printf("ESP-NOW relay: %zu %s leaves, %lu simulated minutes each\n", leafCount, sensorType, minutes);
+
+  for (auto& leaf : leaves) {
+    unsigned long before = broker.published["devices/" + leaf->deviceId + "/sensors"];
+    check(*leaf, runLeaf(*leaf, gateway, minutes), before, "leaf");
+  }
+
+  // El AP del gateway cambia de canal: la primera hoja debe volver a encontrarlo
+  if (!leaves.empty()) {
+    gateway.board.wifiChannel = MOVED_GATEWAY_CHANNEL;
+    NativeHost::selectBoard(&gateway.board);
+    EspNowGateway::init();
+
+    Node& leaf = *leaves.front();
+    unsigned long before = broker.published["devices/" + leaf.deviceId + "/sensors"];
+    check(leaf, runLeaf(leaf, gateway, minutes), before, "moved");
+  }
+
+  // Intrusos: ninguna lectura suya debe llegar al broker
+  Node* intruders[] = {&unlisted, &wrongKey};
+  const char* labels[] = {"unlisted", "wrongkey"};
+  for (size_t i = 0; i < 2; i++) {
+    Node& intruder = *intruders[i];
+    cacheGateway(intruder, gateway.radio->getChannel());
+    unsigned long undecryptedBefore = gateway.radio->getUndecryptedFrames();
+    unsigned long sent = runLeaf(intruder, gateway, minutes);
+    unsigned long received = broker.published["devices/" + intruder.deviceId + "/sensors"];
+    printf("%-8s %s: sent %lu, relayed %lu, undecryptable at gateway %lu%s\n", labels[i],
+           intruder.deviceId.c_str(), sent, received,
+           gateway.radio->getUndecryptedFrames() - undecryptedBefore, received == 0 ? "" : "  <-- RELAYED");
+    if (received > 0) failed = true;
+  }
+
+  printf("\nRelayed %lu readings in total (gateway count %lu), last payload %s\n", totalSent,
+         EspNowGateway::getRelayedCount(), broker.lastPayload.c_str());
+  printf("%s\n", failed ? "ESPNOW RELAY FAILED" : "ESPNOW RELAY PASSED");
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,94 @@
+// eventLoop.cpp
+// ========================================
+
+#include "eventLoop.h"
+
+#include <NativeHost.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+EventLoop::EventLoop() : epollFd(epoll_create1(EPOLL_CLOEXEC)), running(false), timerSequence(0) {
+  if (epollFd < 0) {
+    perror("epoll_create1");
+  }
+}
+
+EventLoop::~EventLoop() {
+  if (epollFd >= 0) close(epollFd);
+}
+
+bool EventLoop::add(int fd, uint32_t events, Handler* handler) {
+  epoll_event ev = {};
+  ev.events = events;
+  ev.data.ptr = handler;
+  return epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+bool EventLoop::modify(int fd, uint32_t events, Handler* handler) {
+  epoll_event ev = {};
+  ev.events = events;
+  ev.data.ptr = handler;
+  return epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+void EventLoop::remove(int fd) {
+  epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+void EventLoop::schedule(unsigned long long dueMicros, std::function<void()> callback) {
+  timers.push(Timer{dueMicros, timerSequence++, std::move(callback)});
+}
+
+void EventLoop::scheduleIn(unsigned long long delayMicros, std::function<void()> callback) {
+  schedule(nowMicros() + delayMicros, std::move(callback));
+}
+
+unsigned long long EventLoop::nowMicros() const {
+  // Mismo reloj que millis()/micros() del firmware
+  return NativeHost::currentMicros();
+}
+
+void EventLoop::stop() {
+  running = false;
+}
+
+void EventLoop::runDueTimers() {
+  unsigned long long now = nowMicros();
+  while (!timers.empty() && timers.top().dueMicros <= now) {
+    Timer timer = timers.top();
+    timers.pop();
+    timer.callback();
+    if (!running) return;
+  }
+}
+
+void EventLoop::run() {
+  const int MAX_EVENTS = 256;
+  epoll_event events[MAX_EVENTS];
+  running = true;
+
+  while (running) {
+    int timeoutMs = 100;
+    if (!timers.empty()) {
+      unsigned long long now = nowMicros();
+      unsigned long long due = timers.top().dueMicros;
+      timeoutMs = due <= now ? 0 : (int)((due - now + 999) / 1000);
+      if (timeoutMs > 100) timeoutMs = 100;
+    }
+
+    int count = epoll_wait(epollFd, events, MAX_EVENTS, timeoutMs);
+    if (count < 0 && errno != EINTR) {
+      perror("epoll_wait");
+      return;
+    }
+
+    for (int i = 0; i < count && running; i++) {
+      static_cast<Handler*>(events[i].data.ptr)->onEvents(events[i].events);
+    }
+
+    if (running) runDueTimers();
+  }
+}
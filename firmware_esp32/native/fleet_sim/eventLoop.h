@@ -0,0 +1,55 @@
+// eventLoop.h
+// ========================================
+// Bucle de eventos de un solo hilo (epoll + temporizadores) para el simulador.
+
+#ifndef FLEET_SIM_EVENT_LOOP_H
+#define FLEET_SIM_EVENT_LOOP_H
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+class EventLoop {
+public:
+  // Manejador de eventos de un descriptor (EPOLLIN/EPOLLOUT/...)
+  class Handler {
+  public:
+    virtual ~Handler() {}
+    virtual void onEvents(uint32_t events) = 0;
+  };
+
+  EventLoop();
+  ~EventLoop();
+
+  bool add(int fd, uint32_t events, Handler* handler);
+  bool modify(int fd, uint32_t events, Handler* handler);
+  void remove(int fd);
+
+  // Ejecuta callback cuando nowMicros() >= dueMicros
+  void schedule(unsigned long long dueMicros, std::function<void()> callback);
+  void scheduleIn(unsigned long long delayMicros, std::function<void()> callback);
+
+  void run();
+  void stop();
+  unsigned long long nowMicros() const;
+
+private:
+  struct Timer {
+    unsigned long long dueMicros;
+    uint64_t sequence;
+    std::function<void()> callback;
+    bool operator>(const Timer& other) const {
+      return dueMicros != other.dueMicros ? dueMicros > other.dueMicros : sequence > other.sequence;
+    }
+  };
+
+  int epollFd;
+  bool running;
+  uint64_t timerSequence;
+  std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+
+  void runDueTimers();
+};
+
+#endif
@@ -0,0 +1,30 @@
+// fleetOptions.h
+// ========================================
+
+#ifndef FLEET_SIM_FLEET_OPTIONS_H
+#define FLEET_SIM_FLEET_OPTIONS_H
+
+#include <cstdint>
+#include <string>
+
+struct FleetOptions {
+  std::string host = "127.0.0.1";      // mosquitto de docker-compose.yml
+  uint16_t port = 1883;
+  std::string username;                // mosquitto local: "esp32" (mosquitto/config/acl)
+  std::string password;
+  size_t devices = 1000;
+  std::string sensorType = "dht22";
+  unsigned long intervalMs = 60000;    // SENSOR_INTERVAL de config.h
+  unsigned long durationSeconds = 300;
+  unsigned long rampSeconds = 0;       // 0 = repartir el arranque en un intervalo
+  unsigned long connectRate = 200;     // conexiones TCP nuevas por segundo
+  unsigned long reconnectDelayMs = 5000;
+  unsigned long reportSeconds = 5;
+  uint8_t qos = 1;                     // QoS 1 para medir el PUBACK del broker
+  uint16_t keepAliveSeconds = 15;      // MQTT_KEEPALIVE de PubSubClient
+  std::string ingestTopic = "devices/+/ingested";
+  uint32_t idPrefix = 0x5f1ee700;
+  uint32_t seed = 1;
+};
+
+#endif
@@ -0,0 +1,84 @@
+// fleetStats.cpp
+// ========================================
+
+#include "fleetStats.h"
+
+#include <algorithm>
+#include <cstdio>
+
+FleetStats::FleetStats(size_t deviceCount)
+  : deviceCount(deviceCount), connectedDevices(0), totalConnects(0), totalDisconnects(0), skipped(0),
+    startMicros(0), windowStartMicros(0) {}
+
+void FleetStats::recordPublish(bool accepted) {
+  if (accepted) {
+    window.published++;
+    total.published++;
+  } else {
+    window.failed++;
+    total.failed++;
+  }
+}
+
+void FleetStats::recordAck(unsigned long long latencyMicros) {
+  window.ackMicros.push_back((uint32_t)latencyMicros);
+  total.ackMicros.push_back((uint32_t)latencyMicros);
+}
+
+void FleetStats::trackIngest(const std::string& key, unsigned long long sentMicros) {
+  pendingIngest[key] = sentMicros;
+}
+
+void FleetStats::resolveIngest(const std::string& key, unsigned long long nowMicros) {
+  auto it = pendingIngest.find(key);
+  if (it == pendingIngest.end()) return;
+  uint32_t lag = (uint32_t)(nowMicros - it->second);
+  pendingIngest.erase(it);
+  window.ingestMicros.push_back(lag);
+  total.ingestMicros.push_back(lag);
+}
+
+double FleetStats::percentileMs(std::vector<uint32_t>& samples, double percentile) {
+  if (samples.empty()) return 0.0;
+  size_t index = (size_t)(percentile / 100.0 * (samples.size() - 1));
+  std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+  return samples[index] / 1000.0;
+}
+
+void FleetStats::report(unsigned long long nowMicros, size_t inflight) {
+  if (startMicros == 0) startMicros = windowStartMicros = nowMicros;
+  double seconds = (nowMicros - windowStartMicros) / 1e6;
+  double rate = seconds > 0 ? window.published / seconds : 0.0;
+
+  printf("[%5.0fs] connected %zu/%zu | publish %.1f/s (ok %llu, fail %llu) | "
+         "ack p50 %.2fms p95 %.2fms p99 %.2fms | ingest n=%zu p50 %.0fms p95 %.0fms | inflight %zu\n",
+         (nowMicros - startMicros) / 1e6, connectedDevices, deviceCount, rate,
+         (unsigned long long)window.published, (unsigned long long)window.failed,
+         percentileMs(window.ackMicros, 50), percentileMs(window.ackMicros, 95),
+         percentileMs(window.ackMicros, 99), window.ingestMicros.size(),
+         percentileMs(window.ingestMicros, 50), percentileMs(window.ingestMicros, 95), inflight);
+  fflush(stdout);
+
+  window = Window();
+  windowStartMicros = nowMicros;
+}
+
+void FleetStats::printSummary(unsigned long long nowMicros) {
+  double seconds = (nowMicros - startMicros) / 1e6;
+
+  printf("\n=== Fleet simulation summary ===\n");
+  printf("Duration: %.1f s, devices: %zu\n", seconds, deviceCount);
+  printf("Connects: %llu, disconnects: %llu\n", (unsigned long long)totalConnects,
+         (unsigned long long)totalDisconnects);
+  printf("Published: %llu (%.1f msg/s), rejected: %llu, skipped while offline: %llu\n",
+         (unsigned long long)total.published, seconds > 0 ? total.published / seconds : 0.0,
+         (unsigned long long)total.failed, (unsigned long long)skipped);
+  printf("Broker ack latency (n=%zu): p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, p99.9 %.2f ms, max %.2f ms\n",
+         total.ackMicros.size(), percentileMs(total.ackMicros, 50), percentileMs(total.ackMicros, 90),
+         percentileMs(total.ackMicros, 99), percentileMs(total.ackMicros, 99.9),
+         percentileMs(total.ackMicros, 100));
+  printf("Ingestion lag (n=%zu, pending %zu): p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms\n",
+         total.ingestMicros.size(), pendingIngest.size(), percentileMs(total.ingestMicros, 50),
+         percentileMs(total.ingestMicros, 90), percentileMs(total.ingestMicros, 99),
+         percentileMs(total.ingestMicros, 100));
+}
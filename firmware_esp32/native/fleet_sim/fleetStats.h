@@ -0,0 +1,54 @@
+// fleetStats.h
+// ========================================
+// Métricas del simulador: tasa de publicación, latencia de PUBACK del broker
+// y retraso de ingesta reportado por telemetry-service.
+
+#ifndef FLEET_SIM_FLEET_STATS_H
+#define FLEET_SIM_FLEET_STATS_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class FleetStats {
+public:
+  explicit FleetStats(size_t deviceCount);
+
+  void recordConnected() { connectedDevices++; totalConnects++; }
+  void recordDisconnected() { if (connectedDevices > 0) connectedDevices--; totalDisconnects++; }
+  void recordPublish(bool accepted);
+  void recordSkipped() { skipped++; }
+  void recordAck(unsigned long long latencyMicros);
+
+  // Correlación de ingesta: clave = deviceId + timestamp del payload
+  void trackIngest(const std::string& key, unsigned long long sentMicros);
+  void resolveIngest(const std::string& key, unsigned long long nowMicros);
+
+  void report(unsigned long long nowMicros, size_t inflight);
+  void printSummary(unsigned long long nowMicros);
+
+private:
+  struct Window {
+    uint64_t published = 0;
+    uint64_t failed = 0;
+    std::vector<uint32_t> ackMicros;
+    std::vector<uint32_t> ingestMicros;
+  };
+
+  size_t deviceCount;
+  size_t connectedDevices;
+  uint64_t totalConnects;
+  uint64_t totalDisconnects;
+  uint64_t skipped;
+  unsigned long long startMicros;
+  unsigned long long windowStartMicros;
+
+  Window window;
+  Window total;
+  std::unordered_map<std::string, unsigned long long> pendingIngest;
+
+  static double percentileMs(std::vector<uint32_t>& samples, double percentile);
+};
+
+#endif
@@ -0,0 +1,250 @@
+// main.cpp (fleet_sim)
+// ========================================
+// Simulador de flota nativo: miles de ESP32 virtuales en un solo bucle de
+// eventos, cada uno ejecutando Sensor::readAndFormat() y
+// MQTTClient::publishSensorData() del firmware contra un broker real.
+//
+// Uso:
+//   pio run -e native_sim && .pio/build/native_sim/program --devices 2000 --interval 1000
+//
+// Reporta la tasa de publicación, percentiles de latencia de PUBACK y el
+// retraso de ingesta de telemetry-service (requiere MQTT_INGEST_ACK=true).
+
+#include "eventLoop.h"
+#include "fleetOptions.h"
+#include "fleetStats.h"
+#include "mqttSession.h"
+#include "virtualDevice.h"
+
+#include "sensor.h"
+#include "storage.h"
+
+#include <NativeHost.h>
+#include <config.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <netdb.h>
+#include <sys/resource.h>
+#include <vector>
+
+namespace {
+
+void printUsage() {
+  printf("Usage: fleet_sim [options]\n"
+         "  --host <host>           Broker host (default 127.0.0.1)\n"
+         "  --port <port>           Broker port (default 1883)\n"
+         "  --username <user>       MQTT username\n"
+         "  --password <pass>       MQTT password\n"
+         "  --devices <n>           Virtual devices (default 1000)\n"
+         "  --sensor <type>         dht22 | mq4 | pir (default dht22)\n"
+         "  --interval <ms>         Sampling interval per device (default 60000)\n"
+         "  --duration <s>          Test duration (default 300)\n"
+         "  --ramp <s>              Spread first samples over <s> (default one interval)\n"
+         "  --connect-rate <n>      New TCP connections per second (default 200)\n"
+         "  --qos <0|1>             Publish QoS; 1 measures broker ack latency (default 1)\n"
+         "  --keepalive <s>         MQTT keep-alive (default 15)\n"
+         "  --report <s>            Progress report period (default 5)\n"
+         "  --ingest-topic <t>      Ingestion ack topic, 'none' to disable (default devices/+/ingested)\n"
+         "  --seed <n>              Synthetic trace seed (default 1)\n");
+}
+
+bool parseOptions(int argc, char** argv, FleetOptions& options) {
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (strcmp(arg, "--help") == 0) return false;
+    if (i + 1 >= argc) {
+      fprintf(stderr, "Missing value for %s\n", arg);
+      return false;
+    }
+    const char* value = argv[++i];
+
+    if (strcmp(arg, "--host") == 0) options.host = value;
+    else if (strcmp(arg, "--port") == 0) options.port = (uint16_t)atoi(value);
+    else if (strcmp(arg, "--username") == 0) options.username = value;
+    else if (strcmp(arg, "--password") == 0) options.password = value;
+    else if (strcmp(arg, "--devices") == 0) options.devices = strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--sensor") == 0) options.sensorType = value;
+    else if (strcmp(arg, "--interval") == 0) options.intervalMs = strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--duration") == 0) options.durationSeconds = strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--ramp") == 0) options.rampSeconds = strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--connect-rate") == 0) options.connectRate = strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--qos") == 0) options.qos = (uint8_t)(atoi(value) > 0 ? 1 : 0);
+    else if (strcmp(arg, "--keepalive") == 0) options.keepAliveSeconds = (uint16_t)atoi(value);
+    else if (strcmp(arg, "--report") == 0) options.reportSeconds = strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--ingest-topic") == 0) options.ingestTopic = strcmp(value, "none") == 0 ? "" : value;
+    else if (strcmp(arg, "--seed") == 0) options.seed = (uint32_t)strtoul(value, nullptr, 10);
+    else {
+      fprintf(stderr, "Unknown option: %s\n", arg);
+      return false;
+    }
+  }
+
+  if (options.sensorType != "dht22" && options.sensorType != "mq4" && options.sensorType != "pir") {
+    fprintf(stderr, "Invalid sensor type: %s\n", options.sensorType.c_str());
+    return false;
+  }
+  if (options.devices == 0 || options.intervalMs == 0 || options.connectRate == 0 ||
+      options.reportSeconds == 0 || options.keepAliveSeconds == 0) {
+    fprintf(stderr, "devices, interval, connect-rate, report and keepalive must be > 0\n");
+    return false;
+  }
+  return true;
+}
+
+bool resolveBroker(const FleetOptions& options, BrokerEndpoint& endpoint) {
+  addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* result = nullptr;
+
+  std::string port = std::to_string(options.port);
+  int rc = getaddrinfo(options.host.c_str(), port.c_str(), &hints, &result);
+  if (rc != 0 || !result) {
+    fprintf(stderr, "Cannot resolve %s: %s\n", options.host.c_str(), gai_strerror(rc));
+    return false;
+  }
+  memcpy(&endpoint.address, result->ai_addr, result->ai_addrlen);
+  endpoint.addressLength = result->ai_addrlen;
+  freeaddrinfo(result);
+  return true;
+}
+
+void raiseFileLimit(size_t needed) {
+  rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) != 0) return;
+  if (limit.rlim_cur < needed + 64) {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+  if (limit.rlim_cur < needed + 64) {
+    fprintf(stderr, "Warning: file descriptor limit %llu is below %zu devices\n",
+            (unsigned long long)limit.rlim_cur, needed);
+  }
+}
+
+// Suscriptor de los acuses de ingesta publicados por telemetry-service
+class IngestMonitor : public MqttSession::Listener {
+public:
+  IngestMonitor(FleetStats& stats, EventLoop& loop, const std::string& topic)
+    : stats(stats), loop(loop), topic(topic) {}
+
+  void onSessionConnected(MqttSession& session) override { session.subscribe(topic.c_str()); }
+
+  void onMessage(MqttSession& session, const std::string& messageTopic, const std::string& payload) override {
+    (void)session;
+    // devices/{deviceId}/ingested
+    size_t first = messageTopic.find('/');
+    size_t second = messageTopic.find('/', first + 1);
+    if (first == std::string::npos || second == std::string::npos) return;
+    std::string deviceId = messageTopic.substr(first + 1, second - first - 1);
+
+    const std::string marker = "\"timestamp\":\"";
+    size_t start = payload.find(marker);
+    if (start == std::string::npos) return;
+    start += marker.size();
+    size_t end = payload.find('"', start);
+    if (end == std::string::npos) return;
+
+    stats.resolveIngest(deviceId + "|" + payload.substr(start, end - start), loop.nowMicros());
+  }
+
+private:
+  FleetStats& stats;
+  EventLoop& loop;
+  std::string topic;
+};
+
+void ignoreRestart() {
+  // Un ESP.restart() en una placa virtual no debe terminar el simulador
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  FleetOptions options;
+  if (!parseOptions(argc, argv, options)) {
+    printUsage();
+    return 1;
+  }
+
+  BrokerEndpoint broker;
+  if (!resolveBroker(options, broker)) return 1;
+  raiseFileLimit(options.devices + 1);
+
+  NativeHost::setRestartHandler(ignoreRestart);
+  NativeHost::setSerialEnabled(false);
+
+  EventLoop loop;
+  FleetStats stats(options.devices);
+
+  std::vector<std::unique_ptr<VirtualDevice>> devices;
+  devices.reserve(options.devices);
+  for (size_t i = 0; i < options.devices; i++) {
+    devices.emplace_back(new VirtualDevice(loop, broker, options, stats, i));
+  }
+
+  // Inicialización del firmware una sola vez: Storage y Sensor son estáticos
+  // y todas las placas comparten el tipo de sensor
+  NativeHost::selectBoard(nullptr);
+  NativeHost::board().prefs["device_config"]["sensorType"] = options.sensorType;
+  Storage::init();
+  Sensor::init();
+  if (options.sensorType == "pir") {
+    // Saltar la estabilización de PIR_STABILIZATION_TIME
+    NativeHost::advanceMillis(PIR_STABILIZATION_TIME);
+    Sensor::isPIRStabilized();
+  }
+
+  std::unique_ptr<IngestMonitor> monitor;
+  std::unique_ptr<MqttSession> monitorSession;
+  if (!options.ingestTopic.empty()) {
+    monitor.reset(new IngestMonitor(stats, loop, options.ingestTopic));
+    monitorSession.reset(new MqttSession(loop, broker, 0, options.keepAliveSeconds, monitor.get()));
+    monitorSession->connect("fleet_sim_ingest_monitor", options.username.c_str(), options.password.c_str());
+  }
+
+  printf("Fleet simulator: %zu %s devices -> %s:%u, interval %lu ms, QoS %u, duration %lu s\n",
+         options.devices, options.sensorType.c_str(), options.host.c_str(), options.port, options.intervalMs,
+         options.qos, options.durationSeconds);
+  if (options.qos == 0) {
+    printf("QoS 0 matches the firmware but disables broker ack latency measurement\n");
+  }
+
+  // Arranque escalonado: conexiones limitadas por connectRate, primeras muestras
+  // repartidas en la rampa para no sincronizar a toda la flota
+  unsigned long long rampMicros = (options.rampSeconds > 0 ? options.rampSeconds * 1000ULL
+                                                           : options.intervalMs) * 1000ULL;
+  unsigned long long connectSpacing = 1000000ULL / options.connectRate;
+  for (size_t i = 0; i < devices.size(); i++) {
+    VirtualDevice* device = devices[i].get();
+    unsigned long long connectAt = i * connectSpacing;
+    unsigned long long sampleOffset = rampMicros * i / devices.size();
+    loop.scheduleIn(connectAt, [device, sampleOffset]() { device->start(sampleOffset); });
+  }
+
+  std::function<void()> report;
+  report = [&]() {
+    size_t inflight = 0;
+    for (auto& device : devices) inflight += device->inflight();
+    stats.report(loop.nowMicros(), inflight);
+    loop.scheduleIn(options.reportSeconds * 1000000ULL, report);
+  };
+  stats.report(loop.nowMicros(), 0);
+  loop.scheduleIn(options.reportSeconds * 1000000ULL, report);
+
+  std::function<void()> monitorKeepAlive;
+  monitorKeepAlive = [&]() {
+    if (monitorSession) monitorSession->loop();
+    loop.scheduleIn(options.keepAliveSeconds * 500000ULL, monitorKeepAlive);
+  };
+  loop.scheduleIn(options.keepAliveSeconds * 500000ULL, monitorKeepAlive);
+
+  loop.scheduleIn(options.durationSeconds * 1000000ULL, [&loop]() { loop.stop(); });
+  loop.run();
+
+  stats.printSummary(loop.nowMicros());
+  return 0;
+}
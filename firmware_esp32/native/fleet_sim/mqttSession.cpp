@@ -0,0 +1,314 @@
+// mqttSession.cpp
+// ========================================
+
+#include "mqttSession.h"
+
+#include <PubSubClient.h>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+MqttSession::MqttSession(EventLoop& loop, const BrokerEndpoint& broker, uint8_t qos,
+                         uint16_t keepAliveSeconds, Listener* listener)
+  : loopRef(loop), broker(broker), qos(qos), keepAliveSeconds(keepAliveSeconds), listener(listener),
+    fd(-1), sessionState(IDLE), lastConnackCode(0), nextPacketId(1), lastSendMicros(0),
+    pingOutstanding(false) {}
+
+MqttSession::~MqttSession() {
+  if (fd >= 0) {
+    loopRef.remove(fd);
+    ::close(fd);
+  }
+}
+
+bool MqttSession::connect(const char* id, const char* user, const char* pass) {
+  if (sessionState == CONNECTED) return true;
+  if (sessionState == TCP_CONNECTING || sessionState == WAIT_CONNACK) return false;
+
+  clientId = id ? id : "";
+  username = user ? user : "";
+  password = pass ? pass : "";
+  openSocket();
+  return false;
+}
+
+int MqttSession::state() {
+  switch (sessionState) {
+    case CONNECTED: return MQTT_CONNECTED;
+    case CLOSED: return lastConnackCode > 0 ? lastConnackCode : MQTT_CONNECTION_LOST;
+    case TCP_CONNECTING:
+    case WAIT_CONNACK: return MQTT_CONNECTION_TIMEOUT;
+    default: return MQTT_DISCONNECTED;
+  }
+}
+
+void MqttSession::openSocket() {
+  fd = socket(broker.address.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    sessionState = CLOSED;
+    if (listener) listener->onSessionClosed(*this);
+    return;
+  }
+
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  int rc = ::connect(fd, (const sockaddr*)&broker.address, broker.addressLength);
+  if (rc < 0 && errno != EINPROGRESS) {
+    ::close(fd);
+    fd = -1;
+    sessionState = CLOSED;
+    if (listener) listener->onSessionClosed(*this);
+    return;
+  }
+
+  sessionState = TCP_CONNECTING;
+  outbound.clear();
+  inbound.clear();
+  pendingAcks.clear();
+  pingOutstanding = false;
+  loopRef.add(fd, EPOLLOUT | EPOLLIN, this);
+}
+
+void MqttSession::close() {
+  if (fd >= 0) {
+    loopRef.remove(fd);
+    ::close(fd);
+    fd = -1;
+  }
+  bool wasOpen = sessionState != CLOSED && sessionState != IDLE;
+  sessionState = CLOSED;
+  if (wasOpen && listener) listener->onSessionClosed(*this);
+}
+
+void MqttSession::appendRemainingLength(std::string& out, size_t length) {
+  do {
+    uint8_t encoded = length % 128;
+    length /= 128;
+    if (length > 0) encoded |= 0x80;
+    out.push_back((char)encoded);
+  } while (length > 0);
+}
+
+void MqttSession::appendString(std::string& out, const char* str, size_t length) {
+  out.push_back((char)(length >> 8));
+  out.push_back((char)(length & 0xFF));
+  out.append(str, length);
+}
+
+void MqttSession::queue(const std::string& packet) {
+  outbound += packet;
+  lastSendMicros = loopRef.nowMicros();
+  flush();
+}
+
+void MqttSession::flush() {
+  while (!outbound.empty() && fd >= 0) {
+    ssize_t sent = send(fd, outbound.data(), outbound.size(), MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+      close();
+      return;
+    }
+    outbound.erase(0, (size_t)sent);
+  }
+  updateInterest();
+}
+
+void MqttSession::updateInterest() {
+  if (fd < 0) return;
+  uint32_t events = EPOLLIN;
+  if (!outbound.empty() || sessionState == TCP_CONNECTING) events |= EPOLLOUT;
+  loopRef.modify(fd, events, this);
+}
+
+void MqttSession::onEvents(uint32_t events) {
+  if (sessionState == TCP_CONNECTING && (events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+    int error = 0;
+    socklen_t len = sizeof(error);
+    getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len);
+    if (error != 0) {
+      close();
+      return;
+    }
+
+    // CONNECT: clean session, usuario/contraseña opcionales
+    std::string body;
+    appendString(body, "MQTT", 4);
+    body.push_back(4);  // MQTT 3.1.1
+    uint8_t flags = 0x02;
+    if (!username.empty()) flags |= 0x80;
+    if (!password.empty()) flags |= 0x40;
+    body.push_back((char)flags);
+    body.push_back((char)(keepAliveSeconds >> 8));
+    body.push_back((char)(keepAliveSeconds & 0xFF));
+    appendString(body, clientId.c_str(), clientId.size());
+    if (!username.empty()) appendString(body, username.c_str(), username.size());
+    if (!password.empty()) appendString(body, password.c_str(), password.size());
+
+    std::string packet(1, (char)0x10);
+    appendRemainingLength(packet, body.size());
+    packet += body;
+
+    sessionState = WAIT_CONNACK;
+    queue(packet);
+    return;
+  }
+
+  if (events & (EPOLLERR | EPOLLHUP)) {
+    close();
+    return;
+  }
+  if (events & EPOLLIN) readAvailable();
+  if (fd >= 0 && (events & EPOLLOUT)) flush();
+}
+
+void MqttSession::readAvailable() {
+  char chunk[4096];
+  while (fd >= 0) {
+    ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+    if (received == 0) {
+      close();
+      return;
+    }
+    if (received < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+      close();
+      return;
+    }
+    inbound.append(chunk, (size_t)received);
+  }
+
+  // Extraer paquetes completos
+  size_t offset = 0;
+  while (inbound.size() - offset >= 2) {
+    size_t remaining = 0;
+    size_t multiplier = 1;
+    size_t pos = offset + 1;
+    bool complete = false;
+    while (pos < inbound.size() && pos - offset <= 4) {
+      uint8_t encoded = (uint8_t)inbound[pos++];
+      remaining += (encoded & 0x7F) * multiplier;
+      multiplier *= 128;
+      if ((encoded & 0x80) == 0) {
+        complete = true;
+        break;
+      }
+    }
+    if (!complete || inbound.size() - pos < remaining) break;
+
+    handlePacket((uint8_t)inbound[offset], inbound.substr(pos, remaining));
+    if (fd < 0) return;
+    offset = pos + remaining;
+  }
+  inbound.erase(0, offset);
+}
+
+void MqttSession::handlePacket(uint8_t header, const std::string& body) {
+  uint8_t type = header >> 4;
+
+  if (type == 2) {  // CONNACK
+    lastConnackCode = body.size() >= 2 ? (uint8_t)body[1] : 255;
+    if (lastConnackCode != 0) {
+      close();
+      return;
+    }
+    sessionState = CONNECTED;
+    if (listener) listener->onSessionConnected(*this);
+
+  } else if (type == 4 && body.size() >= 2) {  // PUBACK
+    uint16_t packetId = (uint16_t)(((uint8_t)body[0] << 8) | (uint8_t)body[1]);
+    auto it = pendingAcks.find(packetId);
+    if (it != pendingAcks.end()) {
+      unsigned long long latency = loopRef.nowMicros() - it->second;
+      pendingAcks.erase(it);
+      if (listener) listener->onPublishAcked(*this, latency);
+    }
+
+  } else if (type == 3 && body.size() >= 2) {  // PUBLISH entrante (suscripciones QoS 0)
+    size_t topicLength = ((uint8_t)body[0] << 8) | (uint8_t)body[1];
+    if (body.size() < 2 + topicLength) return;
+    size_t payloadStart = 2 + topicLength;
+    if ((header >> 1) & 0x03) payloadStart += 2;
+    if (payloadStart > body.size()) return;
+    if (listener) {
+      listener->onMessage(*this, body.substr(2, topicLength), body.substr(payloadStart));
+    }
+
+  } else if (type == 13) {  // PINGRESP
+    pingOutstanding = false;
+  }
+}
+
+bool MqttSession::publish(const char* topic, const uint8_t* payload, size_t length, bool retained) {
+  if (sessionState != CONNECTED) return false;
+  if (outbound.size() > MAX_OUTBOUND_BYTES) {
+    // Contrapresión: el broker no está drenando el socket
+    if (listener) listener->onPublishRejected(*this);
+    return false;
+  }
+
+  size_t topicLength = strlen(topic);
+  std::string body;
+  appendString(body, topic, topicLength);
+
+  uint16_t packetId = 0;
+  if (qos > 0) {
+    packetId = nextPacketId++;
+    if (nextPacketId == 0) nextPacketId = 1;
+    body.push_back((char)(packetId >> 8));
+    body.push_back((char)(packetId & 0xFF));
+  }
+  body.append((const char*)payload, length);
+
+  std::string packet(1, (char)(0x30 | (qos << 1) | (retained ? 1 : 0)));
+  appendRemainingLength(packet, body.size());
+  packet += body;
+
+  unsigned long long now = loopRef.nowMicros();
+  if (qos > 0) pendingAcks[packetId] = now;
+  queue(packet);
+  if (fd < 0) return false;
+
+  if (listener) {
+    listener->onPublishSent(*this, topic, std::string((const char*)payload, length), now);
+  }
+  return true;
+}
+
+bool MqttSession::subscribe(const char* filter) {
+  if (sessionState != CONNECTED) return false;
+
+  std::string body;
+  uint16_t packetId = nextPacketId++;
+  body.push_back((char)(packetId >> 8));
+  body.push_back((char)(packetId & 0xFF));
+  appendString(body, filter, strlen(filter));
+  body.push_back(0);  // QoS 0
+
+  std::string packet(1, (char)0x82);
+  appendRemainingLength(packet, body.size());
+  packet += body;
+  queue(packet);
+  return true;
+}
+
+void MqttSession::loop() {
+  if (sessionState != CONNECTED) return;
+
+  // Keep-alive como PubSubClient: PINGREQ si no se ha enviado nada en keepAlive
+  unsigned long long idle = loopRef.nowMicros() - lastSendMicros;
+  if (idle >= (unsigned long long)keepAliveSeconds * 1000000ULL) {
+    if (pingOutstanding) {
+      close();
+      return;
+    }
+    pingOutstanding = true;
+    queue(std::string("\xC0\x00", 2));
+  }
+}
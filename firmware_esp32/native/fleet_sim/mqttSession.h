@@ -0,0 +1,99 @@
+// mqttSession.h
+// ========================================
+// Sesión MQTT 3.1.1 no bloqueante sobre el EventLoop.
+// Implementa NativeHost::MqttTransport para que el PubSubClient nativo
+// (y por tanto MQTTClient del firmware) publique por un socket real.
+
+#ifndef FLEET_SIM_MQTT_SESSION_H
+#define FLEET_SIM_MQTT_SESSION_H
+
+#include "eventLoop.h"
+
+#include <NativeHost.h>
+
+#include <map>
+#include <string>
+#include <sys/socket.h>
+
+struct BrokerEndpoint {
+  sockaddr_storage address;
+  socklen_t addressLength;
+};
+
+class MqttSession : public EventLoop::Handler, public NativeHost::MqttTransport {
+public:
+  class Listener {
+  public:
+    virtual ~Listener() {}
+    virtual void onSessionConnected(MqttSession& session) { (void)session; }
+    virtual void onSessionClosed(MqttSession& session) { (void)session; }
+    virtual void onPublishSent(MqttSession& session, const char* topic, const std::string& payload,
+                               unsigned long long sentMicros) {
+      (void)session; (void)topic; (void)payload; (void)sentMicros;
+    }
+    virtual void onPublishRejected(MqttSession& session) { (void)session; }
+    virtual void onPublishAcked(MqttSession& session, unsigned long long latencyMicros) {
+      (void)session; (void)latencyMicros;
+    }
+    virtual void onMessage(MqttSession& session, const std::string& topic, const std::string& payload) {
+      (void)session; (void)topic; (void)payload;
+    }
+  };
+
+  enum State { IDLE, TCP_CONNECTING, WAIT_CONNACK, CONNECTED, CLOSED };
+
+  MqttSession(EventLoop& loop, const BrokerEndpoint& broker, uint8_t qos, uint16_t keepAliveSeconds,
+              Listener* listener);
+  ~MqttSession() override;
+
+  State getState() const { return sessionState; }
+  size_t inflight() const { return pendingAcks.size(); }
+
+  // NativeHost::MqttTransport
+  bool connect(const char* clientId, const char* username, const char* password) override;
+  bool connected() override { return sessionState == CONNECTED; }
+  bool subscribe(const char* filter) override;
+  bool publish(const char* topic, const uint8_t* payload, size_t length, bool retained) override;
+  void loop() override;
+  int state() override;
+
+  // EventLoop::Handler
+  void onEvents(uint32_t events) override;
+
+private:
+  static const size_t MAX_OUTBOUND_BYTES = 64 * 1024;
+
+  EventLoop& loopRef;
+  BrokerEndpoint broker;
+  uint8_t qos;
+  uint16_t keepAliveSeconds;
+  Listener* listener;
+
+  int fd;
+  State sessionState;
+  int lastConnackCode;
+  uint16_t nextPacketId;
+  unsigned long long lastSendMicros;
+  bool pingOutstanding;
+
+  std::string clientId;
+  std::string username;
+  std::string password;
+
+  std::string outbound;
+  std::string inbound;
+  std::map<uint16_t, unsigned long long> pendingAcks;
+
+  void openSocket();
+  void close();
+  void queue(const std::string& packet);
+  void flush();
+  void updateInterest();
+  void readAvailable();
+  void handlePacket(uint8_t header, const std::string& body);
+
+  static void appendRemainingLength(std::string& out, size_t length);
+  static void appendString(std::string& out, const char* str, size_t length);
+};
+
+#endif
@@ -0,0 +1,47 @@
+// syntheticTrace.cpp
+// ========================================
+
+#include "syntheticTrace.h"
+
+#include "config.h"
+
+#include <cmath>
+
+SyntheticTrace::SyntheticTrace(const std::string& sensorType, uint32_t seed)
+  : sensorType(sensorType), rng(seed), drift(0.0), leakSamplesLeft(0) {
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  phase = unit(rng) * 2.0 * M_PI;
+  temperatureBase = 20.0 + unit(rng) * 4.0;
+  humidityBase = 40.0 + unit(rng) * 15.0;
+  gasBaseline = 60 + (int)(unit(rng) * 100);  // 15-39 ppm: aire limpio, lejos del umbral de 50
+  motionProbability = 0.1 + unit(rng) * 0.5;
+}
+
+void SyntheticTrace::apply(NativeHost::Board& board, uint32_t epochSeconds) {
+  std::normal_distribution<double> noise(0.0, 1.0);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  double day = 2.0 * M_PI * (epochSeconds % 86400) / 86400.0;
+
+  if (sensorType == "dht22") {
+    // Ciclo diario + deriva lenta + ruido del sensor
+    drift = drift * 0.98 + noise(rng) * 0.05;
+    board.dhtTemperature = (float)(temperatureBase + 1.5 * sin(day + phase) + drift + noise(rng) * 0.1);
+    board.dhtHumidity = (float)(humidityBase - 6.0 * sin(day + phase) + noise(rng) * 0.5);
+    board.dhtFailure = unit(rng) < 0.002;  // lecturas NaN ocasionales del DHT22
+
+  } else if (sensorType == "mq4") {
+    // Línea base con ruido y fugas esporádicas de varias muestras
+    if (leakSamplesLeft == 0 && unit(rng) < 0.005) {
+      leakSamplesLeft = 3 + (int)(unit(rng) * 10);
+    }
+    int raw = gasBaseline + (int)(noise(rng) * 15);
+    if (leakSamplesLeft > 0) {
+      raw += 1500 + (int)(unit(rng) * 1500);
+      leakSamplesLeft--;
+    }
+    board.analog[MQ4_PIN] = raw < 0 ? 0 : (raw > 4095 ? 4095 : raw);
+
+  } else if (sensorType == "pir") {
+    board.digital[PIR_PIN] = unit(rng) < motionProbability ? 1 : 0;
+  }
+}
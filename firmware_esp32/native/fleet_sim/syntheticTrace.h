@@ -0,0 +1,33 @@
+// syntheticTrace.h
+// ========================================
+// Trazas sintéticas de sensores: escriben en los pines / DHT de una placa
+// virtual los valores que el firmware leerá en la siguiente muestra.
+
+#ifndef FLEET_SIM_SYNTHETIC_TRACE_H
+#define FLEET_SIM_SYNTHETIC_TRACE_H
+
+#include <NativeHost.h>
+
+#include <random>
+#include <string>
+
+class SyntheticTrace {
+public:
+  SyntheticTrace(const std::string& sensorType, uint32_t seed);
+
+  // Aplica la muestra para el instante epochSeconds sobre la placa
+  void apply(NativeHost::Board& board, uint32_t epochSeconds);
+
+private:
+  std::string sensorType;
+  std::mt19937 rng;
+  double phase;
+  double temperatureBase;
+  double humidityBase;
+  double drift;
+  int gasBaseline;
+  int leakSamplesLeft;
+  double motionProbability;
+};
+
+#endif
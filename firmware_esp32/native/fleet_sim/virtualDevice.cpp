@@ -0,0 +1,110 @@
+// virtualDevice.cpp
+// ========================================
+
+#include "virtualDevice.h"
+#include "fleetOptions.h"
+
+#include "mqttClient.h"
+#include "sensor.h"
+
+#include <cstdio>
+
+VirtualDevice::VirtualDevice(EventLoop& loop, const BrokerEndpoint& broker, const FleetOptions& options,
+                             FleetStats& stats, size_t index)
+  : loop(loop), options(options), stats(stats),
+    session(loop, broker, options.qos, options.keepAliveSeconds, this),
+    trace(options.sensorType, options.seed + (uint32_t)index), wasConnected(false) {
+  // ObjectId sintético de 24 caracteres hex (telemetry-service lo exige)
+  char id[25];
+  snprintf(id, sizeof(id), "%08x%016zx", options.idPrefix, index);
+  deviceId = id;
+
+  // Configuración "aprovisionada" en la flash virtual (misma forma que Storage::saveConfig)
+  auto& prefs = board.prefs["device_config"];
+  prefs["ssid"] = "fleet-sim";
+  prefs["password"] = "fleet-sim";
+  prefs["deviceId"] = deviceId;
+  prefs["sensorType"] = options.sensorType;
+
+  board.efuseMac = 0x24d7eb000000ULL + index;
+  board.mqtt = &session;
+}
+
+void VirtualDevice::start(unsigned long long firstSampleDelayMicros) {
+  connectSession();
+  loop.scheduleIn(firstSampleDelayMicros, [this]() { sample(); });
+  loop.scheduleIn((unsigned long long)options.keepAliveSeconds * 500000ULL, [this]() { serviceKeepAlive(); });
+}
+
+void VirtualDevice::connectSession() {
+  std::string clientId = "ESP32_" + deviceId;
+  session.connect(clientId.c_str(), options.username.c_str(), options.password.c_str());
+}
+
+void VirtualDevice::sample() {
+  loop.scheduleIn((unsigned long long)options.intervalMs * 1000ULL, [this]() { sample(); });
+
+  if (!session.connected()) {
+    // MQTTClient::publishSensorData() reintentaría de forma bloqueante; aquí se contabiliza
+    stats.recordSkipped();
+    return;
+  }
+
+  trace.apply(board, NativeHost::currentEpoch());
+  NativeHost::selectBoard(&board);
+
+  // Recarga deviceId/topic de la placa activa (las clases del firmware son estáticas)
+  MQTTClient::init();
+  Sensor::checkPIRContinuously();
+
+  char jsonPayload[Sensor::PAYLOAD_BUFFER_SIZE];
+  if (Sensor::readAndFormat(jsonPayload, sizeof(jsonPayload)) > 0) {
+    MQTTClient::publishSensorData(jsonPayload);
+  }
+}
+
+void VirtualDevice::serviceKeepAlive() {
+  loop.scheduleIn((unsigned long long)options.keepAliveSeconds * 500000ULL, [this]() { serviceKeepAlive(); });
+  NativeHost::selectBoard(&board);
+  MQTTClient::loop();
+}
+
+void VirtualDevice::onSessionConnected(MqttSession& session) {
+  (void)session;
+  wasConnected = true;
+  stats.recordConnected();
+}
+
+void VirtualDevice::onSessionClosed(MqttSession& session) {
+  (void)session;
+  if (wasConnected) stats.recordDisconnected();
+  wasConnected = false;
+  loop.scheduleIn((unsigned long long)options.reconnectDelayMs * 1000ULL, [this]() { connectSession(); });
+}
+
+void VirtualDevice::onPublishSent(MqttSession& session, const char* topic, const std::string& payload,
+                                  unsigned long long sentMicros) {
+  (void)session;
+  (void)topic;
+  stats.recordPublish(true);
+
+  // Clave de correlación con el acuse de ingesta: deviceId + primer timestamp del payload
+  if (options.ingestTopic.empty()) return;
+  const std::string marker = "\"timestamp\":\"";
+  size_t start = payload.find(marker);
+  if (start == std::string::npos) return;
+  start += marker.size();
+  size_t end = payload.find('"', start);
+  if (end == std::string::npos) return;
+  stats.trackIngest(deviceId + "|" + payload.substr(start, end - start), sentMicros);
+}
+
+void VirtualDevice::onPublishRejected(MqttSession& session) {
+  (void)session;
+  stats.recordPublish(false);
+}
+
+void VirtualDevice::onPublishAcked(MqttSession& session, unsigned long long latencyMicros) {
+  (void)session;
+  stats.recordAck(latencyMicros);
+}
@@ -0,0 +1,52 @@
+// virtualDevice.h
+// ========================================
+// ESP32 virtual: placa nativa + sesión MQTT + traza sintética.
+// Cada muestra ejecuta el mismo camino que OperationMode::readAndPublishSensor().
+
+#ifndef FLEET_SIM_VIRTUAL_DEVICE_H
+#define FLEET_SIM_VIRTUAL_DEVICE_H
+
+#include "fleetStats.h"
+#include "mqttSession.h"
+#include "syntheticTrace.h"
+
+#include <NativeHost.h>
+
+#include <string>
+
+struct FleetOptions;
+
+class VirtualDevice : public MqttSession::Listener {
+public:
+  VirtualDevice(EventLoop& loop, const BrokerEndpoint& broker, const FleetOptions& options,
+                FleetStats& stats, size_t index);
+
+  const std::string& getDeviceId() const { return deviceId; }
+  size_t inflight() const { return session.inflight(); }
+
+  void start(unsigned long long firstSampleDelayMicros);
+
+  // MqttSession::Listener
+  void onSessionConnected(MqttSession& session) override;
+  void onSessionClosed(MqttSession& session) override;
+  void onPublishSent(MqttSession& session, const char* topic, const std::string& payload,
+                     unsigned long long sentMicros) override;
+  void onPublishRejected(MqttSession& session) override;
+  void onPublishAcked(MqttSession& session, unsigned long long latencyMicros) override;
+
+private:
+  EventLoop& loop;
+  const FleetOptions& options;
+  FleetStats& stats;
+  std::string deviceId;
+  NativeHost::Board board;
+  MqttSession session;
+  SyntheticTrace trace;
+  bool wasConnected;
+
+  void connectSession();
+  void sample();
+  void serviceKeepAlive();
+};
+
+#endif
@@ -0,0 +1,413 @@
+// main.cpp (mqtt5_test)
+// ========================================
+// Pruebas de Mqtt5Client (src/mqtt5Client.cpp) contra un broker guionizado: el
+// SocketTransport de la placa recibe los paquetes del cliente y responde con
+// bytes MQTT fijos. Los demás entornos nativos usan el shim de PubSubClient, así
+// que este es el único que ejecuta el cliente real. Sale con 1 si algo falla.
+//
+// Uso:
+//   pio run -e native_mqtt5_test && .pio/build/native_mqtt5_test/program
+
+#include "mqtt5Client.h"
+
+#include <NativeHost.h>
+
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::vector<uint8_t> Bytes;
+
+// Broker guionizado: a cada CONNECT responde con el siguiente CONNACK de la cola
+class ScriptedBroker : public NativeHost::SocketTransport {
+public:
+  std::deque<Bytes> connacks;
+  Bytes sent;
+  std::deque<uint8_t> pending;
+  bool open = false;
+  int connects = 0;
+
+  bool connect(const char* host, uint16_t port) override {
+    (void)host; (void)port;
+    connects++;
+    open = true;
+    sent.clear();
+    pending.clear();
+    return true;
+  }
+  bool connected() override { return open; }
+  size_t write(const uint8_t* buffer, size_t size) override {
+    if (!open) return 0;
+    if (size > 0 && buffer[0] == 0x10 && !connacks.empty()) {
+      push(connacks.front());
+      connacks.pop_front();
+    }
+    sent.insert(sent.end(), buffer, buffer + size);
+    return size;
+  }
+  int available() override { return (int)pending.size(); }
+  int read(uint8_t* buffer, size_t size) override {
+    size_t count = 0;
+    while (count < size && !pending.empty()) {
+      buffer[count++] = pending.front();
+      pending.pop_front();
+    }
+    return count > 0 ? (int)count : -1;
+  }
+  void stop() override { open = false; }
+
+  void push(const Bytes& bytes) { pending.insert(pending.end(), bytes.begin(), bytes.end()); }
+};
+
+struct Packet {
+  uint8_t header;
+  Bytes body;
+};
+
+// PUBLISH enviado por el cliente (v5: alias y propiedades decodificadas)
+struct Publish {
+  std::string topic;
+  int alias = 0;
+  bool hasExpiry = false;
+  std::string contentType;
+  std::string payload;
+};
+
+int failures = 0;
+std::string lastTopic;
+std::string lastPayload;
+int callbackCount = 0;
+
+void check(bool condition, const char* test, const char* what) {
+  if (!condition) {
+    printf("  FAIL %s: %s\n", test, what);
+    failures++;
+  }
+}
+
+void onMessage(char* topic, uint8_t* payload, unsigned int length) {
+  lastTopic = topic;
+  lastPayload.assign((const char*)payload, length);
+  callbackCount++;
+}
+
+void appendVarInt(Bytes& out, size_t value) {
+  do {
+    uint8_t digit = value % 128;
+    value /= 128;
+    out.push_back(value > 0 ? (digit | 0x80) : digit);
+  } while (value > 0);
+}
+
+void appendString(Bytes& out, const std::string& value) {
+  out.push_back((uint8_t)(value.size() >> 8));
+  out.push_back((uint8_t)(value.size() & 0xFF));
+  out.insert(out.end(), value.begin(), value.end());
+}
+
+Bytes packet(uint8_t header, const Bytes& body) {
+  Bytes out = {header};
+  appendVarInt(out, body.size());
+  out.insert(out.end(), body.begin(), body.end());
+  return out;
+}
+
+// CONNACK v5: flags, reason code y bloque de propiedades ya codificado
+Bytes connackV5(uint8_t reason, const Bytes& properties) {
+  Bytes body = {0x00, reason};
+  appendVarInt(body, properties.size());
+  body.insert(body.end(), properties.begin(), properties.end());
+  return packet(0x20, body);
+}
+
+Bytes connackV311(uint8_t returnCode) { return packet(0x20, {0x00, returnCode}); }
+
+// PUBLISH del broker al cliente (QoS 0)
+Bytes inboundPublish(const std::string& topic, const Bytes& properties, const std::string& payload) {
+  Bytes body;
+  appendString(body, topic);
+  appendVarInt(body, properties.size());
+  body.insert(body.end(), properties.begin(), properties.end());
+  body.insert(body.end(), payload.begin(), payload.end());
+  return packet(0x30, body);
+}
+
+std::vector<Packet> takePackets(ScriptedBroker& broker) {
+  std::vector<Packet> packets;
+  size_t pos = 0;
+  while (pos < broker.sent.size()) {
+    Packet p;
+    p.header = broker.sent[pos++];
+    size_t length = 0;
+    size_t multiplier = 1;
+    uint8_t digit;
+    do {
+      digit = broker.sent[pos++];
+      length += (digit & 0x7F) * multiplier;
+      multiplier *= 128;
+    } while (digit & 0x80);
+    p.body.assign(broker.sent.begin() + pos, broker.sent.begin() + pos + length);
+    pos += length;
+    packets.push_back(p);
+  }
+  broker.sent.clear();
+  return packets;
+}
+
+uint8_t connectProtocolLevel(const Packet& connect) {
+  // "MQTT" como string (6 bytes) y después el nivel de protocolo
+  return connect.body.size() > 6 ? connect.body[6] : 0;
+}
+
+Publish decodePublish(const Packet& p, bool v5) {
+  Publish result;
+  size_t topicLength = (p.body[0] << 8) | p.body[1];
+  result.topic.assign((const char*)&p.body[2], topicLength);
+  size_t pos = 2 + topicLength;
+  if (v5) {
+    size_t propertiesLength = 0;
+    size_t multiplier = 1;
+    uint8_t digit;
+    do {
+      digit = p.body[pos++];
+      propertiesLength += (digit & 0x7F) * multiplier;
+      multiplier *= 128;
+    } while (digit & 0x80);
+    size_t end = pos + propertiesLength;
+    while (pos < end) {
+      uint8_t id = p.body[pos++];
+      if (id == 0x02) {
+        result.hasExpiry = true;
+        pos += 4;
+      } else if (id == 0x23) {
+        result.alias = (p.body[pos] << 8) | p.body[pos + 1];
+        pos += 2;
+      } else if (id == 0x03) {
+        size_t length = (p.body[pos] << 8) | p.body[pos + 1];
+        result.contentType.assign((const char*)&p.body[pos + 2], length);
+        pos += 2 + length;
+      } else {
+        break;
+      }
+    }
+    pos = end;
+  }
+  result.payload.assign(p.body.begin() + pos, p.body.end());
+  return result;
+}
+
+// Publica y devuelve el único PUBLISH que debe haber salido
+Publish publishOne(Mqtt5Client& client, ScriptedBroker& broker, const char* topic, bool v5 = true) {
+  client.publish(topic, (const uint8_t*)"1", 1, false, 60, "text/plain");
+  std::vector<Packet> packets = takePackets(broker);
+  if (packets.size() != 1 || (packets[0].header & 0xF0) != 0x30) return Publish();
+  return decodePublish(packets[0], v5);
+}
+
+void testConnackProperties() {
+  const char* test = "connack properties";
+  ScriptedBroker broker;
+  NativeHost::board().socket = &broker;
+  WiFiClient socket;
+  Mqtt5Client client(socket);
+  client.setServer("broker-a", 1883);
+
+  // Topic Alias Maximum 2, Server Keep Alive 5 s, Maximum Packet Size 64
+  broker.connacks.push_back(connackV5(0x00, {0x22, 0x00, 0x02, 0x13, 0x00, 0x05, 0x27, 0x00, 0x00, 0x00, 0x40}));
+  check(client.connect("dev", nullptr, nullptr), test, "connect failed");
+  check(client.getProtocolLevel() == 5, test, "protocol level is not 5");
+
+  std::vector<Packet> packets = takePackets(broker);
+  check(packets.size() == 1 && connectProtocolLevel(packets[0]) == 5, test, "CONNECT is not MQTT 5");
+
+  Publish first = publishOne(client, broker, "devices/x/sensors");
+  check(first.topic == "devices/x/sensors" && first.alias == 1, test, "first PUBLISH without topic + alias 1");
+  check(first.hasExpiry && first.contentType == "text/plain", test, "expiry/content type missing");
+
+  // Maximum Packet Size del broker: no sale nada que lo supere
+  std::string large(60, 'x');
+  check(!client.publish("devices/x/sensors", (const uint8_t*)large.data(), large.size(), false, 0, nullptr),
+        test, "packet above Maximum Packet Size was accepted");
+  check(takePackets(broker).empty(), test, "oversize packet reached the socket");
+
+  // Server Keep Alive 5 s sustituye a KEEP_ALIVE (15 s)
+  NativeHost::advanceMillis(6000);
+  client.loop();
+  packets = takePackets(broker);
+  check(packets.size() == 1 && packets[0].header == 0xC0, test, "no PINGREQ after Server Keep Alive");
+
+  broker.push({0xD0, 0x00});
+  client.loop();
+  long rtt;
+  check(client.takePingLatency(rtt) && rtt >= 0, test, "PINGRESP not measured");
+  check(client.connected(), test, "connection dropped");
+}
+
+void testUnknownProperty() {
+  const char* test = "unknown property";
+  ScriptedBroker broker;
+  NativeHost::board().socket = &broker;
+  WiFiClient socket;
+  Mqtt5Client client(socket);
+  client.setServer("broker-a", 1883);
+
+  // Reason String (0x1F) y User Property (0x26) antes del Topic Alias Maximum
+  Bytes properties = {0x1F, 0x00, 0x02, 'o', 'k', 0x26, 0x00, 0x01, 'k', 0x00, 0x01, 'v', 0x22, 0x00, 0x03};
+  broker.connacks.push_back(connackV5(0x00, properties));
+  check(client.connect("dev", nullptr, nullptr), test, "connect failed with skippable properties");
+  takePackets(broker);
+  check(publishOne(client, broker, "t/a").alias == 1, test, "property after the unknown ones was lost");
+
+  // Reason String que declara más bytes que el bloque: CONNACK rechazado
+  client.disconnect();
+  broker.connacks.push_back(connackV5(0x00, {0x1F, 0x00, 0x20, 'x'}));
+  check(!client.connect("dev", nullptr, nullptr), test, "truncated string property was accepted");
+
+  // Identificador desconocido
+  broker.connacks.push_back(connackV5(0x00, {0x7F, 0x00}));
+  check(!client.connect("dev", nullptr, nullptr), test, "undefined property id was accepted");
+
+  // Subscription Identifier (varint) cortado al final del bloque
+  broker.connacks.push_back(connackV5(0x00, {0x0B, 0x80}));
+  check(!client.connect("dev", nullptr, nullptr), test, "truncated varint property was accepted");
+}
+
+void testProtocolFallback() {
+  const char* test = "3.1.1 fallback";
+  ScriptedBroker broker;
+  NativeHost::board().socket = &broker;
+  WiFiClient socket;
+  Mqtt5Client client(socket);
+  client.setServer("legacy", 1883);
+
+  broker.connacks.push_back(connackV5(0x84, {}));
+  check(!client.connect("dev", nullptr, nullptr), test, "connect succeeded on 0x84");
+  check(client.state() == MQTT_CONNECT_BAD_PROTOCOL, test, "state is not BAD_PROTOCOL");
+  check(client.getProtocolLevel() == 4, test, "did not fall back to 3.1.1");
+
+  broker.connacks.push_back(connackV311(0x00));
+  check(client.connect("dev", "user", "pass"), test, "3.1.1 connect failed");
+  std::vector<Packet> packets = takePackets(broker);
+  check(packets.size() == 1 && connectProtocolLevel(packets[0]) == 4, test, "retry CONNECT is not 3.1.1");
+
+  // 3.1.1: sin propiedades ni alias, topic completo
+  Publish publish = publishOne(client, broker, "t/a", false);
+  check(publish.topic == "t/a" && publish.payload == "1", test, "3.1.1 PUBLISH malformed");
+
+  // Failover y vuelta: el broker conocido conserva 3.1.1, uno nuevo empieza por 5
+  client.disconnect();
+  client.setServer("other", 1883);
+  check(client.getProtocolLevel() == 5, test, "new broker does not start at MQTT 5");
+  client.setServer("legacy", 1883);
+  check(client.getProtocolLevel() == 4, test, "negotiated level was forgotten on failback");
+
+  int connectsBefore = broker.connects;
+  broker.connacks.push_back(connackV311(0x00));
+  check(client.connect("dev", nullptr, nullptr), test, "failback connect failed");
+  check(broker.connects == connectsBefore + 1, test, "failback needed more than one CONNECT");
+}
+
+void testAliases() {
+  const char* test = "topic aliases";
+  ScriptedBroker broker;
+  NativeHost::board().socket = &broker;
+  WiFiClient socket;
+  Mqtt5Client client(socket);
+  client.setServer("broker-a", 1883);
+
+  broker.connacks.push_back(connackV5(0x00, {0x22, 0x00, 0x02}));
+  check(client.connect("dev", nullptr, nullptr), test, "connect failed");
+  takePackets(broker);
+
+  Publish a = publishOne(client, broker, "t/a");
+  Publish b = publishOne(client, broker, "t/b");
+  Publish again = publishOne(client, broker, "t/a");
+  check(a.topic == "t/a" && a.alias == 1, test, "t/a not assigned alias 1");
+  check(b.topic == "t/b" && b.alias == 2, test, "t/b not assigned alias 2");
+  check(again.topic.empty() && again.alias == 1, test, "known topic not sent as alias only");
+
+  // Tabla llena (máximo 2 del broker): se reasigna el alias menos usado
+  Publish c = publishOne(client, broker, "t/c");
+  check(c.topic == "t/c" && c.alias == 2, test, "LRU alias (t/b) not reassigned to t/c");
+  Publish b2 = publishOne(client, broker, "t/b");
+  check(b2.topic == "t/b" && b2.alias == 1, test, "LRU alias (t/a) not reassigned to t/b");
+
+  // Los alias son de la conexión: tras reconectar el topic vuelve completo
+  client.disconnect();
+  broker.connacks.push_back(connackV5(0x00, {0x22, 0x00, 0x02}));
+  check(client.connect("dev", nullptr, nullptr), test, "reconnect failed");
+  takePackets(broker);
+  Publish afterReconnect = publishOne(client, broker, "t/c");
+  check(afterReconnect.topic == "t/c" && afterReconnect.alias == 1, test, "aliases survived reconnect");
+
+  // Sin Topic Alias Maximum el broker no admite alias
+  client.disconnect();
+  broker.connacks.push_back(connackV5(0x00, {}));
+  check(client.connect("dev", nullptr, nullptr), test, "connect without aliases failed");
+  takePackets(broker);
+  Publish plain = publishOne(client, broker, "t/a");
+  check(plain.topic == "t/a" && plain.alias == 0, test, "alias sent to a broker that allows none");
+}
+
+void testOversizePackets() {
+  const char* test = "oversize packets";
+  ScriptedBroker broker;
+  NativeHost::board().socket = &broker;
+  WiFiClient socket;
+  Mqtt5Client client(socket);
+  client.setServer("broker-a", 1883);
+  client.setCallback(onMessage);
+  client.setBufferSize(64);
+
+  broker.connacks.push_back(connackV5(0x00, {}));
+  check(client.connect("dev", nullptr, nullptr), test, "connect failed");
+  takePackets(broker);
+
+  // Saliente más grande que el buffer: rechazado sin tocar el socket
+  std::string large(80, 'x');
+  check(!client.publish("t/a", large.c_str()), test, "publish larger than the buffer was accepted");
+  check(takePackets(broker).empty(), test, "oversize publish reached the socket");
+
+  // Entrante más grande que el buffer (Maximum Packet Size anunciado): se descarta
+  callbackCount = 0;
+  broker.push(inboundPublish("t/in", {}, std::string(100, 'y')));
+  broker.push(inboundPublish("t/in", {}, "small"));
+  client.loop();
+  check(callbackCount == 1 && lastPayload == "small", test, "oversize inbound packet was delivered");
+  check(client.connected(), test, "oversize inbound packet dropped the connection");
+
+  // Propiedades de PUBLISH que se salen de su bloque: mensaje ignorado
+  callbackCount = 0;
+  broker.push(inboundPublish("t/in", {0x26, 0x00, 0x30}, "bad"));
+  broker.push(inboundPublish("t/in", {0x02, 0x00, 0x00, 0x00, 0x3C}, "good"));
+  client.loop();
+  check(callbackCount == 1 && lastTopic == "t/in" && lastPayload == "good", test,
+        "PUBLISH with malformed properties was delivered");
+}
+
+void run(void (*testFunction)(), const char* name) {
+  int before = failures;
+  testFunction();
+  printf("%s %s\n", failures == before ? "PASS" : "FAIL", name);
+}
+
+}  // namespace
+
+int main() {
+  NativeHost::setVirtualTime(true);
+  NativeHost::setSerialEnabled(false);
+
+  run(testConnackProperties, "connack properties");
+  run(testUnknownProperty, "unknown property");
+  run(testProtocolFallback, "3.1.1 fallback");
+  run(testAliases, "topic aliases");
+  run(testOversizePackets, "oversize packets");
+
+  NativeHost::board().socket = nullptr;
+  printf(failures == 0 ? "ALL PASSED\n" : "%d CHECK(S) FAILED\n", failures);
+  return failures == 0 ? 0 : 1;
+}
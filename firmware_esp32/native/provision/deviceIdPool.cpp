@@ -0,0 +1,83 @@
+// deviceIdPool.cpp
+// ========================================
+
+#include "deviceIdPool.h"
+
+#include <cctype>
+#include <fstream>
+
+namespace {
+
+std::string trim(const std::string& text) {
+  size_t start = text.find_first_not_of(" \t\r");
+  if (start == std::string::npos) return "";
+  size_t end = text.find_last_not_of(" \t\r");
+  return text.substr(start, end - start + 1);
+}
+
+}  // namespace
+
+bool DeviceIdPool::load(const std::string& idsPath, const std::string& outputPath, std::string& error) {
+  // CSV de resultados: mac,deviceId,...
+  std::set<std::string> used;
+  std::ifstream output(outputPath);
+  std::string line;
+  while (std::getline(output, line)) {
+    size_t first = line.find(',');
+    if (first == std::string::npos) continue;
+    size_t second = line.find(',', first + 1);
+    used.insert(line.substr(first + 1, second == std::string::npos ? std::string::npos : second - first - 1));
+  }
+
+  std::ifstream input(idsPath);
+  if (!input) {
+    error = "cannot open " + idsPath;
+    return false;
+  }
+
+  std::set<std::string> seen;
+  size_t lineNumber = 0;
+  while (std::getline(input, line)) {
+    lineNumber++;
+    std::string deviceId = trim(line.substr(0, line.find('#')));
+    if (deviceId.empty()) continue;
+    if (!isValid(deviceId)) {
+      error = idsPath + ":" + std::to_string(lineNumber) + ": invalid device id '" + deviceId + "'";
+      return false;
+    }
+    if (!seen.insert(deviceId).second) continue;
+    if (used.count(deviceId)) {
+      provisioned++;
+      continue;
+    }
+    ids.push_back(deviceId);
+  }
+  return true;
+}
+
+bool DeviceIdPool::acquire(std::string& deviceId) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (ids.empty()) return false;
+  deviceId = ids.front();
+  ids.pop_front();
+  return true;
+}
+
+void DeviceIdPool::release(const std::string& deviceId) {
+  std::lock_guard<std::mutex> lock(mutex);
+  ids.push_front(deviceId);
+}
+
+size_t DeviceIdPool::available() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return ids.size();
+}
+
+bool DeviceIdPool::isValid(const std::string& deviceId) {
+  // ObjectId de MongoDB: mismo criterio que Provisioning::isValidDeviceId()
+  if (deviceId.size() != 24) return false;
+  for (char c : deviceId) {
+    if (!isxdigit((unsigned char)c)) return false;
+  }
+  return true;
+}
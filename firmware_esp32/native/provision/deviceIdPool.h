@@ -0,0 +1,33 @@
+// deviceIdPool.h
+// ========================================
+// deviceIds ya activados en el backend, repartidos entre los puertos. Un ID
+// vuelve al pool solo si el dispositivo rechazó la configuración (PROV ERROR
+// borra el flash); tras un timeout queda reservado porque pudo llegar a guardarse.
+
+#ifndef PROVISION_DEVICE_ID_POOL_H
+#define PROVISION_DEVICE_ID_POOL_H
+
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+
+class DeviceIdPool {
+public:
+  // Omite los IDs que ya figuran en el CSV de resultados (reanudar una tanda)
+  bool load(const std::string& idsPath, const std::string& outputPath, std::string& error);
+
+  bool acquire(std::string& deviceId);
+  void release(const std::string& deviceId);
+  size_t available();
+  size_t alreadyProvisioned() const { return provisioned; }
+
+  static bool isValid(const std::string& deviceId);
+
+private:
+  std::mutex mutex;
+  std::deque<std::string> ids;
+  size_t provisioned = 0;
+};
+
+#endif
@@ -0,0 +1,284 @@
+// main.cpp (provision)
+// ========================================
+// Aprovisionamiento en bloque: configura en paralelo todos los ESP32 conectados
+// por USB (WiFi + deviceId ya activado en el backend) mediante los comandos
+// "prov ..." de SerialConsole, y confirma cada uno con la prueba de publicación.
+//
+// Uso:
+//   pio run -e native_provision
+//   .pio/build/native_provision/program --ssid Planta3 --password secreto --ids ids.txt --watch
+//   (--network Planta3-Norte --network-password otro: red extra para equipos entre alas)
+//
+// ids.txt: un deviceId (ObjectId) por línea, '#' para comentarios. Los IDs que
+// ya figuran en --out se omiten, así una tanda interrumpida se puede reanudar.
+
+#include "deviceIdPool.h"
+#include "provisionOptions.h"
+#include "provisionSession.h"
+#include "serialPort.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic<bool> stopRequested(false);
+std::mutex outputMutex;
+
+void printUsage() {
+  printf("Usage: provision --ssid <ssid> --ids <file> [options]\n"
+         "  --ssid <ssid>           WiFi network (max 32 chars)\n"
+         "  --password <pass>       WiFi password (omit for open networks)\n"
+         "  --network <ssid>        Additional WiFi network, repeatable (max 3)\n"
+         "  --network-password <p>  Password for the preceding --network\n"
+         "  --ids <file>            Pre-activated device ids, one per line\n"
+         "  --role <role>           direct | gateway | leaf (default direct)\n"
+         "  --shards <n>            Ingestion shard count, 0 = unsharded (default: firmware's)\n"
+         "  --espnow-key <hex>      ESP-NOW LMK, 32 hex chars, same for gateways and leaves\n"
+         "  --ports <a,b,...>       Serial ports (default: detect USB serial ports)\n"
+         "  --out <file>            Results CSV, appended (default provisioned.csv)\n"
+         "  --baud <n>              Baud rate (default 115200)\n"
+         "  --boot-timeout <s>      Wait for PROV HELLO after reset (default 150)\n"
+         "  --commit-timeout <s>    Wait for the self-test result (default 60)\n"
+         "  --no-reset              Do not reset the board through RTS on open\n"
+         "  --force                 Erase and re-provision configured devices\n"
+         "  --watch                 Keep provisioning newly plugged devices until Ctrl-C\n");
+}
+
+std::vector<std::string> splitList(const char* value) {
+  std::vector<std::string> items;
+  std::stringstream stream(value);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    if (!item.empty()) items.push_back(item);
+  }
+  return items;
+}
+
+bool parseOptions(int argc, char** argv, ProvisionOptions& options) {
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (strcmp(arg, "--help") == 0) return false;
+    if (strcmp(arg, "--no-reset") == 0) { options.reset = false; continue; }
+    if (strcmp(arg, "--force") == 0) { options.force = true; continue; }
+    if (strcmp(arg, "--watch") == 0) { options.watch = true; continue; }
+    if (i + 1 >= argc) {
+      fprintf(stderr, "Missing value for %s\n", arg);
+      return false;
+    }
+    const char* value = argv[++i];
+
+    if (strcmp(arg, "--ssid") == 0) options.ssid = value;
+    else if (strcmp(arg, "--password") == 0) options.password = value;
+    else if (strcmp(arg, "--network") == 0) options.extraNetworks.push_back({value, ""});
+    else if (strcmp(arg, "--network-password") == 0) {
+      if (options.extraNetworks.empty()) {
+        fprintf(stderr, "--network-password must follow --network\n");
+        return false;
+      }
+      options.extraNetworks.back().password = value;
+    }
+    else if (strcmp(arg, "--ids") == 0) options.idsPath = value;
+    else if (strcmp(arg, "--role") == 0) options.role = value;
+    else if (strcmp(arg, "--shards") == 0) options.shardCount = strtol(value, nullptr, 10);
+    else if (strcmp(arg, "--espnow-key") == 0) options.espNowKey = value;
+    else if (strcmp(arg, "--ports") == 0) options.ports = splitList(value);
+    else if (strcmp(arg, "--out") == 0) options.outputPath = value;
+    else if (strcmp(arg, "--baud") == 0) options.baud = strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--boot-timeout") == 0) options.bootTimeoutSeconds = strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--commit-timeout") == 0) options.commitTimeoutSeconds = strtoul(value, nullptr, 10);
+    else {
+      fprintf(stderr, "Unknown option: %s\n", arg);
+      return false;
+    }
+  }
+
+  // Mismos límites que los buffers de Provisioning (firmware)
+  if (options.ssid.empty() || options.ssid.size() > 32) {
+    fprintf(stderr, "--ssid is required (max 32 chars)\n");
+    return false;
+  }
+  if (options.password.size() > 64) {
+    fprintf(stderr, "--password is limited to 64 chars\n");
+    return false;
+  }
+  // WIFI_MAX_PROFILES (config.h) menos la red principal
+  if (options.extraNetworks.size() > 3) {
+    fprintf(stderr, "At most 3 --network entries are supported\n");
+    return false;
+  }
+  for (const WiFiNetwork& network : options.extraNetworks) {
+    if (network.ssid.empty() || network.ssid.size() > 32 || network.password.size() > 64) {
+      fprintf(stderr, "Invalid --network %s (ssid max 32 chars, password max 64)\n", network.ssid.c_str());
+      return false;
+    }
+  }
+  if (options.idsPath.empty()) {
+    fprintf(stderr, "--ids is required\n");
+    return false;
+  }
+  if (options.role != "direct" && options.role != "gateway" && options.role != "leaf") {
+    fprintf(stderr, "Invalid role: %s\n", options.role.c_str());
+    return false;
+  }
+  if (!options.espNowKey.empty() &&
+      (options.espNowKey.size() != 32 || options.espNowKey.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos)) {
+    fprintf(stderr, "--espnow-key must be 32 hex chars\n");
+    return false;
+  }
+  if (options.shardCount > 255) {
+    fprintf(stderr, "--shards must be between 0 and 255\n");
+    return false;
+  }
+  return true;
+}
+
+void logLine(const std::string& port, const std::string& message) {
+  std::lock_guard<std::mutex> lock(outputMutex);
+  printf("[%s] %s\n", port.c_str(), message.c_str());
+  fflush(stdout);
+}
+
+std::string isoTimestamp() {
+  char buffer[32];
+  time_t now = time(nullptr);
+  tm utc;
+  gmtime_r(&now, &utc);
+  strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &utc);
+  return buffer;
+}
+
+void appendResult(FILE* output, const ProvisionResult& result) {
+  // Solo los provisionados: DeviceIdPool::load() lee la segunda columna para reanudar
+  std::lock_guard<std::mutex> lock(outputMutex);
+  fprintf(output, "%s,%s,%s,%s,%s,%d,%s,%s\n", result.mac.c_str(), result.deviceId.c_str(),
+          result.sensorType.c_str(), result.shard.c_str(), result.broker.c_str(), result.rssi, result.port.c_str(),
+          isoTimestamp().c_str());
+  fflush(output);
+}
+
+void onSignal(int) {
+  stopRequested = true;
+}
+
+struct Worker {
+  std::thread thread;
+  std::atomic<bool> done{false};
+  ProvisionResult result;
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ProvisionOptions options;
+  if (!parseOptions(argc, argv, options)) {
+    printUsage();
+    return 1;
+  }
+
+  DeviceIdPool pool;
+  std::string error;
+  if (!pool.load(options.idsPath, options.outputPath, error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  printf("Device ids: %zu available, %zu already in %s\n", pool.available(), pool.alreadyProvisioned(),
+         options.outputPath.c_str());
+
+  bool newOutput = false;
+  if (FILE* existing = fopen(options.outputPath.c_str(), "r")) {
+    fclose(existing);
+  } else {
+    newOutput = true;
+  }
+  FILE* output = fopen(options.outputPath.c_str(), "a");
+  if (!output) {
+    fprintf(stderr, "Cannot open %s\n", options.outputPath.c_str());
+    return 1;
+  }
+  if (newOutput) fprintf(output, "mac,deviceId,sensorType,shard,broker,rssi,port,provisionedAt\n");
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  std::map<std::string, std::unique_ptr<Worker>> active;
+  std::set<std::string> handled;   // Puertos ya atendidos mientras sigan conectados
+  std::vector<ProvisionResult> results;
+
+  auto collect = [&]() {
+    for (auto it = active.begin(); it != active.end();) {
+      if (!it->second->done) {
+        ++it;
+        continue;
+      }
+      it->second->thread.join();
+      const ProvisionResult& result = it->second->result;
+      logLine(result.port, std::string(ProvisionSession::statusName(result.status)) + ": " + result.detail);
+      if (result.status == ProvisionResult::PROVISIONED) appendResult(output, result);
+      results.push_back(result);
+      it = active.erase(it);
+    }
+  };
+
+  do {
+    std::vector<std::string> ports = options.ports.empty() ? SerialPort::discover() : options.ports;
+
+    // Un puerto que desaparece (dispositivo desenchufado) vuelve a ser elegible
+    std::set<std::string> present(ports.begin(), ports.end());
+    for (auto it = handled.begin(); it != handled.end();) {
+      if (!present.count(*it) && !active.count(*it)) it = handled.erase(it);
+      else ++it;
+    }
+
+    for (const std::string& port : ports) {
+      if (handled.count(port)) continue;
+      handled.insert(port);
+
+      std::unique_ptr<Worker> worker(new Worker());
+      Worker* raw = worker.get();
+      raw->thread = std::thread([raw, port, &options, &pool]() {
+        ProvisionSession session(port, options, pool, logLine);
+        raw->result = session.run();
+        raw->done = true;
+      });
+      active[port] = std::move(worker);
+    }
+
+    collect();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  } while (options.watch ? !stopRequested.load() : !active.empty());
+
+  // Ctrl-C en --watch: terminar las sesiones en curso (no dejar un commit a medias)
+  while (!active.empty()) {
+    collect();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  }
+  fclose(output);
+
+  size_t counts[5] = {0};
+  for (const ProvisionResult& result : results) counts[result.status]++;
+
+  printf("\n%-24s %-14s %-24s %-12s %6s  %s\n", "PORT", "MAC", "DEVICE ID", "STATUS", "TIME", "DETAIL");
+  for (const ProvisionResult& result : results) {
+    printf("%-24s %-14s %-24s %-12s %5.1fs  %s\n", result.port.c_str(), result.mac.c_str(),
+           result.deviceId.c_str(), ProvisionSession::statusName(result.status), result.seconds,
+           result.detail.c_str());
+  }
+  printf("\nProvisioned %zu, skipped %zu, failed %zu, no id %zu, unknown %zu; %zu ids left\n",
+         counts[ProvisionResult::PROVISIONED], counts[ProvisionResult::SKIPPED], counts[ProvisionResult::FAILED],
+         counts[ProvisionResult::NO_ID], counts[ProvisionResult::UNKNOWN], pool.available());
+
+  return counts[ProvisionResult::FAILED] + counts[ProvisionResult::UNKNOWN] > 0 ? 1 : 0;
+}
@@ -0,0 +1,37 @@
+// provisionOptions.h
+// ========================================
+
+#ifndef PROVISION_PROVISION_OPTIONS_H
+#define PROVISION_PROVISION_OPTIONS_H
+
+#include <string>
+#include <vector>
+
+struct WiFiNetwork {
+  std::string ssid;
+  std::string password;                // vacío = red abierta
+};
+
+struct ProvisionOptions {
+  std::string ssid;
+  std::string password;                // vacío = red abierta
+  std::vector<WiFiNetwork> extraNetworks;  // --network: el firmware elige el AP con mejor RSSI
+  std::string role = "direct";         // DEVICE_ROLE de config.h
+  long shardCount = -1;                // -1 = no enviar (MQTT_SHARD_COUNT del firmware)
+  std::string espNowKey;               // LMK en hex; vacío = ESPNOW_LMK del firmware
+  std::string idsPath;                 // deviceIds ya activados, uno por línea
+  std::string outputPath = "provisioned.csv";
+  std::vector<std::string> ports;      // vacío = detectar puertos USB
+  unsigned long baud = 115200;         // monitor_speed de platformio.ini
+  // Espera a la respuesta PROV HELLO tras el reset por RTS o el reinicio de "prov erase":
+  // SerialConsole solo se atiende en loop(), después de setup(). Sin configuración
+  // setup() tarda segundos; con --force el equipo configurado pasa antes por
+  // OperationMode::start() (WIFI_TIMEOUT por AP candidato, sondeo de brokers, MQTT_TIMEOUT)
+  unsigned long bootTimeoutSeconds = 150;
+  unsigned long commitTimeoutSeconds = 60;  // WIFI_TIMEOUT + sondeo de brokers + MQTT_TIMEOUT + eco
+  bool reset = true;                   // Reiniciar por RTS al abrir el puerto
+  bool force = false;                  // Reaprovisionar dispositivos ya configurados
+  bool watch = false;                  // Seguir atendiendo puertos nuevos hasta Ctrl-C
+};
+
+#endif
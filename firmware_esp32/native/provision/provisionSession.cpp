@@ -0,0 +1,206 @@
+// provisionSession.cpp
+// ========================================
+
+#include "provisionSession.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+const unsigned long HELLO_INTERVAL_MS = 2000;
+const unsigned long FIELD_TIMEOUT_MS = 3000;
+
+unsigned long long nowMillis() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool startsWith(const std::string& text, const char* prefix) {
+  return text.compare(0, strlen(prefix), prefix) == 0;
+}
+
+}  // namespace
+
+ProvisionSession::ProvisionSession(const std::string& port, const ProvisionOptions& options, DeviceIdPool& pool,
+                                   Logger log)
+  : portPath(port), options(options), pool(pool), log(log) {}
+
+const char* ProvisionSession::statusName(ProvisionResult::Status status) {
+  switch (status) {
+    case ProvisionResult::PROVISIONED: return "provisioned";
+    case ProvisionResult::SKIPPED: return "skipped";
+    case ProvisionResult::NO_ID: return "no-id";
+    case ProvisionResult::UNKNOWN: return "unknown";
+    default: return "failed";
+  }
+}
+
+ProvisionResult ProvisionSession::run() {
+  unsigned long long start = nowMillis();
+  ProvisionResult result;
+  result.port = portPath;
+
+  auto finish = [&](ProvisionResult::Status status, const std::string& detail) {
+    result.status = status;
+    result.detail = detail;
+    result.seconds = (nowMillis() - start) / 1000.0;
+    serial.close();
+    return result;
+  };
+
+  std::string error;
+  if (!serial.open(portPath, options.baud, error)) {
+    return finish(ProvisionResult::FAILED, "open: " + error);
+  }
+  if (options.reset) serial.resetDevice();
+
+  std::string hello;
+  if (!waitForHello(hello)) {
+    return finish(ProvisionResult::FAILED, "no PROV HELLO (firmware without serial provisioning?)");
+  }
+  result.mac = field(hello, "mac");
+  result.sensorType = field(hello, "sensor");
+  log(portPath, "device " + result.mac + " (" + result.sensorType + ")");
+
+  bool configured = field(hello, "configured") == "1";
+  if (configured && !options.force) {
+    return finish(ProvisionResult::SKIPPED, "already configured (use --force to re-provision)");
+  }
+
+  // Antes de borrar nada: sin ID libre el dispositivo se queda como estaba
+  if (!pool.acquire(result.deviceId)) {
+    return finish(ProvisionResult::NO_ID, "device id pool exhausted");
+  }
+
+  if (configured) {
+    // Borra y reinicia en modo setup: commit solo se acepta sin configuración
+    log(portPath, "erasing previous configuration");
+    std::string reply;
+    if (!serial.writeLine("prov erase") || !readReply(reply, FIELD_TIMEOUT_MS) || reply != "PROV ERASED" ||
+        !waitForHello(hello)) {
+      pool.release(result.deviceId);
+      result.deviceId.clear();
+      return finish(ProvisionResult::FAILED, "erase failed");
+    }
+  }
+
+  bool sent = sendField("ssid", options.ssid, error) &&
+              (options.password.empty() || sendField("pass", options.password, error)) &&
+              sendField("id", result.deviceId, error) &&
+              sendField("role", options.role, error) &&
+              (options.shardCount < 0 || sendField("shards", std::to_string(options.shardCount), error)) &&
+              (options.espNowKey.empty() || sendField("espnowkey", options.espNowKey, error));
+  for (size_t i = 0; sent && i < options.extraNetworks.size(); i++) {
+    const WiFiNetwork& network = options.extraNetworks[i];
+    sent = sendField("net", network.ssid, error) &&
+           (network.password.empty() || sendField("netpass", network.password, error));
+  }
+  if (!sent) {
+    // Nada guardado todavía: el ID puede usarlo otro dispositivo
+    pool.release(result.deviceId);
+    result.deviceId.clear();
+    return finish(ProvisionResult::FAILED, error);
+  }
+
+  log(portPath, "committing " + result.deviceId);
+  ProvisionResult::Status status = commit(result);
+  if (status == ProvisionResult::FAILED) {
+    pool.release(result.deviceId);
+  }
+  return finish(status, result.detail);
+}
+
+bool ProvisionSession::waitForHello(std::string& hello) {
+  unsigned long long deadline = nowMillis() + options.bootTimeoutSeconds * 1000ULL;
+
+  while (nowMillis() < deadline && serial.isOpen()) {
+    // Línea vacía primero: descarta lo que quedara a medias en SerialConsole
+    serial.writeLine("");
+    serial.writeLine("prov hello");
+
+    unsigned long long retryAt = nowMillis() + HELLO_INTERVAL_MS;
+    std::string line;
+    while (nowMillis() < retryAt) {
+      if (!serial.readLine(line, (unsigned long)(retryAt - nowMillis()))) break;
+      if (startsWith(line, "PROV HELLO ")) {
+        hello = line;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool ProvisionSession::sendField(const std::string& name, const std::string& value, std::string& error) {
+  if (value.find_first_of("\r\n") != std::string::npos) {
+    error = name + " contains a line break";
+    return false;
+  }
+
+  std::string reply;
+  if (!serial.writeLine("prov " + name + " " + value) || !readReply(reply, FIELD_TIMEOUT_MS)) {
+    error = "no reply to prov " + name;
+    return false;
+  }
+  if (reply != "PROV ACK " + name) {
+    error = reply.substr(5);
+    return false;
+  }
+  return true;
+}
+
+ProvisionResult::Status ProvisionSession::commit(ProvisionResult& result) {
+  if (!serial.writeLine("prov commit")) {
+    result.detail = "write failed";
+    return ProvisionResult::UNKNOWN;
+  }
+
+  unsigned long long deadline = nowMillis() + options.commitTimeoutSeconds * 1000ULL;
+  std::string reply;
+  while (nowMillis() < deadline) {
+    if (!readReply(reply, (unsigned long)(deadline - nowMillis()))) break;
+
+    if (startsWith(reply, "PROV TEST ")) {
+      log(portPath, "testing " + reply.substr(10));
+    } else if (startsWith(reply, "PROV OK")) {
+      result.broker = field(reply, "broker");
+      result.rssi = atoi(field(reply, "rssi").c_str());
+      result.shard = field(reply, "shard");
+      result.detail = "self-test echoed by broker " + result.broker;
+      return ProvisionResult::PROVISIONED;
+    } else if (startsWith(reply, "PROV ERROR ")) {
+      // El firmware ya borró la configuración
+      result.detail = reply.substr(11);
+      return ProvisionResult::FAILED;
+    }
+  }
+
+  result.detail = serial.isOpen() ? "commit timed out" : "port closed during commit";
+  return ProvisionResult::UNKNOWN;
+}
+
+bool ProvisionSession::readReply(std::string& reply, unsigned long timeoutMs) {
+  // El resto de la salida del firmware (logs de WiFi, MQTT...) se ignora
+  unsigned long long deadline = nowMillis() + timeoutMs;
+  std::string line;
+  while (nowMillis() < deadline) {
+    if (!serial.readLine(line, (unsigned long)(deadline - nowMillis()))) return false;
+    if (startsWith(line, "PROV ") && !startsWith(line, "PROV HELLO ")) {
+      reply = line;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string ProvisionSession::field(const std::string& line, const std::string& key) {
+  // "PROV HELLO mac=... sensor=..." -> valor de key
+  std::string marker = " " + key + "=";
+  size_t start = line.find(marker);
+  if (start == std::string::npos) return "";
+  start += marker.size();
+  size_t end = line.find(' ', start);
+  return line.substr(start, end == std::string::npos ? std::string::npos : end - start);
+}
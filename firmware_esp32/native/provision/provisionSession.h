@@ -0,0 +1,62 @@
+// provisionSession.h
+// ========================================
+// Diálogo "prov ..." con un dispositivo (ver src/provisioning.h): espera el
+// arranque, toma un deviceId del pool, envía los campos y confirma con commit.
+
+#ifndef PROVISION_PROVISION_SESSION_H
+#define PROVISION_PROVISION_SESSION_H
+
+#include "deviceIdPool.h"
+#include "provisionOptions.h"
+#include "serialPort.h"
+
+#include <functional>
+#include <string>
+
+struct ProvisionResult {
+  enum Status {
+    PROVISIONED,
+    SKIPPED,      // Ya configurado y sin --force
+    FAILED,       // PROV ERROR o sin respuesta antes de recibir un ID
+    NO_ID,        // Pool agotado
+    UNKNOWN       // Timeout tras enviar el ID: revisar a mano antes de reutilizarlo
+  };
+
+  Status status = FAILED;
+  std::string port;
+  std::string mac;
+  std::string sensorType;
+  std::string deviceId;
+  std::string broker;
+  std::string shard;
+  int rssi = 0;
+  std::string detail;
+  double seconds = 0;
+};
+
+class ProvisionSession {
+public:
+  typedef std::function<void(const std::string& port, const std::string& message)> Logger;
+
+  ProvisionSession(const std::string& port, const ProvisionOptions& options, DeviceIdPool& pool, Logger log);
+
+  ProvisionResult run();
+
+  static const char* statusName(ProvisionResult::Status status);
+
+private:
+  std::string portPath;
+  const ProvisionOptions& options;
+  DeviceIdPool& pool;
+  Logger log;
+  SerialPort serial;
+
+  bool waitForHello(std::string& hello);
+  bool sendField(const std::string& field, const std::string& value, std::string& error);
+  ProvisionResult::Status commit(ProvisionResult& result);
+  bool readReply(std::string& reply, unsigned long timeoutMs);
+
+  static std::string field(const std::string& line, const std::string& key);
+};
+
+#endif
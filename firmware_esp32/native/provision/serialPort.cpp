@@ -0,0 +1,190 @@
+// serialPort.cpp
+// ========================================
+
+#include "serialPort.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <glob.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+bool toSpeed(unsigned long baud, speed_t& speed) {
+  switch (baud) {
+    case 9600: speed = B9600; return true;
+    case 57600: speed = B57600; return true;
+    case 115200: speed = B115200; return true;
+    case 230400: speed = B230400; return true;
+#ifdef B460800
+    case 460800: speed = B460800; return true;
+#endif
+#ifdef B921600
+    case 921600: speed = B921600; return true;
+#endif
+    default: return false;
+  }
+}
+
+unsigned long long nowMillis() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace
+
+SerialPort::~SerialPort() {
+  close();
+}
+
+bool SerialPort::open(const std::string& path, unsigned long baud, std::string& error) {
+  close();
+
+  speed_t speed;
+  if (!toSpeed(baud, speed)) {
+    error = "unsupported baud rate";
+    return false;
+  }
+
+  fd = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0) {
+    error = strerror(errno);
+    return false;
+  }
+
+  termios tty;
+  if (tcgetattr(fd, &tty) != 0) {
+    error = strerror(errno);
+    close();
+    return false;
+  }
+  cfmakeraw(&tty);
+  cfsetispeed(&tty, speed);
+  cfsetospeed(&tty, speed);
+  tty.c_cflag |= CLOCAL | CREAD;
+  tty.c_cflag &= ~(CSTOPB | CRTSCTS);
+  tty.c_cc[VMIN] = 0;
+  tty.c_cc[VTIME] = 0;
+  if (tcsetattr(fd, TCSANOW, &tty) != 0) {
+    error = strerror(errno);
+    close();
+    return false;
+  }
+
+  // Otro proceso (pio device monitor) con el mismo puerto abierto corrompería el protocolo
+  if (ioctl(fd, TIOCEXCL) != 0) {
+    error = strerror(errno);
+    close();
+    return false;
+  }
+
+  tcflush(fd, TCIOFLUSH);
+  pending.clear();
+  return true;
+}
+
+void SerialPort::close() {
+  if (fd >= 0) {
+    ::close(fd);
+    fd = -1;
+  }
+}
+
+void SerialPort::setModemLine(int line, bool asserted) {
+  ioctl(fd, asserted ? TIOCMBIS : TIOCMBIC, &line);
+}
+
+void SerialPort::resetDevice() {
+  if (fd < 0) return;
+
+  // Mismo pulso que esptool ("hard reset"): EN a nivel bajo con GPIO0 libre
+  setModemLine(TIOCM_DTR, false);
+  setModemLine(TIOCM_RTS, true);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  setModemLine(TIOCM_RTS, false);
+
+  tcflush(fd, TCIFLUSH);
+  pending.clear();
+}
+
+bool SerialPort::writeLine(const std::string& line) {
+  if (fd < 0) return false;
+
+  std::string data = line + "\n";
+  size_t offset = 0;
+  while (offset < data.size()) {
+    ssize_t written = ::write(fd, data.data() + offset, data.size() - offset);
+    if (written < 0) {
+      if (errno == EAGAIN || errno == EINTR) {
+        pollfd entry = {fd, POLLOUT, 0};
+        ::poll(&entry, 1, 100);
+        continue;
+      }
+      return false;
+    }
+    offset += (size_t)written;
+  }
+  return tcdrain(fd) == 0;
+}
+
+bool SerialPort::readLine(std::string& line, unsigned long timeoutMs) {
+  unsigned long long deadline = nowMillis() + timeoutMs;
+
+  while (fd >= 0) {
+    size_t newline = pending.find('\n');
+    if (newline != std::string::npos) {
+      line = pending.substr(0, newline);
+      pending.erase(0, newline + 1);
+      if (!line.empty() && line.back() == '\r') line.pop_back();
+      return true;
+    }
+
+    unsigned long long now = nowMillis();
+    if (now >= deadline) return false;
+
+    pollfd entry = {fd, POLLIN, 0};
+    int ready = ::poll(&entry, 1, (int)(deadline - now));
+    if (ready < 0 && errno != EINTR) return false;
+    if (ready <= 0) continue;
+    if (entry.revents & (POLLHUP | POLLERR | POLLNVAL)) {
+      close();
+      return false;
+    }
+
+    char buffer[256];
+    ssize_t count = ::read(fd, buffer, sizeof(buffer));
+    if (count < 0) {
+      if (errno == EAGAIN || errno == EINTR) continue;
+      close();
+      return false;
+    }
+    // El bootloader escribe a 74880 baudios: basura sin '\n' que no debe crecer sin límite
+    pending.append(buffer, (size_t)count);
+    if (pending.size() > 4096 && pending.find('\n') == std::string::npos) pending.erase(0, pending.size() - 1024);
+  }
+  return false;
+}
+
+std::vector<std::string> SerialPort::discover() {
+  // CP210x / CH340 / FTDI (ttyUSB, cu.usbserial...) y USB CDC nativo (ttyACM)
+  static const char* const patterns[] = {
+    "/dev/ttyUSB*", "/dev/ttyACM*", "/dev/cu.usbserial*", "/dev/cu.SLAB_USBtoUART*",
+    "/dev/cu.wchusbserial*", "/dev/cu.usbmodem*"
+  };
+
+  std::vector<std::string> ports;
+  for (const char* pattern : patterns) {
+    glob_t matches;
+    if (glob(pattern, 0, nullptr, &matches) == 0) {
+      for (size_t i = 0; i < matches.gl_pathc; i++) ports.push_back(matches.gl_pathv[i]);
+    }
+    globfree(&matches);
+  }
+  return ports;
+}
@@ -0,0 +1,38 @@
+// serialPort.h
+// ========================================
+// Puerto serie POSIX (termios) en modo raw, lectura por líneas con timeout.
+
+#ifndef PROVISION_SERIAL_PORT_H
+#define PROVISION_SERIAL_PORT_H
+
+#include <string>
+#include <vector>
+
+class SerialPort {
+public:
+  SerialPort() = default;
+  ~SerialPort();
+  SerialPort(const SerialPort&) = delete;
+  SerialPort& operator=(const SerialPort&) = delete;
+
+  bool open(const std::string& path, unsigned long baud, std::string& error);
+  void close();
+  bool isOpen() const { return fd >= 0; }
+
+  // Reinicio del ESP32 por el circuito de auto-reset (RTS -> EN, DTR -> GPIO0)
+  void resetDevice();
+
+  bool writeLine(const std::string& line);
+  // false = timeout o puerto cerrado (dispositivo desconectado)
+  bool readLine(std::string& line, unsigned long timeoutMs);
+
+  static std::vector<std::string> discover();
+
+private:
+  int fd = -1;
+  std::string pending;
+
+  void setModemLine(int line, bool asserted);
+};
+
+#endif
@@ -0,0 +1,330 @@
+// main.cpp (replay)
+// ========================================
+// Reproduce una traza grabada con TraceRecorder a través del mismo código del
+// firmware (Sensor, SamplingScheduler, AlertEvaluator, OperationMode) en tiempo
+// virtual: un día de datos de sala se procesa en segundos.
+//
+// Acepta el archivo binario o cualquier log que contenga las líneas TRACE de
+// una descarga (captura del monitor serie, o `mosquitto_sub -t devices/<id>/trace`).
+//
+// Uso:
+//   pio run -e native_replay
+//   .pio/build/native_replay/program --trace sala3.log [--out payloads.jsonl] [--verbose]
+
+#include "alertEvaluator.h"
+#include "operationMode.h"
+#include "samplingScheduler.h"
+#include "sensor.h"
+#include "storage.h"
+#include "traceRecorder.h"
+
+#include <NativeHost.h>
+#include <config.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const unsigned long LOOP_DELAY_MS = 100;  // delay(100) de loop() en main.cpp
+const uint32_t DEFAULT_EPOCH = 1700000000UL;
+
+struct Sample {
+  uint32_t offset;
+  uint8_t channel;
+  float value;
+};
+
+// Broker en memoria: guarda lo que el firmware publicaría
+class ReplayTransport : public NativeHost::MqttTransport {
+public:
+  FILE* out = nullptr;
+  unsigned long published = 0;
+  unsigned long alerts = 0;
+  unsigned long firstPublish = 0;
+  unsigned long lastPublish = 0;
+
+  bool connect(const char* clientId, const char* username, const char* password) override {
+    (void)clientId; (void)username; (void)password;
+    return true;
+  }
+  bool connected() override { return true; }
+  bool publish(const char* topic, const uint8_t* payload, size_t length, bool retained) override {
+    (void)retained;
+    if (strstr(topic, "/alerts")) {
+      alerts++;
+    } else if (strstr(topic, "/sensors")) {
+      if (published == 0) firstPublish = millis();
+      lastPublish = millis();
+      published++;
+    }
+    if (out) {
+      fprintf(out, "{\"millis\":%lu,\"topic\":\"%s\",\"payload\":%.*s}\n",
+              millis(), topic, (int)length, (const char*)payload);
+    }
+    return true;
+  }
+  bool subscribe(const char* topic) override {
+    (void)topic;
+    return true;
+  }
+  void loop() override {}
+  int state() override { return 0; }
+};
+
+void printUsage() {
+  printf("Usage: replay --trace <file> [--out <payloads.jsonl>] [--verbose]\n");
+}
+
+bool readFile(const char* path, std::string& content) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) return false;
+  std::ostringstream data;
+  data << file.rdbuf();
+  content = data.str();
+  return true;
+}
+
+int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// Reconstruye el binario desde las líneas TRACE (se queda con la última descarga completa)
+bool parseDump(const std::string& text, std::vector<uint8_t>& bytes, std::string& error) {
+  std::istringstream lines(text);
+  std::string line;
+  std::vector<bool> covered;
+  bool inDump = false;
+  bool complete = false;
+
+  while (std::getline(lines, line)) {
+    size_t pos = line.find("TRACE ");
+    if (pos == std::string::npos) continue;
+    std::istringstream fields(line.substr(pos + 6));
+    std::string tag;
+    fields >> tag;
+
+    if (tag == "BEGIN") {
+      size_t size = 0;
+      fields >> size;
+      bytes.assign(size, 0);
+      covered.assign(size, false);
+      inDump = true;
+      complete = false;
+    } else if (tag == "END" && inDump) {
+      size_t size = 0;
+      std::string crcText;
+      fields >> size >> crcText;
+      for (size_t i = 0; i < covered.size(); i++) {
+        if (!covered[i]) {
+          error = "missing TRACE data at offset " + std::to_string(i);
+          return false;
+        }
+      }
+      uint32_t crc = TraceRecorder::crc32(0, bytes.data(), bytes.size());
+      if (size != bytes.size() || crc != (uint32_t)strtoul(crcText.c_str(), nullptr, 16)) {
+        error = "TRACE checksum mismatch";
+        return false;
+      }
+      inDump = false;
+      complete = true;
+    } else if (inDump && tag.size() == 8) {
+      size_t offset = strtoul(tag.c_str(), nullptr, 16);
+      std::string hex;
+      fields >> hex;
+      for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        int high = hexValue(hex[i]);
+        int low = hexValue(hex[i + 1]);
+        size_t index = offset + i / 2;
+        if (high < 0 || low < 0 || index >= bytes.size()) break;
+        bytes[index] = (uint8_t)(high * 16 + low);
+        covered[index] = true;
+      }
+    }
+  }
+
+  if (!complete) {
+    error = "no complete TRACE BEGIN/END dump found";
+    return false;
+  }
+  return true;
+}
+
+void applySample(NativeHost::Board& board, const Sample& sample) {
+  switch (sample.channel) {
+    case TraceRecorder::CHANNEL_MQ4_RAW:
+      board.analog[MQ4_PIN] = (int)sample.value;
+      break;
+    case TraceRecorder::CHANNEL_PIR_PIN:
+      board.digital[PIR_PIN] = sample.value != 0.0f ? HIGH : LOW;
+      break;
+    case TraceRecorder::CHANNEL_DHT_TEMPERATURE:
+      board.dhtTemperature = sample.value;
+      break;
+    case TraceRecorder::CHANNEL_DHT_HUMIDITY:
+      board.dhtHumidity = sample.value;
+      break;
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const char* tracePath = nullptr;
+  const char* outPath = nullptr;
+  bool verbose = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--verbose") == 0) {
+      verbose = true;
+    } else if (i + 1 < argc && strcmp(argv[i], "--trace") == 0) {
+      tracePath = argv[++i];
+    } else if (i + 1 < argc && strcmp(argv[i], "--out") == 0) {
+      outPath = argv[++i];
+    } else {
+      printUsage();
+      return 2;
+    }
+  }
+  if (!tracePath) {
+    printUsage();
+    return 2;
+  }
+
+  // === Cargar traza ===
+  std::string content;
+  if (!readFile(tracePath, content)) {
+    fprintf(stderr, "Cannot read %s\n", tracePath);
+    return 1;
+  }
+
+  std::vector<uint8_t> bytes;
+  if (content.compare(0, 4, "STRC") == 0) {
+    bytes.assign(content.begin(), content.end());
+  } else {
+    std::string error;
+    if (!parseDump(content, bytes, error)) {
+      fprintf(stderr, "%s: %s\n", tracePath, error.c_str());
+      return 1;
+    }
+  }
+
+  char sensorType[TraceRecorder::SENSOR_TYPE_SIZE + 1];
+  uint32_t startMillis = 0;
+  uint32_t startEpoch = 0;
+  if (bytes.size() < TraceRecorder::HEADER_SIZE ||
+      !TraceRecorder::decodeHeader(bytes.data(), sensorType, startMillis, startEpoch)) {
+    fprintf(stderr, "%s: not a sensor trace (bad header)\n", tracePath);
+    return 1;
+  }
+
+  std::vector<Sample> samples;
+  unsigned long perChannel[TraceRecorder::CHANNEL_COUNT] = {0};
+  size_t pos = TraceRecorder::HEADER_SIZE;
+  for (; pos + TraceRecorder::RECORD_SIZE <= bytes.size(); pos += TraceRecorder::RECORD_SIZE) {
+    Sample sample;
+    TraceRecorder::decodeRecord(bytes.data() + pos, sample.offset, sample.channel, sample.value);
+    if (sample.channel >= TraceRecorder::CHANNEL_COUNT) continue;
+    perChannel[sample.channel]++;
+    samples.push_back(sample);
+  }
+  if (pos != bytes.size()) {
+    fprintf(stderr, "Warning: ignoring %u trailing bytes (truncated record)\n", (unsigned)(bytes.size() - pos));
+  }
+  if (samples.empty()) {
+    fprintf(stderr, "%s: trace has no samples\n", tracePath);
+    return 1;
+  }
+
+  uint32_t durationMs = samples.back().offset;
+  printf("Trace: %s, %u samples over %.1f min (mq4 %lu, pir %lu, temperature %lu, humidity %lu)\n",
+         sensorType, (unsigned)samples.size(), durationMs / 60000.0,
+         perChannel[TraceRecorder::CHANNEL_MQ4_RAW], perChannel[TraceRecorder::CHANNEL_PIR_PIN],
+         perChannel[TraceRecorder::CHANNEL_DHT_TEMPERATURE], perChannel[TraceRecorder::CHANNEL_DHT_HUMIDITY]);
+
+  // === Placa aprovisionada con el sensor de la traza ===
+  NativeHost::Board board;
+  board.prefs["device_config"]["ssid"] = "replay";
+  board.prefs["device_config"]["password"] = "replay";
+  board.prefs["device_config"]["deviceId"] = "replay";
+  board.prefs["device_config"]["sensorType"] = sensorType;
+
+  ReplayTransport transport;
+  if (outPath) {
+    transport.out = fopen(outPath, "w");
+    if (!transport.out) {
+      fprintf(stderr, "Cannot write %s\n", outPath);
+      return 1;
+    }
+  }
+  board.mqtt = &transport;
+
+  NativeHost::selectBoard(&board);
+  NativeHost::setVirtualTime(true);
+  NativeHost::setEpochBase((startEpoch ? startEpoch : DEFAULT_EPOCH) - startMillis / 1000);
+  NativeHost::setSerialEnabled(verbose);
+
+  // Estado de los pines al empezar a grabar: primer valor de cada canal
+  bool seen[TraceRecorder::CHANNEL_COUNT] = {false};
+  for (const Sample& sample : samples) {
+    if (!seen[sample.channel]) {
+      applySample(board, sample);
+      seen[sample.channel] = true;
+    }
+  }
+
+  auto wallStart = std::chrono::steady_clock::now();
+
+  // === setup() de main.cpp ===
+  delay(1000);
+  Storage::init();
+  Sensor::init();
+  SamplingScheduler::init(Sensor::getSensorType());
+  AlertEvaluator::init(Sensor::getSensorType());
+  OperationMode::start();
+
+  // Grabación iniciada más tarde que el arranque: saltar hasta el primer registro
+  if (millis() < startMillis) {
+    NativeHost::advanceMillis(startMillis - millis());
+  }
+
+  // === loop() de main.cpp ===
+  size_t next = 0;
+  unsigned long endMillis = startMillis + durationMs + LOOP_DELAY_MS;
+  unsigned long iterations = 0;
+  while (millis() <= endMillis) {
+    while (next < samples.size() && startMillis + samples[next].offset <= millis()) {
+      applySample(board, samples[next++]);
+    }
+
+    Sensor::checkPIRContinuously();
+    OperationMode::loop();
+    delay(LOOP_DELAY_MS);
+    iterations++;
+  }
+
+  double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+  double simulatedMs = (double)(endMillis - startMillis);
+
+  if (transport.out) fclose(transport.out);
+
+  printf("Replayed %lu loop iterations: published %lu, alerts %lu", iterations, transport.published, transport.alerts);
+  if (transport.published > 1) {
+    printf(", mean interval %.1f s",
+           (transport.lastPublish - transport.firstPublish) / 1000.0 / (transport.published - 1));
+  }
+  printf("\n");
+  printf("Wall time %.1f ms, %.0fx faster than real time\n", wallMs, wallMs > 0 ? simulatedMs / wallMs : 0.0);
+
+  return 0;
+}
@@ -0,0 +1,160 @@
+// main.cpp (soak)
+// ========================================
+// Soak test nativo del bucle de operación: ejecuta OperationMode::loop()
+// durante semanas de tiempo simulado y falla (exit 1) si una iteración en
+// régimen estable asigna memoria o si el bloque libre más grande se reduce.
+//
+// Uso:
+//   pio run -e native_soak && .pio/build/native_soak/program --sensor mq4 --days 14
+
+#include "allocTracker.h"
+#include "alertEvaluator.h"
+#include "operationMode.h"
+#include "samplingScheduler.h"
+#include "sensor.h"
+#include "storage.h"
+
+#include "../fleet_sim/syntheticTrace.h"
+
+#include <NativeHost.h>
+#include <config.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+const unsigned long LOOP_DELAY_MS = 100;  // delay(100) de loop() en main.cpp
+
+// Broker en memoria: siempre conectado, solo cuenta (no asigna)
+class LoopbackTransport : public NativeHost::MqttTransport {
+public:
+  unsigned long published = 0;
+  unsigned long alerts = 0;
+  size_t largestPayload = 0;
+
+  bool connect(const char* clientId, const char* username, const char* password) override {
+    (void)clientId; (void)username; (void)password;
+    return true;
+  }
+  bool connected() override { return true; }
+  bool publish(const char* topic, const uint8_t* payload, size_t length, bool retained) override {
+    (void)payload; (void)retained;
+    if (strstr(topic, "/alerts")) alerts++;
+    else published++;
+    if (length > largestPayload) largestPayload = length;
+    return true;
+  }
+  void loop() override {}
+  int state() override { return 0; }
+};
+
+void printUsage() {
+  printf("Usage: soak [--sensor dht22|mq4|pir] [--days <n>] [--warmup-hours <n>] [--seed <n>]\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const char* sensorType = "dht22";
+  unsigned long days = 14;
+  unsigned long warmupHours = 1;
+  uint32_t seed = 1;
+
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 >= argc) {
+      printUsage();
+      return 2;
+    }
+    if (strcmp(argv[i], "--sensor") == 0) sensorType = argv[++i];
+    else if (strcmp(argv[i], "--days") == 0) days = strtoul(argv[++i], nullptr, 10);
+    else if (strcmp(argv[i], "--warmup-hours") == 0) warmupHours = strtoul(argv[++i], nullptr, 10);
+    else if (strcmp(argv[i], "--seed") == 0) seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    else {
+      printUsage();
+      return 2;
+    }
+  }
+
+  // Placa aprovisionada y tiempo virtual: delay() avanza el reloj sin dormir
+  static NativeHost::Board board;
+  static LoopbackTransport transport;
+  auto& prefs = board.prefs["device_config"];
+  prefs["ssid"] = "soak";
+  prefs["password"] = "soak";
+  prefs["deviceId"] = "5f1ee7000000000000000001";
+  prefs["sensorType"] = sensorType;
+  board.mqtt = &transport;
+
+  NativeHost::selectBoard(&board);
+  NativeHost::setVirtualTime(true);
+  NativeHost::setEpochBase(1700000000);
+  NativeHost::setSerialEnabled(false);
+
+  SyntheticTrace trace(sensorType, seed);
+  trace.apply(board, NativeHost::currentEpoch());
+
+  // Misma secuencia que setup() en modo operación
+  Storage::init();
+  Sensor::init();
+  SamplingScheduler::init(Sensor::getSensorType());
+  AlertEvaluator::init(Sensor::getSensorType());
+  OperationMode::start();
+
+  const unsigned long long iterationsPerHour = 3600000ULL / LOOP_DELAY_MS;
+  const unsigned long long warmupIterations = warmupHours * iterationsPerHour;
+  const unsigned long long totalIterations = days * 24ULL * iterationsPerHour;
+
+  uint32_t baselineAllocs = 0;
+  uint32_t baselineLargestBlock = 0;
+  uint32_t allocatingIterations = 0;
+  unsigned long long firstAllocatingIteration = 0;
+
+  printf("Soak: %s, %lu simulated days (%llu iterations), warm-up %lu h\n", sensorType, days,
+         totalIterations, warmupHours);
+
+  for (unsigned long long iteration = 0; iteration < totalIterations; iteration++) {
+    // Nueva muestra de la traza cada segundo simulado
+    if (iteration % 10 == 0) trace.apply(board, NativeHost::currentEpoch());
+
+    uint32_t before = AllocTracker::getAllocCount();
+
+    Sensor::checkPIRContinuously();
+    OperationMode::loop();
+    delay(LOOP_DELAY_MS);
+
+    if (iteration == warmupIterations) {
+      baselineAllocs = AllocTracker::getAllocCount();
+      baselineLargestBlock = AllocTracker::getLargestFreeBlock();
+    } else if (iteration > warmupIterations && AllocTracker::getAllocCount() != before) {
+      if (allocatingIterations == 0) firstAllocatingIteration = iteration;
+      allocatingIterations++;
+    }
+
+    if ((iteration + 1) % (24 * iterationsPerHour) == 0) {
+      printf("day %3llu: allocs %u, live %zu B, largest free block %u B, published %lu, alerts %lu\n",
+             (iteration + 1) / (24 * iterationsPerHour), AllocTracker::getAllocCount(),
+             AllocTracker::getLiveBytes(), AllocTracker::getLargestFreeBlock(), transport.published,
+             transport.alerts);
+      fflush(stdout);
+    }
+  }
+
+  uint32_t steadyAllocs = AllocTracker::getAllocCount() - baselineAllocs;
+  uint32_t largestBlock = AllocTracker::getLargestFreeBlock();
+  bool failed = false;
+
+  printf("\nSteady state: %u allocations in %u iterations", steadyAllocs, allocatingIterations);
+  if (allocatingIterations > 0) {
+    printf(" (first at simulated hour %.2f)", firstAllocatingIteration / (double)iterationsPerHour);
+    failed = true;
+  }
+  printf("\nLargest free block: %u B (baseline %u B)\n", largestBlock, baselineLargestBlock);
+  if (largestBlock < baselineLargestBlock) failed = true;
+  printf("Largest payload: %zu B, published %lu, alerts %lu\n", transport.largestPayload, transport.published,
+         transport.alerts);
+
+  printf("%s\n", failed ? "SOAK FAILED" : "SOAK PASSED");
+  return failed ? 1 : 0;
+}
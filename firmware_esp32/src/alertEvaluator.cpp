@@ -0,0 +1,107 @@
+// alertEvaluator.cpp
+// ========================================
+
+#include "alertEvaluator.h"
+#include <ArduinoJson.h>
+
+String AlertEvaluator::sensorType = "";
+String AlertEvaluator::metric = "";
+float AlertEvaluator::threshold = 0.0f;
+float AlertEvaluator::hysteresis = 0.0f;
+bool AlertEvaluator::enabled = false;
+bool AlertEvaluator::alertActive = false;
+AlertEvaluator::Transition AlertEvaluator::queue[ALERT_QUEUE_SIZE];
+int AlertEvaluator::queueHead = 0;
+int AlertEvaluator::queueCount = 0;
+
+void AlertEvaluator::init(const String& type) {
+  sensorType = type;
+  alertActive = false;
+  discardPending();
+  
+  // Mismos umbrales que SENSOR_THRESHOLDS (mq4.gas, dht22.temperature)
+  if (type == "mq4") {
+    metric = "gas";
+    threshold = THRESHOLD_MQ4_GAS;
+    hysteresis = ALERT_HYSTERESIS_MQ4_GAS;
+    enabled = true;
+  } else if (type == "dht22") {
+    metric = "temperature";
+    threshold = THRESHOLD_DHT22_TEMPERATURE;
+    hysteresis = ALERT_HYSTERESIS_DHT22_TEMPERATURE;
+    enabled = true;
+  } else {
+    enabled = false;
+  }
+  
+  if (enabled) {
+    Serial.println("On-device alert: " + metric + " > " + String(threshold) +
+                   " (hysteresis " + String(hysteresis) + ")");
+  }
+}
+
+bool AlertEvaluator::evaluate(float value) {
+  if (!enabled) return false;
+  
+  if (!alertActive && value > threshold) {
+    alertActive = true;
+  } else if (alertActive && value < threshold - hysteresis) {
+    alertActive = false;
+  } else {
+    return false;
+  }
+  
+  // Cambio de estado: se encola para publicar de inmediato. Sin broker puede
+  // llegar una desactivación antes de publicar la activación y ambas deben salir
+  if (queueCount == ALERT_QUEUE_SIZE) {
+    // Llena: se descarta el episodio más antiguo (dos transiciones consecutivas)
+    // para que el servicio siga viendo activaciones y desactivaciones alternas
+    queueHead = (queueHead + 2) % ALERT_QUEUE_SIZE;
+    queueCount -= 2;
+    Serial.println("Alert queue full, dropping oldest transitions");
+  }
+  
+  Transition& transition = queue[(queueHead + queueCount) % ALERT_QUEUE_SIZE];
+  transition.raised = alertActive;
+  transition.value = value;
+  WiFiManager::getCurrentTimestamp(transition.timestamp, sizeof(transition.timestamp));
+  queueCount++;
+  
+  Serial.printf("%s - %s: %.1f (threshold %.1f)\n",
+                alertActive ? "ALERT RAISED" : "ALERT CLEARED", metric.c_str(), value, threshold);
+  return true;
+}
+
+bool AlertEvaluator::hasPendingAlert() {
+  return queueCount > 0;
+}
+
+size_t AlertEvaluator::formatAlert(char* buffer, size_t size) {
+  if (queueCount == 0) return 0;
+  const Transition& transition = queue[queueHead];
+  
+  StaticJsonDocument<256> doc;
+  doc["sensorType"] = sensorType;
+  doc["metric"] = metric;
+  doc["value"] = round(transition.value * 10) / 10.0;
+  doc["threshold"] = threshold;
+  doc["state"] = transition.raised ? "raised" : "cleared";
+  doc["timestamp"] = (const char*)transition.timestamp;
+  
+  return serializeJson(doc, buffer, size);
+}
+
+void AlertEvaluator::markPublished() {
+  if (queueCount == 0) return;
+  queueHead = (queueHead + 1) % ALERT_QUEUE_SIZE;
+  queueCount--;
+}
+
+void AlertEvaluator::discardPending() {
+  queueHead = 0;
+  queueCount = 0;
+}
+
+bool AlertEvaluator::isAlertActive() {
+  return alertActive;
+}
@@ -0,0 +1,43 @@
+// alertEvaluator.h
+// ========================================
+
+#ifndef ALERT_EVALUATOR_H
+#define ALERT_EVALUATOR_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "wifiManager.h"
+
+// Evaluación de umbrales en el dispositivo con histéresis.
+// La alerta se activa al superar el umbral y solo se desactiva cuando el
+// valor baja de (umbral - histéresis), evitando oscilaciones en el borde.
+class AlertEvaluator {
+private:
+  // Transición pendiente de publicar, con la hora en que ocurrió
+  struct Transition {
+    bool raised;
+    float value;
+    char timestamp[WiFiManager::TIMESTAMP_SIZE];
+  };
+  
+  static String sensorType;
+  static String metric;
+  static float threshold;
+  static float hysteresis;
+  static bool enabled;
+  static bool alertActive;
+  static Transition queue[ALERT_QUEUE_SIZE];  // Cola circular sin heap
+  static int queueHead;
+  static int queueCount;
+
+public:
+  static void init(const String& type);
+  static bool evaluate(float value);   // true si cambió el estado de la alerta
+  static bool hasPendingAlert();
+  static size_t formatAlert(char* buffer, size_t size);
+  static void markPublished();        // Saca la transición más antigua
+  static void discardPending();       // Hojas ESP-NOW: la alerta la genera el servicio
+  static bool isAlertActive();
+};
+
+#endif
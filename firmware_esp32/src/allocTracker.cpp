@@ -0,0 +1,170 @@
+// allocTracker.cpp
+// ========================================
+
+#include "allocTracker.h"
+
+#ifdef ALLOC_TRACKING
+
+#include <Arduino.h>
+#include <stdlib.h>
+#include <new>
+
+#ifdef NATIVE_BUILD
+#include <malloc.h>
+#else
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
+extern "C" {
+void* __real_malloc(size_t size);
+void __real_free(void* ptr);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+}
+
+namespace {
+
+// Contadores atómicos: en ESP32 otras tareas (WiFi, lwIP) también asignan
+volatile uint32_t allocCount = 0;
+volatile uint32_t freeCount = 0;
+volatile size_t liveBytes = 0;
+volatile size_t peakLiveBytes = 0;
+
+#ifdef NATIVE_BUILD
+// Heap simulado para estimar el bloque libre más grande en el host
+const size_t SIMULATED_HEAP_SIZE = 320 * 1024;
+
+size_t allocatedSize(void* ptr) {
+  return malloc_usable_size(ptr);
+}
+
+bool isTrackedContext() {
+  return true;
+}
+#else
+volatile TaskHandle_t trackedTask = nullptr;
+
+size_t allocatedSize(void* ptr) {
+  return heap_caps_get_allocated_size(ptr);
+}
+
+bool isTrackedContext() {
+  return trackedTask == nullptr || xTaskGetCurrentTaskHandle() == trackedTask;
+}
+#endif
+
+void recordAlloc(void* ptr) {
+  if (!ptr || !isTrackedContext()) return;
+  __atomic_fetch_add(&allocCount, 1, __ATOMIC_RELAXED);
+  size_t live = __atomic_add_fetch(&liveBytes, allocatedSize(ptr), __ATOMIC_RELAXED);
+  if (live > peakLiveBytes) peakLiveBytes = live;
+}
+
+void recordFree(void* ptr) {
+  if (!ptr || !isTrackedContext()) return;
+  __atomic_fetch_add(&freeCount, 1, __ATOMIC_RELAXED);
+  size_t size = allocatedSize(ptr);
+  // Bloques asignados antes de empezar a contar no deben desbordar el contador
+  if (size <= liveBytes) __atomic_fetch_sub(&liveBytes, size, __ATOMIC_RELAXED);
+}
+
+}  // namespace
+
+extern "C" {
+
+void* __wrap_malloc(size_t size) {
+  void* ptr = __real_malloc(size);
+  recordAlloc(ptr);
+  return ptr;
+}
+
+void __wrap_free(void* ptr) {
+  recordFree(ptr);
+  __real_free(ptr);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+  void* ptr = __real_calloc(count, size);
+  recordAlloc(ptr);
+  return ptr;
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+  recordFree(ptr);
+  void* result = __real_realloc(ptr, size);
+  recordAlloc(result);
+  return result;
+}
+
+}  // extern "C"
+
+#ifdef NATIVE_BUILD
+// En el host libstdc++ es una biblioteca dinámica y su operator new no pasa por
+// --wrap; se reemplaza aquí. En ESP32 operator new llama a malloc (ya envuelto).
+void* operator new(size_t size) {
+  void* ptr = __wrap_malloc(size ? size : 1);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  __wrap_free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  __wrap_free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  __wrap_free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+  __wrap_free(ptr);
+}
+#endif
+
+void AllocTracker::trackCurrentTask() {
+#ifndef NATIVE_BUILD
+  trackedTask = xTaskGetCurrentTaskHandle();
+#endif
+}
+
+uint32_t AllocTracker::getAllocCount() {
+  return allocCount;
+}
+
+uint32_t AllocTracker::getFreeCount() {
+  return freeCount;
+}
+
+size_t AllocTracker::getLiveBytes() {
+  return liveBytes;
+}
+
+size_t AllocTracker::getPeakLiveBytes() {
+  return peakLiveBytes;
+}
+
+uint32_t AllocTracker::getLargestFreeBlock() {
+#ifdef NATIVE_BUILD
+  // Estimación pesimista: el pico de bytes vivos nunca vuelve a quedar libre
+  return (uint32_t)(SIMULATED_HEAP_SIZE - peakLiveBytes);
+#else
+  return heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+#endif
+}
+
+void AllocTracker::printStats(const char* label) {
+  Serial.printf("[alloc] %s: allocs %u, frees %u, live %u B\n", label, (unsigned)allocCount,
+                (unsigned)freeCount, (unsigned)liveBytes);
+  Serial.printf("[alloc] largest free block %u B\n", (unsigned)getLargestFreeBlock());
+}
+
+#endif
@@ -0,0 +1,24 @@
+// allocTracker.h
+// ========================================
+
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Contador de asignaciones de heap (wrappers de malloc/free).
+// Solo activo con -D ALLOC_TRACKING y los flags -Wl,--wrap de platformio.ini
+// (entornos esp32dev_alloc y native_soak).
+class AllocTracker {
+public:
+  static void trackCurrentTask();    // En ESP32 solo cuenta la tarea del loop
+  static uint32_t getAllocCount();
+  static uint32_t getFreeCount();
+  static size_t getLiveBytes();
+  static size_t getPeakLiveBytes();
+  static uint32_t getLargestFreeBlock();
+  static void printStats(const char* label);
+};
+
+#endif
@@ -7,6 +7,12 @@
 // Configuración del sensor (cambiar según el dispositivo)
 #define SENSOR_TYPE "dht22"  // Opciones: "dht22", "mq4", "pir"
 
+// Rol del nodo (se puede sobrescribir en flash, clave "role"):
+//   "direct"  WiFi + MQTT propios
+//   "gateway" además reenvía por MQTT las lecturas ESP-NOW de las hojas cercanas
+//   "leaf"    sin WiFi ni MQTT: envía sus lecturas al gateway por ESP-NOW
+#define DEVICE_ROLE "direct"
+
 // Pines de sensores
 #define DHT_PIN 2
 #define DHT_TYPE DHT22
@@ -30,15 +36,115 @@
 #define MQTT_USERNAME "xqeeyahu:xqeeyahu"  // Corregido: formato usuario:vhost
 #define MQTT_PASSWORD "6YLK3yxPzxY-8XVxtCtVVkkdpup0Eq45"
 
+// MQTT en la LAN (servicio mosquitto de docker-compose). Opcional: vacío = solo CloudAMQP.
+// Al activarlo, telemetry-service debe escuchar el mismo broker (MQTT_LAN_* en su
+// .env, ver services/telemetry-service/.env.example); si no, lo publicado ahí se pierde.
+// Tiene prioridad sobre CloudAMQP; si no responde se usa la nube
+#define MQTT_LAN_HOST ""                // p. ej. "192.168.100.34"
+#define MQTT_LAN_PORT 1883
+// Usuario de la flota en mosquitto/config/acl; la contraseña debe coincidir con
+// MQTT_LAN_DEVICE_PASSWORD de mosquitto/.env (el broker no admite anónimos)
+#define MQTT_LAN_USERNAME "esp32"
+#define MQTT_LAN_PASSWORD "esp32-lan-cambiar"
+
+// Comandos "trace" por MQTT (devices/{id}/trace/cmd): solo se atienden en brokers
+// con usuario y con ACL que reserve la escritura del topic a un operador. La ACL de
+// mosquitto/config/acl lo hace; en CloudAMQP toda la flota comparte usuario y
+// cualquiera con las credenciales de un equipo podría arrancar trazas en otros
+#define MQTT_LAN_TRACE_COMMANDS true
+#define MQTT_CLOUD_TRACE_COMMANDS false
+
+// Selección de broker por latencia
+#define MQTT_PROBE_INTERVAL 300000    // Medir CONNACK y PINGRESP de cada broker cada 5 minutos
+#define MQTT_PROBE_TIMEOUT 1000       // Sin respuesta en 1 s = broker inalcanzable
+#define MQTT_PROBE_CONNECT_TIMEOUT 300  // Apertura TCP del sondeo (único paso que bloquea)
+#define MQTT_PROBE_SPIN 20            // ms que un paso espera la respuesta antes de ceder el loop
+#define MQTT_SWITCH_MARGIN 20         // ms de mejora mínima para cambiar de broker en caliente
+#define MQTT_RETRY_BACKOFF 60000      // Un broker caído no se reintenta antes de 1 minuto
+
+// Shards de ingesta: con MQTT_SHARD_COUNT > 0 las lecturas, alertas y backlog se publican en
+// shard/{n}/devices/{id}/..., n = FNV-1a(deviceId) % MQTT_SHARD_COUNT (espejo en
+// telemetry-service src/utils/deviceTopic.ts). Se puede aprovisionar por dispositivo ("prov shards")
+#define MQTT_SHARD_COUNT 0              // 0 = topics sin prefijo (devices/{id}/...)
+
+// MQTT 5 (mqtt5Client.h; con brokers solo 3.1.1 se conecta sin propiedades)
+#define MQTT_RECEIVE_MAXIMUM 64         // Mensajes QoS>0 en vuelo que aceptamos del broker
+#define MQTT_EXPIRY_SENSORS 3600        // s que el broker retiene una lectura sin entregar
+#define MQTT_EXPIRY_ALERTS 3600
+#define MQTT_EXPIRY_BACKLOG 86400       // El backlog ya llega tarde: se le da un día
+#define MQTT_EXPIRY_TRACE 600
+#define MQTT_EXPIRY_SELFTEST 60
+
 // NTP
 #define NTP_SERVER "pool.ntp.org"
 #define UTC_OFFSET_SECONDS 0
 
 // Timeouts
-#define WIFI_TIMEOUT 10000
+#define WIFI_TIMEOUT 10000              // Por intento de asociación (uno por AP candidato)
 #define HTTP_TIMEOUT 5000
 #define MQTT_TIMEOUT 5000
 
+// Perfiles WiFi y roaming (wifiManager.h)
+#define WIFI_MAX_PROFILES 4             // Redes guardadas: la del portal/provisión + 3 extra
+#define WIFI_MAX_CANDIDATES 8           // AP conocidos que se consideran por escaneo
+#define WIFI_RETRY_INTERVAL 30000       // ms entre reintentos sin conexión (antes: cada vuelta)
+#define WIFI_ROAM_CHECK_INTERVAL 10000  // ms entre lecturas del RSSI del AP actual
+#define WIFI_ROAM_RSSI_THRESHOLD -75    // dBm: por debajo se busca un AP mejor
+#define WIFI_ROAM_SCAN_INTERVAL 60000   // ms mínimos entre escaneos de roaming
+#define WIFI_ROAM_HYSTERESIS 8          // dB que debe ganar el AP nuevo para cambiar
+
+// Muestreo adaptativo (milisegundos)
+#define SENSOR_INTERVAL 60000           // Intervalo inicial (antes fijo a 1 minuto)
+#define SAMPLING_MIN_INTERVAL 5000      // Piso: señal dinámica o cerca del umbral
+#define SAMPLING_MAX_INTERVAL 300000    // Techo: señal plana
+#define SAMPLING_PROXIMITY_DHT22 1.0f    // "Cerca del umbral" = a menos de 1 °C
+#define SAMPLING_PROXIMITY_MQ4 10.0f     // "Cerca del umbral" = a menos de 10 ppm
+#define SAMPLING_RATE_DHT22 0.5f        // °C por minuto considerado dinámico
+#define SAMPLING_RATE_MQ4 20.0f         // ppm por minuto considerado dinámico
+// PIR es booleano: cualquier cambio de estado cuenta como dinámico (sin tasa)
+
+// Umbrales de alerta (espejo de SENSOR_THRESHOLDS en telemetry-service)
+#define THRESHOLD_MQ4_GAS 50.0f
+#define THRESHOLD_DHT22_TEMPERATURE 25.0f
+
+// Alertas en el dispositivo
+#define ALERT_HYSTERESIS_MQ4_GAS 5.0f           // Se desactiva por debajo de 45 ppm
+#define ALERT_HYSTERESIS_DHT22_TEMPERATURE 0.5f // Se desactiva por debajo de 24.5 °C
+#define ALERT_QUEUE_SIZE 4                      // Transiciones sin publicar (par: activar + desactivar)
+#define DHT22_MIN_SAMPLE_INTERVAL 2000          // El DHT22 no admite lecturas más rápidas
+
+// ESP-NOW (gateway y hojas)
+#define ESPNOW_BATCH_INTERVAL 2000      // El gateway publica lo recibido cada 2 s...
+#define ESPNOW_BATCH_SIZE 8             // ...o en cuanto acumula 8 lecturas
+#define ESPNOW_GATEWAY_QUEUE_SIZE 32    // Lecturas en espera sin broker (se descarta la más antigua)
+#define ESPNOW_SEND_TIMEOUT 50          // ms de espera al ACK de capa MAC
+#define ESPNOW_DISCOVERY_TIMEOUT 200    // ms de escucha de OFFER por canal
+#define ESPNOW_MAX_CHANNEL 13
+#define ESPNOW_MAX_SEND_FAILURES 3      // Envíos fallidos seguidos antes de buscar gateway de nuevo
+#define ESPNOW_MAX_LEAVES 6             // Hojas aprovisionadas por gateway (pares cifrados del ESP-NOW)
+// Claves ESP-NOW de la flota (16 caracteres): la PMK cifra la LMK y la LMK el unicast
+// hoja-gateway. Iguales en gateway y hojas; "prov espnowkey" sustituye la LMK
+#define ESPNOW_PMK "pmk-cambiar-0001"
+#define ESPNOW_LMK "lmk-cambiar-0001"
+
+// Backlog offline comprimido (delta-of-delta + XOR, ver timeSeriesBlock.h)
+#define BACKLOG_BLOCK_SIZE 1024   // Un bloque = un mensaje MQTT
+#define BACKLOG_BLOCK_COUNT 8     // 8 KB de RAM (~80 h de DHT22 al intervalo máximo)
+
+// Aprovisionamiento por serial ("prov ...", ver provisioning.h)
+#define PROVISION_SELFTEST_TIMEOUT 5000 // ms de espera al eco del mensaje de prueba
+
+// Grabación de trazas de sensores (LittleFS en la partición spiffs)
+#define TRACE_FILE_PATH "/sensor_trace.bin"
+#define TRACE_MAX_BYTES 262144          // 256 KB = ~29000 registros de 9 bytes
+// checkAlerts() lee el MQ4 en cada vuelta (~10 Hz): grabando cada cambio, el ruido
+// del ADC llenaba los 256 KB en ~48 min. Solo se graba al salir de la banda muerta
+// alrededor del último valor grabado (12 cuentas ~ 3 ppm, bajo la histéresis de 5)
+#define TRACE_DEADBAND_MQ4_RAW 12
+#define TRACE_FLUSH_INTERVAL 5000       // Volcar el buffer a flash cada 5 s
+#define TRACE_UPLOAD_BYTES_PER_LINE 48  // Línea "TRACE <offset> <hex>" < 256 bytes (buffer MQTT por defecto)
+#define TRACE_UPLOAD_LINES_PER_LOOP 8
+
 // PIR Configuration
 #define PIR_STABILIZATION_TIME 120000  // 2 minutos en milisegundos
 #define PIR_LED_DURATION 3000           // 3 segundos que permanece encendido el LED
@@ -0,0 +1,180 @@
+// espNowGateway.cpp
+// ========================================
+
+#include "espNowGateway.h"
+#include "mqttClient.h"
+#include "storage.h"
+
+RadioTransport* EspNowGateway::radio = nullptr;
+EspNowGateway::Leaf EspNowGateway::leaves[ESPNOW_MAX_LEAVES];
+int EspNowGateway::leafCount = 0;
+EspNowGateway::PendingReading EspNowGateway::pending[ESPNOW_GATEWAY_QUEUE_SIZE];
+int EspNowGateway::pendingHead = 0;
+int EspNowGateway::pendingCount = 0;
+unsigned long EspNowGateway::lastFlush = 0;
+unsigned long EspNowGateway::relayed = 0;
+unsigned long EspNowGateway::dropped = 0;
+unsigned long EspNowGateway::rejected = 0;
+char EspNowGateway::payloadBuffer[Sensor::PAYLOAD_BUFFER_SIZE];
+
+bool EspNowGateway::init() {
+  radio = RadioTransport::platform();
+  if (!radio || !radio->begin(WiFi.channel())) {
+    Serial.println("ESP-NOW gateway unavailable");
+    radio = nullptr;
+    return false;
+  }
+  
+  uint8_t lmk[RadioTransport::KEY_SIZE];
+  Storage::loadEspNowKey(lmk);
+  if (!radio->setKeys((const uint8_t*)ESPNOW_PMK, lmk)) {
+    Serial.println("ESP-NOW gateway unavailable: encryption keys not set");
+    radio = nullptr;
+    return false;
+  }
+  loadLeaves();
+  
+  pendingHead = 0;
+  pendingCount = 0;
+  lastFlush = millis();
+  
+  Serial.printf("ESP-NOW gateway listening on channel %u for %d leaves\n",
+                (unsigned)radio->getChannel(), leafCount);
+  return true;
+}
+
+void EspNowGateway::loadLeaves() {
+  leafCount = 0;
+  for (uint8_t slot = 0; slot < ESPNOW_MAX_LEAVES; slot++) {
+    String deviceId;
+    Leaf& leaf = leaves[leafCount];
+    if (!Storage::loadEspNowLeaf(slot, leaf.mac, deviceId)) continue;
+    
+    strncpy(leaf.deviceId, deviceId.c_str(), sizeof(leaf.deviceId) - 1);
+    leaf.deviceId[sizeof(leaf.deviceId) - 1] = '\0';
+    
+    // Par cifrado desde el arranque: la primera READING de la hoja ya se descifra
+    if (!radio->addPeer(leaf.mac)) {
+      Serial.printf("ESP-NOW leaf %s not registered as peer\n", leaf.deviceId);
+      continue;
+    }
+    leafCount++;
+  }
+  
+  if (leafCount == 0) {
+    Serial.println("ESP-NOW gateway: no leaves provisioned (prov leaf), nothing will be relayed");
+  }
+}
+
+const EspNowGateway::Leaf* EspNowGateway::findLeaf(const uint8_t* mac, const char* deviceId) {
+  for (int i = 0; i < leafCount; i++) {
+    if (memcmp(leaves[i].mac, mac, RadioTransport::MAC_SIZE) == 0) {
+      return strcasecmp(leaves[i].deviceId, deviceId) == 0 ? &leaves[i] : nullptr;
+    }
+  }
+  return nullptr;
+}
+
+void EspNowGateway::loop() {
+  if (!radio) return;
+  
+  uint8_t mac[RadioTransport::MAC_SIZE];
+  uint8_t frame[RadioTransport::MAX_FRAME_SIZE];
+  size_t length;
+  while ((length = radio->receive(mac, frame, sizeof(frame))) > 0) {
+    handleFrame(mac, frame, length);
+  }
+  
+  // Lote por tamaño o por tiempo: menos vueltas de publish sin retrasar mucho la lectura
+  if (pendingCount > 0 &&
+      (pendingCount >= ESPNOW_BATCH_SIZE || millis() - lastFlush >= ESPNOW_BATCH_INTERVAL)) {
+    flush();
+  }
+}
+
+unsigned long EspNowGateway::getRelayedCount() {
+  return relayed;
+}
+
+unsigned long EspNowGateway::getRejectedCount() {
+  return rejected;
+}
+
+void EspNowGateway::handleFrame(const uint8_t* mac, const uint8_t* data, size_t length) {
+  uint8_t type = EspNowProtocol::getFrameType(data, length);
+  const char* deviceId = nullptr;
+  char discoverId[2 * EspNowProtocol::DEVICE_ID_SIZE + 1];
+  EspNowProtocol::Reading reading;
+  
+  if (type == EspNowProtocol::FRAME_DISCOVER && EspNowProtocol::decodeDiscover(data, length, discoverId)) {
+    deviceId = discoverId;
+  } else if (type == EspNowProtocol::FRAME_READING && EspNowProtocol::decodeReading(data, length, reading)) {
+    deviceId = reading.deviceId;
+  } else {
+    return;
+  }
+  
+  // La MAC de origen se puede falsificar, pero entonces la READING no llega
+  // cifrada con la LMK del par y ESP-NOW la descarta antes de este punto
+  const Leaf* leaf = findLeaf(mac, deviceId);
+  if (!leaf) {
+    rejected++;
+    Serial.printf("ESP-NOW frame from unprovisioned %02x:%02x:%02x:%02x:%02x:%02x (%s) ignored\n",
+                  mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], deviceId);
+    return;
+  }
+  
+  if (type == EspNowProtocol::FRAME_DISCOVER) {
+    // Broadcast: la hoja aún no tiene al gateway como par cifrado
+    uint8_t offer[EspNowProtocol::MAX_FRAME_SIZE];
+    size_t offerLength = EspNowProtocol::encodeOffer(offer, radio->getChannel(), leaf->deviceId);
+    radio->send(RadioTransport::BROADCAST_MAC, offer, offerLength);
+    Serial.printf("ESP-NOW leaf %s discovered gateway\n", leaf->deviceId);
+  } else {
+    queueReading(reading);
+  }
+}
+
+void EspNowGateway::queueReading(const EspNowProtocol::Reading& reading) {
+  // Cola llena (broker caído): se sacrifica la lectura más antigua
+  if (pendingCount == ESPNOW_GATEWAY_QUEUE_SIZE) {
+    pendingHead = (pendingHead + 1) % ESPNOW_GATEWAY_QUEUE_SIZE;
+    pendingCount--;
+    dropped++;
+    Serial.printf("ESP-NOW relay queue full, dropped %lu readings so far\n", dropped);
+  }
+  
+  // Las hojas no tienen NTP: la hora es la de recepción en el gateway
+  PendingReading& entry = pending[(pendingHead + pendingCount) % ESPNOW_GATEWAY_QUEUE_SIZE];
+  entry.reading = reading;
+  WiFiManager::getCurrentTimestamp(entry.timestamp, sizeof(entry.timestamp));
+  pendingCount++;
+}
+
+void EspNowGateway::flush() {
+  lastFlush = millis();
+  int published = 0;
+  
+  while (pendingCount > 0) {
+    PendingReading& entry = pending[pendingHead];
+    const EspNowProtocol::Reading& reading = entry.reading;
+    
+    size_t length = Sensor::formatRelayedReading(payloadBuffer, sizeof(payloadBuffer),
+                                                 reading.sensorType, reading.values,
+                                                 reading.valueCount, entry.timestamp);
+    
+    if (length > 0) {
+      // Sin broker: el resto del lote espera a la siguiente vuelta
+      if (!MQTTClient::publishRelayed(reading.deviceId, payloadBuffer)) break;
+      published++;
+    }
+    
+    pendingHead = (pendingHead + 1) % ESPNOW_GATEWAY_QUEUE_SIZE;
+    pendingCount--;
+  }
+  
+  relayed += published;
+  if (published > 0) {
+    Serial.printf("ESP-NOW relayed %d readings (%lu total)\n", published, relayed);
+  }
+}
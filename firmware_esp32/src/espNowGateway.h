@@ -0,0 +1,55 @@
+// espNowGateway.h
+// ========================================
+
+#ifndef ESP_NOW_GATEWAY_H
+#define ESP_NOW_GATEWAY_H
+
+#include "radioTransport.h"
+#include "espNowProtocol.h"
+#include "wifiManager.h"
+#include "sensor.h"
+#include "config.h"
+
+// Rol gateway: mantiene la sesión MQTT y reenvía las lecturas que las hojas
+// mandan por ESP-NOW, cada una en el topic devices/{id}/sensors de la hoja.
+// Las lecturas se acumulan y se publican por lotes. Solo atiende a las hojas
+// aprovisionadas ("prov leaf"): la MAC debe estar en la lista, la trama llegar
+// cifrada con la LMK y el deviceId coincidir con el asignado a esa MAC.
+class EspNowGateway {
+public:
+  static bool init();  // Tras conectar WiFi: ESP-NOW en el canal del AP
+  static void loop();  // Recibe tramas, responde DISCOVER y publica el lote
+  static unsigned long getRelayedCount();
+  static unsigned long getRejectedCount();
+  
+private:
+  struct Leaf {
+    uint8_t mac[RadioTransport::MAC_SIZE];
+    char deviceId[2 * EspNowProtocol::DEVICE_ID_SIZE + 1];
+  };
+  
+  struct PendingReading {
+    EspNowProtocol::Reading reading;
+    char timestamp[WiFiManager::TIMESTAMP_SIZE];
+  };
+  
+  static RadioTransport* radio;
+  static Leaf leaves[ESPNOW_MAX_LEAVES];
+  static int leafCount;
+  static PendingReading pending[ESPNOW_GATEWAY_QUEUE_SIZE];
+  static int pendingHead;
+  static int pendingCount;
+  static unsigned long lastFlush;
+  static unsigned long relayed;
+  static unsigned long dropped;
+  static unsigned long rejected;
+  static char payloadBuffer[Sensor::PAYLOAD_BUFFER_SIZE];
+  
+  static void loadLeaves();
+  static const Leaf* findLeaf(const uint8_t* mac, const char* deviceId);
+  static void handleFrame(const uint8_t* mac, const uint8_t* data, size_t length);
+  static void queueReading(const EspNowProtocol::Reading& reading);
+  static void flush();
+};
+
+#endif
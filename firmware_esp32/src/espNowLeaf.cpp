@@ -0,0 +1,151 @@
+// espNowLeaf.cpp
+// ========================================
+
+#include "espNowLeaf.h"
+#include "storage.h"
+#include "config.h"
+
+RadioTransport* EspNowLeaf::radio = nullptr;
+char EspNowLeaf::deviceId[2 * EspNowProtocol::DEVICE_ID_SIZE + 1];
+uint8_t EspNowLeaf::gatewayMac[RadioTransport::MAC_SIZE];
+uint8_t EspNowLeaf::gatewayChannel = 1;
+bool EspNowLeaf::gatewayKnown = false;
+uint8_t EspNowLeaf::discoveryChannel = 0;
+unsigned long EspNowLeaf::lastDiscovery = 0;
+int EspNowLeaf::consecutiveFailures = 0;
+unsigned long EspNowLeaf::sent = 0;
+uint8_t EspNowLeaf::pendingFrame[EspNowProtocol::MAX_FRAME_SIZE];
+size_t EspNowLeaf::pendingLength = 0;
+
+bool EspNowLeaf::init() {
+  String ssid, password, id;
+  Storage::loadConfig(ssid, password, id);
+  strncpy(deviceId, id.c_str(), sizeof(deviceId) - 1);
+  deviceId[sizeof(deviceId) - 1] = '\0';
+  
+  gatewayKnown = Storage::loadEspNowGateway(gatewayMac, gatewayChannel);
+  discoveryChannel = 0;
+  lastDiscovery = 0;
+  consecutiveFailures = 0;
+  pendingLength = 0;
+  
+  radio = RadioTransport::platform();
+  if (!radio || !radio->begin(gatewayKnown ? gatewayChannel : 1)) {
+    Serial.println("ESP-NOW leaf: radio unavailable");
+    radio = nullptr;
+    return false;
+  }
+  
+  // El gateway solo acepta READING cifradas y de hojas aprovisionadas ("prov leaf"
+  // con esta MAC en el gateway)
+  uint8_t lmk[RadioTransport::KEY_SIZE];
+  uint8_t mac[RadioTransport::MAC_SIZE];
+  Storage::loadEspNowKey(lmk);
+  if (!radio->setKeys((const uint8_t*)ESPNOW_PMK, lmk)) {
+    Serial.println("ESP-NOW leaf: encryption keys not set");
+    radio = nullptr;
+    return false;
+  }
+  radio->getMacAddress(mac);
+  Serial.printf("ESP-NOW leaf %02x:%02x:%02x:%02x:%02x:%02x (%s)\n",
+                mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], deviceId);
+  
+  if (gatewayKnown) {
+    Serial.printf("ESP-NOW leaf: gateway %02x:%02x:%02x:%02x:%02x:%02x on channel %u\n",
+                  gatewayMac[0], gatewayMac[1], gatewayMac[2], gatewayMac[3], gatewayMac[4],
+                  gatewayMac[5], (unsigned)gatewayChannel);
+  } else {
+    Serial.println("ESP-NOW leaf: no gateway cached, scanning channels");
+  }
+  return true;
+}
+
+void EspNowLeaf::loop() {
+  if (!radio) return;
+  
+  if (!gatewayKnown) {
+    discoverStep();
+    return;
+  }
+  
+  if (pendingLength > 0) {
+    deliverPending();
+  }
+}
+
+bool EspNowLeaf::sendReading(const char* sensorType, const float* values, uint8_t count) {
+  if (!radio) return false;
+  
+  pendingLength = EspNowProtocol::encodeReading(pendingFrame, deviceId, sensorType, values, count);
+  if (pendingLength == 0) {
+    Serial.println("ESP-NOW leaf: reading cannot be encoded");
+    return false;
+  }
+  
+  // Sin gateway la lectura queda pendiente hasta que termine el descubrimiento
+  return gatewayKnown && deliverPending();
+}
+
+bool EspNowLeaf::hasGateway() {
+  return gatewayKnown;
+}
+
+unsigned long EspNowLeaf::getSentCount() {
+  return sent;
+}
+
+bool EspNowLeaf::deliverPending() {
+  if (radio->send(gatewayMac, pendingFrame, pendingLength)) {
+    pendingLength = 0;
+    consecutiveFailures = 0;
+    sent++;
+    return true;
+  }
+  
+  // Gateway apagado o cambió de canal (su AP se movió): volver a buscarlo
+  if (++consecutiveFailures >= ESPNOW_MAX_SEND_FAILURES) {
+    Serial.println("ESP-NOW leaf: gateway unreachable, rescanning channels");
+    Storage::clearEspNowGateway();
+    gatewayKnown = false;
+    discoveryChannel = 0;
+  }
+  return false;
+}
+
+void EspNowLeaf::discoverStep() {
+  uint8_t mac[RadioTransport::MAC_SIZE];
+  uint8_t frame[RadioTransport::MAX_FRAME_SIZE];
+  size_t length;
+  
+  // OFFER a un DISCOVER anterior (en broadcast: solo vale el que nombra a esta hoja)
+  while ((length = radio->receive(mac, frame, sizeof(frame))) > 0) {
+    uint8_t channel;
+    char offeredId[sizeof(deviceId)];
+    if (EspNowProtocol::decodeOffer(frame, length, channel, offeredId) &&
+        strcasecmp(offeredId, deviceId) == 0) {
+      memcpy(gatewayMac, mac, sizeof(gatewayMac));
+      gatewayChannel = channel;
+      gatewayKnown = true;
+      consecutiveFailures = 0;
+      Storage::saveEspNowGateway(gatewayMac, gatewayChannel);
+      Serial.printf("ESP-NOW leaf: found gateway on channel %u\n", (unsigned)channel);
+      
+      if (pendingLength > 0) deliverPending();
+      return;
+    }
+  }
+  
+  if (discoveryChannel != 0 && millis() - lastDiscovery < ESPNOW_DISCOVERY_TIMEOUT) {
+    return;
+  }
+  
+  // Siguiente canal del barrido (1..ESPNOW_MAX_CHANNEL, en bucle)
+  discoveryChannel = discoveryChannel % ESPNOW_MAX_CHANNEL + 1;
+  lastDiscovery = millis();
+  radio->begin(discoveryChannel);
+  
+  length = EspNowProtocol::encodeDiscover(frame, deviceId);
+  if (length > 0) {
+    radio->send(RadioTransport::BROADCAST_MAC, frame, length);
+  }
+}
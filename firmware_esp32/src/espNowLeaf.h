@@ -0,0 +1,40 @@
+// espNowLeaf.h
+// ========================================
+
+#ifndef ESP_NOW_LEAF_H
+#define ESP_NOW_LEAF_H
+
+#include "radioTransport.h"
+#include "espNowProtocol.h"
+
+// Rol hoja: sin asociación WiFi ni sesión MQTT. Cada lectura va al gateway en
+// una trama ESP-NOW. El gateway se busca barriendo canales con DISCOVER
+// (un canal por vuelta del loop) y se guarda en flash junto con su canal.
+class EspNowLeaf {
+public:
+  static bool init();
+  static void loop();  // Descubrimiento y reintento de la lectura pendiente
+  static bool sendReading(const char* sensorType, const float* values, uint8_t count);
+  static bool hasGateway();
+  static unsigned long getSentCount();
+  
+private:
+  static RadioTransport* radio;
+  static char deviceId[2 * EspNowProtocol::DEVICE_ID_SIZE + 1];
+  static uint8_t gatewayMac[RadioTransport::MAC_SIZE];
+  static uint8_t gatewayChannel;
+  static bool gatewayKnown;
+  static uint8_t discoveryChannel;
+  static unsigned long lastDiscovery;
+  static int consecutiveFailures;
+  static unsigned long sent;
+  
+  // Última lectura no entregada (solo una: la siguiente la reemplaza)
+  static uint8_t pendingFrame[EspNowProtocol::MAX_FRAME_SIZE];
+  static size_t pendingLength;
+  
+  static void discoverStep();
+  static bool deliverPending();
+};
+
+#endif
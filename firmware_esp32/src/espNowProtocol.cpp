@@ -0,0 +1,135 @@
+// espNowProtocol.cpp
+// ========================================
+
+#include "espNowProtocol.h"
+
+// Mismo orden que las opciones de SENSOR_TYPE en config.h
+static const char* const SENSOR_TYPES[] = {"dht22", "mq4", "pir"};
+static const uint8_t SENSOR_TYPE_COUNT = sizeof(SENSOR_TYPES) / sizeof(SENSOR_TYPES[0]);
+static const size_t HEADER_SIZE = 3;
+
+static size_t writeHeader(uint8_t* out, uint8_t type) {
+  out[0] = EspNowProtocol::MAGIC;
+  out[1] = EspNowProtocol::FORMAT_VERSION;
+  out[2] = type;
+  return HEADER_SIZE;
+}
+
+static int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+size_t EspNowProtocol::encodeDiscover(uint8_t* out, const char* deviceId) {
+  size_t pos = writeHeader(out, FRAME_DISCOVER);
+  if (!packDeviceId(out + pos, deviceId)) return 0;
+  return pos + DEVICE_ID_SIZE;
+}
+
+size_t EspNowProtocol::encodeOffer(uint8_t* out, uint8_t channel, const char* deviceId) {
+  size_t pos = writeHeader(out, FRAME_OFFER);
+  out[pos++] = channel;
+  if (!packDeviceId(out + pos, deviceId)) return 0;
+  return pos + DEVICE_ID_SIZE;
+}
+
+size_t EspNowProtocol::encodeReading(uint8_t* out, const char* deviceId, const char* sensorType,
+                                     const float* values, uint8_t valueCount) {
+  uint8_t code = sensorTypeCode(sensorType);
+  if (code >= SENSOR_TYPE_COUNT || valueCount > MAX_VALUES) return 0;
+  
+  size_t pos = writeHeader(out, FRAME_READING);
+  if (!packDeviceId(out + pos, deviceId)) return 0;
+  pos += DEVICE_ID_SIZE;
+  out[pos++] = code;
+  out[pos++] = valueCount;
+  for (uint8_t i = 0; i < valueCount; i++) {
+    uint32_t bits;
+    memcpy(&bits, &values[i], sizeof(bits));
+    out[pos++] = bits & 0xFF;
+    out[pos++] = (bits >> 8) & 0xFF;
+    out[pos++] = (bits >> 16) & 0xFF;
+    out[pos++] = (bits >> 24) & 0xFF;
+  }
+  return pos;
+}
+
+uint8_t EspNowProtocol::getFrameType(const uint8_t* in, size_t length) {
+  if (length < HEADER_SIZE || in[0] != MAGIC || in[1] != FORMAT_VERSION) {
+    return 0;
+  }
+  return in[2];
+}
+
+bool EspNowProtocol::decodeDiscover(const uint8_t* in, size_t length, char* deviceId) {
+  if (getFrameType(in, length) != FRAME_DISCOVER || length < HEADER_SIZE + DEVICE_ID_SIZE) {
+    return false;
+  }
+  unpackDeviceId(in + HEADER_SIZE, deviceId);
+  return true;
+}
+
+bool EspNowProtocol::decodeOffer(const uint8_t* in, size_t length, uint8_t& channel, char* deviceId) {
+  if (getFrameType(in, length) != FRAME_OFFER || length < HEADER_SIZE + 1 + DEVICE_ID_SIZE) {
+    return false;
+  }
+  channel = in[HEADER_SIZE];
+  unpackDeviceId(in + HEADER_SIZE + 1, deviceId);
+  return true;
+}
+
+bool EspNowProtocol::decodeReading(const uint8_t* in, size_t length, Reading& reading) {
+  if (getFrameType(in, length) != FRAME_READING || length < HEADER_SIZE + DEVICE_ID_SIZE + 2) {
+    return false;
+  }
+  
+  size_t pos = HEADER_SIZE;
+  unpackDeviceId(in + pos, reading.deviceId);
+  pos += DEVICE_ID_SIZE;
+  
+  const char* type = sensorTypeName(in[pos++]);
+  reading.valueCount = in[pos++];
+  if (!type || reading.valueCount > MAX_VALUES || length < pos + 4 * reading.valueCount) {
+    return false;
+  }
+  strncpy(reading.sensorType, type, sizeof(reading.sensorType));
+  
+  for (uint8_t i = 0; i < reading.valueCount; i++) {
+    uint32_t bits = (uint32_t)in[pos] | ((uint32_t)in[pos + 1] << 8) |
+                    ((uint32_t)in[pos + 2] << 16) | ((uint32_t)in[pos + 3] << 24);
+    memcpy(&reading.values[i], &bits, sizeof(float));
+    pos += 4;
+  }
+  return true;
+}
+
+bool EspNowProtocol::packDeviceId(uint8_t* out, const char* deviceId) {
+  if (strlen(deviceId) != 2 * DEVICE_ID_SIZE) return false;
+  
+  for (size_t i = 0; i < DEVICE_ID_SIZE; i++) {
+    int high = hexValue(deviceId[2 * i]);
+    int low = hexValue(deviceId[2 * i + 1]);
+    if (high < 0 || low < 0) return false;
+    out[i] = (uint8_t)((high << 4) | low);
+  }
+  return true;
+}
+
+void EspNowProtocol::unpackDeviceId(const uint8_t* in, char* deviceId) {
+  for (size_t i = 0; i < DEVICE_ID_SIZE; i++) {
+    snprintf(deviceId + 2 * i, 3, "%02x", in[i]);
+  }
+}
+
+uint8_t EspNowProtocol::sensorTypeCode(const char* sensorType) {
+  for (uint8_t i = 0; i < SENSOR_TYPE_COUNT; i++) {
+    if (strcmp(sensorType, SENSOR_TYPES[i]) == 0) return i;
+  }
+  return SENSOR_TYPE_COUNT;
+}
+
+const char* EspNowProtocol::sensorTypeName(uint8_t code) {
+  return code < SENSOR_TYPE_COUNT ? SENSOR_TYPES[code] : nullptr;
+}
@@ -0,0 +1,56 @@
+// espNowProtocol.h
+// ========================================
+
+#ifndef ESP_NOW_PROTOCOL_H
+#define ESP_NOW_PROTOCOL_H
+
+#include <Arduino.h>
+
+// Tramas entre hojas y gateway (binario compacto, ~25 bytes frente a ~190 del JSON):
+//   cabecera   0xE5 | versión u8 | tipo u8
+//   DISCOVER   deviceId 12 bytes              (hoja -> broadcast, busca gateway)
+//   OFFER      canal u8 | deviceId 12 bytes   (gateway -> broadcast, a la hoja del DISCOVER)
+//   READING    deviceId 12 bytes | sensorType u8 | nValores u8 | float LE * n
+// deviceId es el ObjectId de 24 caracteres hex empaquetado en 12 bytes.
+// READING va cifrado (par con LMK). OFFER va en broadcast y en claro: la hoja aún
+// no tiene al gateway como par y no podría descifrar un unicast suyo.
+class EspNowProtocol {
+public:
+  enum FrameType : uint8_t {
+    FRAME_DISCOVER = 1,
+    FRAME_OFFER = 2,
+    FRAME_READING = 3
+  };
+  
+  static const uint8_t MAGIC = 0xE5;
+  static const uint8_t FORMAT_VERSION = 2;  // 2: OFFER en broadcast con deviceId
+  static const size_t DEVICE_ID_SIZE = 12;
+  static const uint8_t MAX_VALUES = 2;
+  static const size_t MAX_FRAME_SIZE = 3 + DEVICE_ID_SIZE + 2 + 4 * MAX_VALUES;
+  
+  struct Reading {
+    char deviceId[2 * DEVICE_ID_SIZE + 1];
+    char sensorType[8];
+    uint8_t valueCount;
+    float values[MAX_VALUES];
+  };
+  
+  static size_t encodeDiscover(uint8_t* out, const char* deviceId);
+  static size_t encodeOffer(uint8_t* out, uint8_t channel, const char* deviceId);
+  static size_t encodeReading(uint8_t* out, const char* deviceId, const char* sensorType,
+                              const float* values, uint8_t valueCount);
+  
+  // FrameType de la trama, 0 si no es del protocolo
+  static uint8_t getFrameType(const uint8_t* in, size_t length);
+  static bool decodeDiscover(const uint8_t* in, size_t length, char* deviceId);
+  static bool decodeOffer(const uint8_t* in, size_t length, uint8_t& channel, char* deviceId);
+  static bool decodeReading(const uint8_t* in, size_t length, Reading& reading);
+  
+private:
+  static bool packDeviceId(uint8_t* out, const char* deviceId);
+  static void unpackDeviceId(const uint8_t* in, char* deviceId);
+  static uint8_t sensorTypeCode(const char* sensorType);
+  static const char* sensorTypeName(uint8_t code);
+};
+
+#endif
@@ -0,0 +1,148 @@
+// espNowTransport.cpp
+// ========================================
+
+#include "espNowTransport.h"
+
+#ifndef NATIVE_BUILD
+
+#include <WiFi.h>
+#include <esp_wifi.h>
+#include "config.h"
+
+const uint8_t RadioTransport::BROADCAST_MAC[MAC_SIZE] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+bool EspNowTransport::initialized = false;
+bool EspNowTransport::encrypted = false;
+uint8_t EspNowTransport::localKey[KEY_SIZE];
+EspNowTransport::Frame EspNowTransport::queue[QUEUE_SIZE];
+volatile int EspNowTransport::queueHead = 0;
+volatile int EspNowTransport::queueCount = 0;
+volatile bool EspNowTransport::sendDone = false;
+volatile bool EspNowTransport::sendSuccess = false;
+
+static EspNowTransport espNowTransport;
+static portMUX_TYPE queueLock = portMUX_INITIALIZER_UNLOCKED;
+
+RadioTransport* RadioTransport::platform() {
+  return &espNowTransport;
+}
+
+bool EspNowTransport::begin(uint8_t channel) {
+  // Hoja: sin asociarse a ningún AP, solo la radio en modo STA
+  if (WiFi.status() != WL_CONNECTED) {
+    WiFi.mode(WIFI_STA);
+    WiFi.disconnect();
+    esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+  }
+  
+  if (initialized) return true;
+  
+  if (esp_now_init() != ESP_OK) {
+    Serial.println("ESP-NOW init failed");
+    return false;
+  }
+  esp_now_register_recv_cb(onReceive);
+  esp_now_register_send_cb(onSent);
+  initialized = true;
+  return true;
+}
+
+uint8_t EspNowTransport::getChannel() {
+  uint8_t channel = 0;
+  wifi_second_chan_t second;
+  esp_wifi_get_channel(&channel, &second);
+  return channel;
+}
+
+void EspNowTransport::getMacAddress(uint8_t* mac) {
+  esp_wifi_get_mac(WIFI_IF_STA, mac);
+}
+
+bool EspNowTransport::setKeys(const uint8_t* pmk, const uint8_t* lmk) {
+  if (!initialized || esp_now_set_pmk(pmk) != ESP_OK) {
+    Serial.println("ESP-NOW: PMK not set");
+    return false;
+  }
+  memcpy(localKey, lmk, KEY_SIZE);
+  encrypted = true;
+  return true;
+}
+
+bool EspNowTransport::addPeer(const uint8_t* mac) {
+  return initialized && ensurePeer(mac);
+}
+
+bool EspNowTransport::ensurePeer(const uint8_t* mac) {
+  if (esp_now_is_peer_exist(mac)) return true;
+  
+  // Canal 0 = el canal actual de la interfaz
+  esp_now_peer_info_t peer = {};
+  memcpy(peer.peer_addr, mac, MAC_SIZE);
+  peer.channel = 0;
+  peer.ifidx = WIFI_IF_STA;
+  
+  // El broadcast no admite cifrado; el resto de pares usa la LMK de la flota
+  peer.encrypt = encrypted && memcmp(mac, BROADCAST_MAC, MAC_SIZE) != 0;
+  if (peer.encrypt) {
+    memcpy(peer.lmk, localKey, KEY_SIZE);
+  }
+  return esp_now_add_peer(&peer) == ESP_OK;
+}
+
+bool EspNowTransport::send(const uint8_t* mac, const uint8_t* data, size_t length) {
+  if (!initialized || length > MAX_FRAME_SIZE || !ensurePeer(mac)) {
+    return false;
+  }
+  
+  sendDone = false;
+  if (esp_now_send(mac, data, length) != ESP_OK) {
+    return false;
+  }
+  
+  // El resultado llega por onSent tras el ACK (o los reintentos) de capa MAC
+  unsigned long start = millis();
+  while (!sendDone && millis() - start < ESPNOW_SEND_TIMEOUT) {
+    delay(1);
+  }
+  return sendDone && sendSuccess;
+}
+
+size_t EspNowTransport::receive(uint8_t* mac, uint8_t* data, size_t capacity) {
+  size_t length = 0;
+  
+  portENTER_CRITICAL(&queueLock);
+  if (queueCount > 0) {
+    Frame& frame = queue[queueHead];
+    length = frame.length < capacity ? frame.length : capacity;
+    memcpy(mac, frame.mac, MAC_SIZE);
+    memcpy(data, frame.data, length);
+    queueHead = (queueHead + 1) % QUEUE_SIZE;
+    queueCount--;
+  }
+  portEXIT_CRITICAL(&queueLock);
+  
+  return length;
+}
+
+void EspNowTransport::onReceive(const uint8_t* mac, const uint8_t* data, int length) {
+  if (length <= 0 || (size_t)length > MAX_FRAME_SIZE) return;
+  
+  // Cola llena: se descarta la trama nueva (el loop del gateway va atrasado)
+  portENTER_CRITICAL(&queueLock);
+  if (queueCount < QUEUE_SIZE) {
+    Frame& frame = queue[(queueHead + queueCount) % QUEUE_SIZE];
+    memcpy(frame.mac, mac, MAC_SIZE);
+    memcpy(frame.data, data, length);
+    frame.length = length;
+    queueCount++;
+  }
+  portEXIT_CRITICAL(&queueLock);
+}
+
+void EspNowTransport::onSent(const uint8_t* mac, esp_now_send_status_t status) {
+  (void)mac;
+  sendSuccess = status == ESP_NOW_SEND_SUCCESS;
+  sendDone = true;
+}
+
+#endif
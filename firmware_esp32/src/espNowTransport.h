@@ -0,0 +1,50 @@
+// espNowTransport.h
+// ========================================
+
+#ifndef ESP_NOW_TRANSPORT_H
+#define ESP_NOW_TRANSPORT_H
+
+#include "radioTransport.h"
+
+#ifndef NATIVE_BUILD
+
+#include <esp_now.h>
+
+// RadioTransport sobre ESP-NOW. Los callbacks corren en la tarea de WiFi:
+// solo copian a una cola estática que el loop vacía con receive().
+class EspNowTransport : public RadioTransport {
+public:
+  bool begin(uint8_t channel) override;
+  uint8_t getChannel() override;
+  void getMacAddress(uint8_t* mac) override;
+  bool setKeys(const uint8_t* pmk, const uint8_t* lmk) override;
+  bool addPeer(const uint8_t* mac) override;
+  bool send(const uint8_t* mac, const uint8_t* data, size_t length) override;
+  size_t receive(uint8_t* mac, uint8_t* data, size_t capacity) override;
+  
+private:
+  static const int QUEUE_SIZE = 8;
+  
+  struct Frame {
+    uint8_t mac[MAC_SIZE];
+    uint8_t data[MAX_FRAME_SIZE];
+    size_t length;
+  };
+  
+  static bool initialized;
+  static bool encrypted;
+  static uint8_t localKey[KEY_SIZE];
+  static Frame queue[QUEUE_SIZE];
+  static volatile int queueHead;
+  static volatile int queueCount;
+  static volatile bool sendDone;
+  static volatile bool sendSuccess;
+  
+  static bool ensurePeer(const uint8_t* mac);
+  static void onReceive(const uint8_t* mac, const uint8_t* data, int length);
+  static void onSent(const uint8_t* mac, esp_now_send_status_t status);
+};
+
+#endif
+
+#endif
@@ -6,7 +6,6 @@
 #include <Preferences.h>
 #include <ArduinoJson.h>
 #include <HTTPClient.h>
-#include <PubSubClient.h>
 #include <NTPClient.h>
 #include <WiFiUdp.h>
 #include <DHT.h>
@@ -15,21 +14,21 @@
 #include "config.h"
 #include "storage.h"
 #include "wifiManager.h"
-#include "mqttClient.h"
 #include "sensor.h"
+#include "samplingScheduler.h"
+#include "alertEvaluator.h"
+#include "operationMode.h"
+#include "allocTracker.h"
+#include "traceRecorder.h"
+#include "serialConsole.h"
 
 // Variables globales
 bool configMode = false;
-unsigned long lastSensorReading = 0;
-const unsigned long SENSOR_INTERVAL = 60000; // 1 minuto
 const int RESET_BUTTON_PIN = 0; // GPIO0 (BOOT button)
 unsigned long buttonPressTime = 0;
 bool buttonPressed = false;
 
 // === Prototipos de funciones ===
-void startOperationMode();
-void handleOperationMode();
-void readAndPublishSensor();
 void checkResetButton();
 
 void setup() {
@@ -45,8 +44,13 @@ void setup() {
   // Inicializar storage
   Storage::init();
   
+  // Grabación de trazas (antes del sensor para capturar la estabilización PIR)
+  TraceRecorder::init();
+  
   // Inicializar sensor (incluye estabilización PIR si aplica)
   Sensor::init();
+  SamplingScheduler::init(Sensor::getSensorType());
+  AlertEvaluator::init(Sensor::getSensorType());
   
   // Verificar si hay configuración guardada
   if (!Storage::hasConfig()) {
@@ -56,9 +60,14 @@ void setup() {
   } else {
     Serial.println("Configuration found. Starting operation mode...");
     configMode = false;
-    startOperationMode();
+    OperationMode::start();
   }
   
+#ifdef ALLOC_TRACKING
+  // Contar solo las asignaciones de la tarea del loop de Arduino
+  AllocTracker::trackCurrentTask();
+#endif
+  
   Serial.println("=== Setup completed ===");
 }
 
@@ -66,6 +75,10 @@ void loop() {
   // Verificar botón de reset
   checkResetButton();
   
+  // Comandos por serial y grabación/descarga de trazas
+  SerialConsole::poll();
+  TraceRecorder::loop();
+  
   // Verificar PIR continuamente (solo si es sensor PIR)
   Sensor::checkPIRContinuously();
   
@@ -74,82 +87,12 @@ void loop() {
     WiFiManager::handleClient();
   } else {
     // Modo operación
-    handleOperationMode();
+    OperationMode::loop();
   }
   
   delay(100);  // Delay corto para no saturar el CPU
 }
 
-void startOperationMode() {
-  Serial.println("Starting operation mode...");
-  
-  // Conectar a WiFi
-  if (!WiFiManager::connectToWiFi()) {
-    Serial.println("Failed to connect to WiFi. Restarting setup mode...");
-    Storage::clearConfig();
-    ESP.restart();
-    return;
-  }
-  
-  // Inicializar NTP
-  WiFiManager::initNTP();
-  
-  // Conectar a MQTT
-  MQTTClient::init();
-  if (!MQTTClient::connect()) {
-    Serial.println("Failed to connect to MQTT. Will retry...");
-  } else {
-    Serial.println("MQTT connected successfully");
-  }
-  
-  Serial.println("Device ready for operation!");
-}
-
-void handleOperationMode() {
-  // Mantener conexión MQTT
-  if (!MQTTClient::isConnected()) {
-    Serial.println("MQTT disconnected, attempting reconnection...");
-    MQTTClient::connect();
-  }
-  MQTTClient::loop();
-  
-  // Leer sensor periódicamente
-  unsigned long currentTime = millis();
-  if (currentTime - lastSensorReading >= SENSOR_INTERVAL) {
-    readAndPublishSensor();
-    lastSensorReading = currentTime;
-  }
-  
-  // Verificar conexión WiFi
-  if (WiFi.status() != WL_CONNECTED) {
-    Serial.println("WiFi disconnected. Attempting reconnection...");
-    WiFiManager::connectToWiFi();
-  }
-}
-
-void readAndPublishSensor() {
-  Serial.println("Reading sensor data...");
-  
-  // Para PIR, verificar si está estabilizado
-  String sensorType = Storage::getSensorType();
-  if (sensorType == "pir" && !Sensor::isPIRStabilized()) {
-    Serial.println("PIR still stabilizing, skipping this reading");
-    return;
-  }
-  
-  String jsonPayload = Sensor::readAndFormat();
-  if (jsonPayload.length() > 0) {
-    MQTTClient::publishSensorData(jsonPayload);
-    Serial.println("Sensor data published: " + jsonPayload);
-  } else {
-    Serial.println("Failed to read sensor data");
-  }
-  
-  // Debug info
-  Serial.println("Next reading in " + String(SENSOR_INTERVAL/1000) + " seconds");
-  Serial.println("Free heap: " + String(ESP.getFreeHeap()) + " bytes");
-}
-
 void checkResetButton() {
   bool currentState = digitalRead(RESET_BUTTON_PIN) == LOW;
   
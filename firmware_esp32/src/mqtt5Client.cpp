@@ -0,0 +1,625 @@
+// mqtt5Client.cpp
+// ========================================
+
+#include "mqtt5Client.h"
+
+// Los paquetes se montan a partir de este offset; la cabecera fija (tipo +
+// longitud restante, hasta 5 bytes) se escribe justo delante al enviar
+static const size_t MAX_HEADER_SIZE = 5;
+
+// Tipos de paquete
+static const uint8_t CONNECT = 0x10;
+static const uint8_t CONNACK = 0x20;
+static const uint8_t PUBLISH = 0x30;
+static const uint8_t PUBACK = 0x40;
+static const uint8_t SUBSCRIBE = 0x82;
+static const uint8_t SUBACK = 0x90;
+static const uint8_t PINGREQ = 0xC0;
+static const uint8_t PINGRESP = 0xD0;
+static const uint8_t DISCONNECT = 0xE0;
+
+// Propiedades MQTT 5 que se escriben o se leen
+static const uint8_t PROP_MESSAGE_EXPIRY = 0x02;
+static const uint8_t PROP_CONTENT_TYPE = 0x03;
+static const uint8_t PROP_SERVER_KEEP_ALIVE = 0x13;
+static const uint8_t PROP_RECEIVE_MAXIMUM = 0x21;
+static const uint8_t PROP_TOPIC_ALIAS_MAXIMUM = 0x22;
+static const uint8_t PROP_TOPIC_ALIAS = 0x23;
+static const uint8_t PROP_MAXIMUM_PACKET_SIZE = 0x27;
+
+// Reason code de CONNACK (v5) / return code (3.1.1) de versión no soportada
+static const uint8_t REASON_UNSUPPORTED_PROTOCOL = 0x84;
+static const uint8_t RETURN_UNACCEPTABLE_PROTOCOL = 0x01;
+
+Mqtt5Client::Mqtt5Client(WiFiClient& client) : client(client) {
+  setBufferSize(DEFAULT_BUFFER_SIZE);
+}
+
+Mqtt5Client::~Mqtt5Client() {
+  free(buffer);
+}
+
+Mqtt5Client& Mqtt5Client::setServer(const char* domain, uint16_t port) {
+  host = domain;
+  this->port = port;
+  
+  // Broker ya conocido: la versión que negoció; uno nuevo empieza por MQTT 5
+  protocolLevel = 5;
+  for (int i = 0; i < knownHostCount; i++) {
+    if (strcmp(knownHosts[i].host, domain) == 0 && knownHosts[i].port == port) {
+      protocolLevel = knownHosts[i].protocolLevel;
+      break;
+    }
+  }
+  return *this;
+}
+
+void Mqtt5Client::rememberProtocolLevel() {
+  int slot = 0;
+  while (slot < knownHostCount &&
+         (strcmp(knownHosts[slot].host, host) != 0 || knownHosts[slot].port != port)) {
+    slot++;
+  }
+  if (slot == knownHostCount) {
+    // Tabla llena (más brokers que MAX_KNOWN_HOSTS): se reutiliza la última entrada
+    if (knownHostCount == MAX_KNOWN_HOSTS) slot = MAX_KNOWN_HOSTS - 1;
+    else knownHostCount++;
+  }
+  // El host apunta a la configuración estática (brokers[] de MQTTClient)
+  knownHosts[slot].host = host;
+  knownHosts[slot].port = port;
+  knownHosts[slot].protocolLevel = protocolLevel;
+}
+
+Mqtt5Client& Mqtt5Client::setCallback(Callback callback) {
+  this->callback = callback;
+  return *this;
+}
+
+Mqtt5Client& Mqtt5Client::setReceiveMaximum(uint16_t receiveMaximum) {
+  this->receiveMaximum = receiveMaximum > 0 ? receiveMaximum : 1;
+  return *this;
+}
+
+bool Mqtt5Client::setBufferSize(uint16_t size) {
+  if (size == 0) return false;
+  
+  // Una sola reserva en init(): el régimen estable no toca el heap
+  uint8_t* resized = (uint8_t*)realloc(buffer, size);
+  if (!resized) return false;
+  buffer = resized;
+  bufferSize = size;
+  return true;
+}
+
+bool Mqtt5Client::connect(const char* id, const char* user, const char* pass) {
+  if (connected()) return true;
+  if (!host || !client.connect(host, port)) {
+    connectionState = MQTT_CONNECT_FAILED;
+    return false;
+  }
+  connectionState = MQTT_DISCONNECTED;
+  
+  size_t idLength = strlen(id);
+  size_t userLength = user ? strlen(user) : 0;
+  size_t passLength = pass ? strlen(pass) : 0;
+  
+  uint8_t flags = 0x02;  // Clean start
+  if (user) flags |= 0x80;
+  if (pass) flags |= 0x40;
+  
+  // Propiedades: Receive Maximum + Maximum Packet Size (el buffer)
+  uint8_t properties[8];
+  size_t propertiesLength = 0;
+  if (isV5()) {
+    properties[propertiesLength++] = PROP_RECEIVE_MAXIMUM;
+    properties[propertiesLength++] = receiveMaximum >> 8;
+    properties[propertiesLength++] = receiveMaximum & 0xFF;
+    properties[propertiesLength++] = PROP_MAXIMUM_PACKET_SIZE;
+    properties[propertiesLength++] = 0;
+    properties[propertiesLength++] = 0;
+    properties[propertiesLength++] = bufferSize >> 8;
+    properties[propertiesLength++] = bufferSize & 0xFF;
+  }
+  
+  size_t length = 10 + 2 + idLength;
+  if (isV5()) length += varIntSize(propertiesLength) + propertiesLength;
+  if (user) length += 2 + userLength;
+  if (pass) length += 2 + passLength;
+  if (MAX_HEADER_SIZE + length > bufferSize) {
+    client.stop();
+    connectionState = MQTT_CONNECT_FAILED;
+    return false;
+  }
+  
+  uint8_t* out = buffer + MAX_HEADER_SIZE;
+  size_t pos = writeString(out, "MQTT", 4);
+  out[pos++] = protocolLevel;
+  out[pos++] = flags;
+  out[pos++] = KEEP_ALIVE >> 8;
+  out[pos++] = KEEP_ALIVE & 0xFF;
+  if (isV5()) {
+    pos += writeVarInt(out + pos, propertiesLength);
+    memcpy(out + pos, properties, propertiesLength);
+    pos += propertiesLength;
+  }
+  pos += writeString(out + pos, id, idLength);
+  if (user) pos += writeString(out + pos, user, userLength);
+  if (pass) pos += writeString(out + pos, pass, passLength);
+  
+  if (!writePacket(CONNECT, pos)) {
+    closeConnection(MQTT_CONNECT_FAILED);
+    return false;
+  }
+  
+  // Esperar CONNACK
+  unsigned long start = millis();
+  while (!client.available()) {
+    if (millis() - start >= SOCKET_TIMEOUT) {
+      closeConnection(MQTT_CONNECTION_TIMEOUT);
+      return false;
+    }
+    delay(1);
+  }
+  
+  uint8_t header;
+  size_t packetLength = readPacket(header);
+  if ((header & 0xF0) != CONNACK || !parseConnack(packetLength)) {
+    if (connectionState == MQTT_CONNECTED || connectionState == MQTT_DISCONNECTED) {
+      connectionState = MQTT_CONNECT_FAILED;
+    }
+    client.stop();
+    return false;
+  }
+  
+  aliasCount = 0;
+  pingOutstanding = false;
+  lastInActivity = lastOutActivity = millis();
+  connectionState = MQTT_CONNECTED;
+  return true;
+}
+
+bool Mqtt5Client::parseConnack(size_t length) {
+  if (length < 2) return false;
+  
+  uint8_t code = buffer[1];
+  if (code != 0) {
+    // Broker solo 3.1.1: responde con su return code 1 aunque el CONNECT fuera v5
+    if (isV5() && (code == REASON_UNSUPPORTED_PROTOCOL || code == RETURN_UNACCEPTABLE_PROTOCOL)) {
+      Serial.println("MQTT 5 not supported by broker, falling back to 3.1.1");
+      protocolLevel = 4;
+      rememberProtocolLevel();
+      connectionState = MQTT_CONNECT_BAD_PROTOCOL;
+    } else if (code == 0x86 || code == 0x04) {
+      connectionState = MQTT_CONNECT_BAD_CREDENTIALS;
+    } else if (code == 0x87 || code == 0x05) {
+      connectionState = MQTT_CONNECT_UNAUTHORIZED;
+    } else if (code == 0x85 || code == 0x02) {
+      connectionState = MQTT_CONNECT_BAD_CLIENT_ID;
+    } else {
+      connectionState = MQTT_CONNECT_UNAVAILABLE;
+    }
+    return false;
+  }
+  
+  serverTopicAliasMaximum = 0;
+  serverMaximumPacketSize = 0;
+  keepAlive = KEEP_ALIVE;
+  rememberProtocolLevel();
+  if (!isV5()) return true;
+  
+  size_t pos = 2;
+  uint32_t propertiesLength;
+  if (!readVarInt(buffer, pos, length, propertiesLength) || pos + propertiesLength > length) {
+    return false;
+  }
+  
+  size_t end = pos + propertiesLength;
+  while (pos < end) {
+    uint8_t id = buffer[pos++];
+    if (id == PROP_TOPIC_ALIAS_MAXIMUM && pos + 2 <= end) {
+      serverTopicAliasMaximum = (buffer[pos] << 8) | buffer[pos + 1];
+      pos += 2;
+    } else if (id == PROP_SERVER_KEEP_ALIVE && pos + 2 <= end) {
+      keepAlive = (buffer[pos] << 8) | buffer[pos + 1];
+      pos += 2;
+    } else if (id == PROP_MAXIMUM_PACKET_SIZE && pos + 4 <= end) {
+      serverMaximumPacketSize = ((uint32_t)buffer[pos] << 24) | ((uint32_t)buffer[pos + 1] << 16) |
+                                ((uint32_t)buffer[pos + 2] << 8) | buffer[pos + 3];
+      pos += 4;
+    } else {
+      pos--;
+      if (!skipProperty(pos, end)) return false;
+    }
+  }
+  return true;
+}
+
+bool Mqtt5Client::connected() {
+  if (connectionState != MQTT_CONNECTED) return false;
+  if (!client.connected()) {
+    closeConnection(MQTT_CONNECTION_LOST);
+    return false;
+  }
+  return true;
+}
+
+void Mqtt5Client::disconnect() {
+  if (connectionState == MQTT_CONNECTED) {
+    // v5: reason code 0 (normal) + sin propiedades = remaining length 0
+    writePacket(DISCONNECT, 0);
+  }
+  closeConnection(MQTT_DISCONNECTED);
+}
+
+void Mqtt5Client::closeConnection(int newState) {
+  client.stop();
+  connectionState = newState;
+  pingOutstanding = false;
+  aliasCount = 0;
+}
+
+bool Mqtt5Client::loop() {
+  if (!connected()) return false;
+  
+  unsigned long now = millis();
+  unsigned long keepAliveMs = (unsigned long)keepAlive * 1000UL;
+  if (keepAliveMs > 0 && (now - lastInActivity > keepAliveMs || now - lastOutActivity > keepAliveMs)) {
+    if (pingOutstanding) {
+      closeConnection(MQTT_CONNECTION_TIMEOUT);
+      return false;
+    }
+    if (!writePacket(PINGREQ, 0)) return false;
+    lastInActivity = now;
+    pingSentAt = now;
+    pingOutstanding = true;
+  }
+  
+  while (client.available()) {
+    uint8_t header;
+    size_t length = readPacket(header);
+    if (connectionState != MQTT_CONNECTED) return false;
+    lastInActivity = millis();
+    handlePacket(header, length);
+  }
+  
+  return connectionState == MQTT_CONNECTED;
+}
+
+bool Mqtt5Client::ping() {
+  if (!connected()) return false;
+  if (pingOutstanding) return true;  // Ya hay uno en vuelo (keep-alive): se mide ese
+  
+  unsigned long now = millis();
+  if (!writePacket(PINGREQ, 0)) return false;
+  // Mismo plazo que un PINGREQ de keep-alive antes de dar la sesión por perdida
+  lastInActivity = now;
+  pingSentAt = now;
+  pingMeasured = false;
+  pingOutstanding = true;
+  return true;
+}
+
+bool Mqtt5Client::takePingLatency(long& rtt) {
+  if (!pingMeasured) return false;
+  pingMeasured = false;
+  rtt = pingLatency;
+  return true;
+}
+
+void Mqtt5Client::handlePacket(uint8_t header, size_t length) {
+  switch (header & 0xF0) {
+    case PUBLISH:
+      handlePublish(header, length);
+      break;
+    case PINGRESP:
+      if (pingOutstanding) {
+        pingLatency = (long)(millis() - pingSentAt);
+        pingMeasured = true;
+      }
+      pingOutstanding = false;
+      break;
+    case DISCONNECT:
+      // v5: el broker explica el cierre con un reason code
+      Serial.printf("MQTT broker sent DISCONNECT (reason 0x%02x)\n", length > 0 ? buffer[0] : 0);
+      closeConnection(MQTT_CONNECTION_LOST);
+      break;
+    default:
+      // SUBACK, PINGREQ del broker, etc.: nada que hacer con QoS 0
+      break;
+  }
+}
+
+void Mqtt5Client::handlePublish(uint8_t header, size_t length) {
+  if (length < 2) return;
+  
+  size_t topicLength = (buffer[0] << 8) | buffer[1];
+  size_t pos = 2 + topicLength;
+  uint8_t qos = (header >> 1) & 0x03;
+  uint16_t packetId = 0;
+  if (qos > 0) {
+    if (pos + 2 > length) return;
+    packetId = (buffer[pos] << 8) | buffer[pos + 1];
+    pos += 2;
+  }
+  if (isV5()) {
+    uint32_t propertiesLength;
+    if (!readVarInt(buffer, pos, length, propertiesLength) || pos + propertiesLength > length) return;
+    size_t end = pos + propertiesLength;
+    while (pos < end) {
+      if (!skipProperty(pos, end)) return;
+    }
+  }
+  if (pos > length || topicLength == 0) return;
+  
+  // Topic terminado en '\0' en el propio buffer (el payload empieza al menos 2 bytes después)
+  memmove(buffer, buffer + 2, topicLength);
+  buffer[topicLength] = '\0';
+  if (callback) {
+    callback((char*)buffer, buffer + pos, length - pos);
+  }
+  
+  if (qos == 1) {
+    uint8_t* out = buffer + MAX_HEADER_SIZE;
+    out[0] = packetId >> 8;
+    out[1] = packetId & 0xFF;
+    writePacket(PUBACK, 2);
+  }
+}
+
+bool Mqtt5Client::publish(const char* topic, const char* payload, bool retained) {
+  return publish(topic, (const uint8_t*)payload, strlen(payload), retained, 0, nullptr);
+}
+
+bool Mqtt5Client::publish(const char* topic, const uint8_t* payload, unsigned int length, bool retained) {
+  return publish(topic, payload, length, retained, 0, nullptr);
+}
+
+bool Mqtt5Client::publish(const char* topic, const uint8_t* payload, unsigned int length, bool retained,
+                          uint32_t messageExpiry, const char* contentType) {
+  if (!connected()) return false;
+  
+  size_t contentTypeLength = (isV5() && contentType) ? strlen(contentType) : 0;
+  size_t propertiesLength = 0;
+  if (isV5()) {
+    if (messageExpiry > 0) propertiesLength += 5;
+    if (contentTypeLength > 0) propertiesLength += 3 + contentTypeLength;
+  }
+  
+  // Peor caso (topic completo + alias) antes de tocar la tabla: un alias
+  // asignado en un PUBLISH que no sale dejaría al broker con otro topic
+  size_t worst = 2 + strlen(topic) + length;
+  if (isV5()) worst += varIntSize(propertiesLength + 3) + propertiesLength + 3;
+  if (MAX_HEADER_SIZE + worst > bufferSize ||
+      (serverMaximumPacketSize > 0 && headerSize(worst) + worst > serverMaximumPacketSize)) {
+    return false;
+  }
+  
+  bool sendTopic = true;
+  uint16_t alias = isV5() ? resolveAlias(topic, sendTopic) : 0;
+  size_t topicLength = sendTopic ? strlen(topic) : 0;
+  if (alias > 0) propertiesLength += 3;
+  
+  uint8_t* out = buffer + MAX_HEADER_SIZE;
+  size_t pos = writeString(out, topic, topicLength);
+  if (isV5()) {
+    pos += writeVarInt(out + pos, propertiesLength);
+    if (messageExpiry > 0) {
+      out[pos++] = PROP_MESSAGE_EXPIRY;
+      out[pos++] = (messageExpiry >> 24) & 0xFF;
+      out[pos++] = (messageExpiry >> 16) & 0xFF;
+      out[pos++] = (messageExpiry >> 8) & 0xFF;
+      out[pos++] = messageExpiry & 0xFF;
+    }
+    if (alias > 0) {
+      out[pos++] = PROP_TOPIC_ALIAS;
+      out[pos++] = alias >> 8;
+      out[pos++] = alias & 0xFF;
+    }
+    if (contentTypeLength > 0) {
+      out[pos++] = PROP_CONTENT_TYPE;
+      pos += writeString(out + pos, contentType, contentTypeLength);
+    }
+  }
+  memcpy(out + pos, payload, length);
+  pos += length;
+  
+  return writePacket(PUBLISH | (retained ? 0x01 : 0x00), pos);
+}
+
+uint16_t Mqtt5Client::resolveAlias(const char* topic, bool& sendTopic) {
+  sendTopic = true;
+  int limit = serverTopicAliasMaximum < MAX_TOPIC_ALIASES ? serverTopicAliasMaximum : MAX_TOPIC_ALIASES;
+  if (limit == 0 || strlen(topic) >= MAX_ALIAS_TOPIC_SIZE) return 0;
+  
+  aliasClock++;
+  for (int i = 0; i < aliasCount; i++) {
+    if (strcmp(aliases[i].topic, topic) == 0) {
+      aliases[i].lastUse = aliasClock;
+      sendTopic = false;
+      return aliases[i].alias;
+    }
+  }
+  
+  // Alias nuevo, o se reasigna el menos usado (el gateway publica en muchos topics)
+  int slot = aliasCount;
+  if (aliasCount < limit) {
+    aliases[slot].alias = (uint16_t)(slot + 1);
+    aliasCount++;
+  } else {
+    slot = 0;
+    for (int i = 1; i < aliasCount; i++) {
+      if (aliases[i].lastUse < aliases[slot].lastUse) slot = i;
+    }
+  }
+  strcpy(aliases[slot].topic, topic);
+  aliases[slot].lastUse = aliasClock;
+  return aliases[slot].alias;
+}
+
+bool Mqtt5Client::subscribe(const char* topic) {
+  if (!connected()) return false;
+  
+  size_t topicLength = strlen(topic);
+  size_t remaining = 2 + (isV5() ? 1 : 0) + 2 + topicLength + 1;
+  if (MAX_HEADER_SIZE + remaining > bufferSize) return false;
+  
+  uint16_t packetId = nextPacketId++;
+  if (nextPacketId == 0) nextPacketId = 1;
+  
+  uint8_t* out = buffer + MAX_HEADER_SIZE;
+  size_t pos = 0;
+  out[pos++] = packetId >> 8;
+  out[pos++] = packetId & 0xFF;
+  if (isV5()) out[pos++] = 0;  // Sin propiedades
+  pos += writeString(out + pos, topic, topicLength);
+  out[pos++] = 0;  // QoS 0 (v5: resto de opciones por defecto)
+  
+  return writePacket(SUBSCRIBE, pos);
+}
+
+bool Mqtt5Client::writePacket(uint8_t header, size_t remainingLength) {
+  // Cabecera fija justo delante del contenido ya montado en buffer + MAX_HEADER_SIZE
+  uint8_t fixed[MAX_HEADER_SIZE];
+  fixed[0] = header;
+  size_t fixedLength = 1 + writeVarInt(fixed + 1, remainingLength);
+  uint8_t* start = buffer + MAX_HEADER_SIZE - fixedLength;
+  memcpy(start, fixed, fixedLength);
+  
+  size_t total = fixedLength + remainingLength;
+  size_t written = client.write(start, total);
+  lastOutActivity = millis();
+  if (written != total) {
+    closeConnection(MQTT_CONNECTION_LOST);
+    return false;
+  }
+  return true;
+}
+
+bool Mqtt5Client::readByte(uint8_t& value) {
+  unsigned long start = millis();
+  while (!client.available()) {
+    if (millis() - start >= SOCKET_TIMEOUT) return false;
+    delay(1);
+  }
+  return client.read(&value, 1) == 1;
+}
+
+size_t Mqtt5Client::readPacket(uint8_t& header) {
+  // Paquete completo al inicio del buffer (sin cabecera fija)
+  uint32_t length = 0;
+  uint32_t multiplier = 1;
+  uint8_t digit;
+  
+  if (!readByte(header)) {
+    closeConnection(MQTT_CONNECTION_TIMEOUT);
+    return 0;
+  }
+  do {
+    if (multiplier > 128 * 128 * 128 || !readByte(digit)) {
+      closeConnection(MQTT_CONNECTION_LOST);
+      return 0;
+    }
+    length += (digit & 0x7F) * multiplier;
+    multiplier *= 128;
+  } while (digit & 0x80);
+  
+  size_t stored = 0;
+  for (uint32_t i = 0; i < length; i++) {
+    if (!readByte(digit)) {
+      closeConnection(MQTT_CONNECTION_LOST);
+      return 0;
+    }
+    // Más grande que el buffer: se descarta (anunciado en Maximum Packet Size)
+    if (i < bufferSize) buffer[stored++] = digit;
+  }
+  
+  if (length > bufferSize) {
+    header = 0;
+    return 0;
+  }
+  return stored;
+}
+
+bool Mqtt5Client::skipProperty(size_t& pos, size_t end) {
+  // Salta una propiedad según su tipo de dato (MQTT 5, sección 2.2.2.2); toda
+  // lectura se acota al final del bloque de propiedades, no al del buffer
+  if (pos >= end) return false;
+  uint8_t id = buffer[pos++];
+  size_t size;
+  switch (id) {
+    case 0x01: case 0x17: case 0x19: case 0x24: case 0x25: case 0x28: case 0x29: case 0x2A:
+      size = 1;
+      break;
+    case 0x13: case 0x21: case 0x22: case 0x23:
+      size = 2;
+      break;
+    case 0x02: case 0x11: case 0x18: case 0x27:
+      size = 4;
+      break;
+    case 0x0B: {
+      uint32_t ignored;
+      return readVarInt(buffer, pos, end, ignored);
+    }
+    case 0x03: case 0x08: case 0x09: case 0x12: case 0x15: case 0x16:
+    case 0x1A: case 0x1C: case 0x1F:
+      if (pos + 2 > end) return false;
+      size = 2 + ((buffer[pos] << 8) | buffer[pos + 1]);
+      break;
+    case 0x26:
+      // Par de strings (user property)
+      if (pos + 2 > end) return false;
+      size = 2 + ((buffer[pos] << 8) | buffer[pos + 1]);
+      if (pos + size + 2 > end) return false;
+      size += 2 + ((buffer[pos + size] << 8) | buffer[pos + size + 1]);
+      break;
+    default:
+      return false;
+  }
+  if (pos + size > end) return false;
+  pos += size;
+  return true;
+}
+
+size_t Mqtt5Client::headerSize(size_t remainingLength) {
+  return 1 + varIntSize(remainingLength);
+}
+
+size_t Mqtt5Client::varIntSize(uint32_t value) {
+  size_t size = 1;
+  while (value >= 128) {
+    value /= 128;
+    size++;
+  }
+  return size;
+}
+
+size_t Mqtt5Client::writeVarInt(uint8_t* out, uint32_t value) {
+  size_t pos = 0;
+  do {
+    uint8_t digit = value % 128;
+    value /= 128;
+    out[pos++] = value > 0 ? (digit | 0x80) : digit;
+  } while (value > 0);
+  return pos;
+}
+
+bool Mqtt5Client::readVarInt(const uint8_t* data, size_t& pos, size_t end, uint32_t& value) {
+  value = 0;
+  uint32_t multiplier = 1;
+  for (int i = 0; i < 4; i++) {
+    if (pos >= end) return false;
+    uint8_t digit = data[pos++];
+    value += (digit & 0x7F) * multiplier;
+    if (!(digit & 0x80)) return true;
+    multiplier *= 128;
+  }
+  return false;
+}
+
+size_t Mqtt5Client::writeString(uint8_t* out, const char* str, size_t length) {
+  out[0] = (uint8_t)(length >> 8);
+  out[1] = (uint8_t)(length & 0xFF);
+  memcpy(out + 2, str, length);
+  return 2 + length;
+}
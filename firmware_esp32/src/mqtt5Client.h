@@ -0,0 +1,129 @@
+// mqtt5Client.h
+// ========================================
+
+#ifndef MQTT5_CLIENT_H
+#define MQTT5_CLIENT_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+// Mismos códigos de state() que PubSubClient (MQTTClient los imprime)
+#define MQTT_CONNECTION_TIMEOUT -4
+#define MQTT_CONNECTION_LOST -3
+#define MQTT_CONNECT_FAILED -2
+#define MQTT_DISCONNECTED -1
+#define MQTT_CONNECTED 0
+#define MQTT_CONNECT_BAD_PROTOCOL 1
+#define MQTT_CONNECT_BAD_CLIENT_ID 2
+#define MQTT_CONNECT_UNAVAILABLE 3
+#define MQTT_CONNECT_BAD_CREDENTIALS 4
+#define MQTT_CONNECT_UNAUTHORIZED 5
+
+// Cliente MQTT 5 (QoS 0) con la interfaz de PubSubClient que usa MQTTClient.
+//   - Topic aliases: tras el primer PUBLISH a un topic solo viaja el alias (2 bytes)
+//     en lugar de "devices/<ObjectId de 24 caracteres>/sensors"
+//   - Propiedades por mensaje: message expiry y content type
+//   - Receive Maximum y Maximum Packet Size anunciados en el CONNECT
+// Si el broker no admite MQTT 5 (CONNACK "unsupported protocol version") la
+// siguiente conexión al mismo broker usa MQTT 3.1.1 sin propiedades.
+class Mqtt5Client {
+public:
+  typedef void (*Callback)(char* topic, uint8_t* payload, unsigned int length);
+  
+  static const uint16_t DEFAULT_BUFFER_SIZE = 256;
+  static const uint16_t KEEP_ALIVE = 15;           // s
+  static const unsigned long SOCKET_TIMEOUT = 5000;  // ms para completar un paquete
+  static const int MAX_TOPIC_ALIASES = 8;
+  static const size_t MAX_ALIAS_TOPIC_SIZE = 64;
+  static const int MAX_KNOWN_HOSTS = 4;
+  
+  explicit Mqtt5Client(WiFiClient& client);
+  ~Mqtt5Client();
+  
+  Mqtt5Client& setServer(const char* domain, uint16_t port);
+  Mqtt5Client& setCallback(Callback callback);
+  Mqtt5Client& setReceiveMaximum(uint16_t receiveMaximum);
+  bool setBufferSize(uint16_t size);
+  
+  bool connect(const char* id, const char* user, const char* pass);
+  bool connected();
+  void disconnect();
+  bool loop();
+  int state() { return connectionState; }
+  uint8_t getProtocolLevel() { return protocolLevel; }
+  
+  bool publish(const char* topic, const char* payload, bool retained = false);
+  bool publish(const char* topic, const uint8_t* payload, unsigned int length, bool retained = false);
+  // messageExpiry en segundos (0 = sin caducidad); contentType nullptr = sin propiedad
+  bool publish(const char* topic, const uint8_t* payload, unsigned int length, bool retained,
+               uint32_t messageExpiry, const char* contentType);
+  bool subscribe(const char* topic);
+  // PINGREQ inmediato para medir la latencia de la sesión (sondeo de MQTTClient)
+  bool ping();
+  // true una sola vez por PINGRESP recibido; rtt = ms desde su PINGREQ
+  bool takePingLatency(long& rtt);
+  
+private:
+  struct TopicAlias {
+    char topic[MAX_ALIAS_TOPIC_SIZE];
+    uint16_t alias;
+    unsigned long lastUse;
+  };
+  
+  // Versión negociada con cada broker: el failover no repite el CONNECT v5 fallido
+  struct KnownHost {
+    const char* host;
+    uint16_t port;
+    uint8_t protocolLevel;
+  };
+  
+  WiFiClient& client;
+  const char* host = nullptr;
+  uint16_t port = 0;
+  Callback callback = nullptr;
+  uint8_t* buffer = nullptr;
+  uint16_t bufferSize = 0;
+  
+  int connectionState = MQTT_DISCONNECTED;
+  uint8_t protocolLevel = 5;
+  uint16_t receiveMaximum = 64;
+  uint16_t keepAlive = KEEP_ALIVE;
+  uint16_t nextPacketId = 1;
+  unsigned long lastOutActivity = 0;
+  unsigned long lastInActivity = 0;
+  bool pingOutstanding = false;
+  unsigned long pingSentAt = 0;
+  long pingLatency = -1;
+  bool pingMeasured = false;
+  
+  // Límites del broker (CONNACK)
+  uint16_t serverTopicAliasMaximum = 0;
+  uint32_t serverMaximumPacketSize = 0;
+  
+  TopicAlias aliases[MAX_TOPIC_ALIASES];
+  int aliasCount = 0;
+  unsigned long aliasClock = 0;
+  
+  KnownHost knownHosts[MAX_KNOWN_HOSTS];
+  int knownHostCount = 0;
+  
+  bool isV5() { return protocolLevel == 5; }
+  uint16_t resolveAlias(const char* topic, bool& sendTopic);
+  bool readByte(uint8_t& value);
+  size_t readPacket(uint8_t& header);
+  bool writePacket(uint8_t header, size_t remainingLength);
+  void handlePacket(uint8_t header, size_t length);
+  void handlePublish(uint8_t header, size_t length);
+  bool parseConnack(size_t length);
+  bool skipProperty(size_t& pos, size_t end);
+  void rememberProtocolLevel();
+  void closeConnection(int newState);
+  
+  static size_t headerSize(size_t remainingLength);
+  static size_t writeVarInt(uint8_t* out, uint32_t value);
+  static size_t varIntSize(uint32_t value);
+  static bool readVarInt(const uint8_t* data, size_t& pos, size_t end, uint32_t& value);
+  static size_t writeString(uint8_t* out, const char* str, size_t length);
+};
+
+#endif
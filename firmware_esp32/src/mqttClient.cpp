@@ -3,29 +3,105 @@
 
 #include "mqttClient.h"
 #include "storage.h"
+#include "sensor.h"
+#include "wifiManager.h"
+#include "traceRecorder.h"
 #include "config.h"
 
 WiFiClient MQTTClient::wifiClient;
-PubSubClient MQTTClient::mqttClient(wifiClient);
+WiFiClient MQTTClient::probeClient;
+MqttProtocolClient MQTTClient::mqttClient(wifiClient);
 String MQTTClient::deviceId;
 String MQTTClient::mqttTopic;
+String MQTTClient::alertTopic;
+String MQTTClient::commandTopic;
+String MQTTClient::traceTopic;
+String MQTTClient::backlogTopic;
+String MQTTClient::selfTestTopic;
+bool MQTTClient::selfTestEchoed = false;
+uint32_t MQTTClient::shardCount = 0;
+char MQTTClient::bootId[9] = "";
+uint32_t MQTTClient::sequence = 0;
+// Payload de Sensor + ,"seq":4294967295,"bootId":"xxxxxxxx","publishedAt":"YYYY-MM-DDTHH:MM:SS.mmmZ"
+char MQTTClient::tracedPayload[Sensor::PAYLOAD_BUFFER_SIZE + 96];
+
+// Orden de prioridad: el broker de la LAN primero, CloudAMQP como respaldo.
+// Un broker con host vacío está desactivado (MQTT_LAN_HOST por defecto)
+const MqttBroker MQTTClient::brokers[] = {
+  {"lan", MQTT_LAN_HOST, MQTT_LAN_PORT, MQTT_LAN_USERNAME, MQTT_LAN_PASSWORD, MQTT_LAN_TRACE_COMMANDS},
+  {"cloud", MQTT_HOST, MQTT_PORT, MQTT_USERNAME, MQTT_PASSWORD, MQTT_CLOUD_TRACE_COMMANDS}
+};
+// Content type (propiedad MQTT 5) de cada topic
+static const char* const CONTENT_TYPE_JSON = "application/json";
+static const char* const CONTENT_TYPE_TEXT = "text/plain";
+static const char* const CONTENT_TYPE_BACKLOG = "application/octet-stream";
+
+const int MQTTClient::BROKER_COUNT = sizeof(MQTTClient::brokers) / sizeof(MQTTClient::brokers[0]);
+BrokerStatus MQTTClient::status[sizeof(MQTTClient::brokers) / sizeof(MQTTClient::brokers[0])];
+int MQTTClient::activeBroker = -1;
+unsigned long MQTTClient::lastProbe = 0;
+MQTTClient::ProbeStep MQTTClient::probeStep = MQTTClient::PROBE_IDLE;
+int MQTTClient::probeIndex = -1;
+unsigned long MQTTClient::probeStepStart = 0;
+long MQTTClient::probeConnectLatency = -1;
+bool MQTTClient::activePingPending = false;
 
 void MQTTClient::init() {
   // Cargar device ID
   String ssid, password;
+  String previousDeviceId = deviceId;
   Storage::loadConfig(ssid, password, deviceId);
   
-  // Construir topic
-  mqttTopic = "devices/" + deviceId + "/sensors";
+  // Secuencia nueva por arranque, o al cambiar de identidad (placas de native/fleet_sim)
+  if (bootId[0] == '\0' || deviceId != previousDeviceId) {
+    snprintf(bootId, sizeof(bootId), "%08x", (unsigned)esp_random());
+    sequence = 0;
+  }
   
-  // Configurar servidor MQTT
-  mqttClient.setServer(MQTT_HOST, MQTT_PORT);
+  // Construir topics (los de ingesta con prefijo de shard si está configurado)
+  shardCount = Storage::getShardCount();
+  char topic[64];
+  formatIngestTopic(topic, sizeof(topic), deviceId.c_str(), "sensors");
+  mqttTopic = topic;
+  formatIngestTopic(topic, sizeof(topic), deviceId.c_str(), "alerts");
+  alertTopic = topic;
+  commandTopic = "devices/" + deviceId + "/trace/cmd";
+  traceTopic = "devices/" + deviceId + "/trace";
+  formatIngestTopic(topic, sizeof(topic), deviceId.c_str(), "backlog");
+  backlogTopic = topic;
+  selfTestTopic = "devices/" + deviceId + "/selftest";
+  
+  mqttClient.setCallback(onMessage);
+  mqttClient.setReceiveMaximum(MQTT_RECEIVE_MAXIMUM);
+  // Los bloques del backlog superan los 256 bytes por defecto
+  mqttClient.setBufferSize(BACKLOG_BLOCK_SIZE + 128);
   
   Serial.println("MQTT initialized");
   Serial.println("Device ID: " + deviceId);
   Serial.println("Topic: " + mqttTopic);
-  Serial.println("MQTT Host: " + String(MQTT_HOST) + ":" + String(MQTT_PORT));
-  Serial.println("MQTT Username: " + String(MQTT_USERNAME)); // ← Agregado para debugging
+  
+  for (int i = 0; i < BROKER_COUNT; i++) {
+    status[i].connectLatency = -1;
+    status[i].pingLatency = -1;
+    status[i].lastFailure = 0;
+    status[i].failed = false;
+    if (!isEnabled(i)) {
+      Serial.println("MQTT Broker " + String(i) + " (" + String(brokers[i].name) + "): disabled");
+      continue;
+    }
+    Serial.println("MQTT Broker " + String(i) + " (" + String(brokers[i].name) + "): " +
+                   String(brokers[i].host) + ":" + String(brokers[i].port));
+  }
+  activeBroker = -1;
+  
+  // Medir antes de la primera conexión para arrancar en el broker más rápido.
+  // Único ciclo completo de una vez: el loop de operación aún no corre
+  probeClient.stop();
+  startProbeCycle();
+  while (probeStep != PROBE_IDLE) {
+    stepProbe();
+    delay(1);
+  }
 }
 
 bool MQTTClient::connect() {
@@ -33,19 +109,71 @@ bool MQTTClient::connect() {
     return true;
   }
   
+  unsigned long now = millis();
+  bool tried[sizeof(brokers) / sizeof(brokers[0])] = {false};
+  
+  // Probar los brokers disponibles del más rápido al más lento
+  for (int attempt = 0; attempt < BROKER_COUNT; attempt++) {
+    int best = -1;
+    for (int i = 0; i < BROKER_COUNT; i++) {
+      if (tried[i] || !isEligible(i, now)) continue;
+      if (best < 0 || getScore(i) < getScore(best)) best = i;
+    }
+    if (best < 0) break;
+  
+    tried[best] = true;
+    if (connectTo(best)) {
+      return true;
+    }
+  }
+  
+  // Todos en espera tras un fallo: reintentar el que lleva más tiempo caído
+  bool anyTried = false;
+  for (int i = 0; i < BROKER_COUNT; i++) anyTried = anyTried || tried[i];
+  if (!anyTried) {
+    int oldest = -1;
+    for (int i = 0; i < BROKER_COUNT; i++) {
+      if (!isEnabled(i)) continue;
+      if (oldest < 0 || now - status[i].lastFailure > now - status[oldest].lastFailure) oldest = i;
+    }
+    return oldest >= 0 && connectTo(oldest);
+  }
+  
+  return false;
+}
+
+bool MQTTClient::connectTo(int index) {
+  const MqttBroker& broker = brokers[index];
+  
   Serial.print("Connecting to MQTT broker...");
-  Serial.println("Host: " + String(MQTT_HOST) + ":" + String(MQTT_PORT));
-  Serial.println("Username: " + String(MQTT_USERNAME));
-  Serial.println("Password: " + String(MQTT_PASSWORD).substring(0, 4) + "****"); // Solo mostrar los primeros 4 caracteres
+  Serial.println("Host: " + String(broker.host) + ":" + String(broker.port) + " (" + broker.name + ")");
+  if (strlen(broker.username) > 0) {
+    Serial.println("Username: " + String(broker.username));
+    Serial.println("Password: " + String(broker.password).substring(0, 4) + "****"); // Solo mostrar los primeros 4 caracteres
+  }
   
   String clientId = "ESP32_" + deviceId;
   Serial.println("Client ID: " + clientId);
   
+  // Sin credenciales (broker de pruebas anónimo) no se envían los campos en el CONNECT
+  const char* username = strlen(broker.username) > 0 ? broker.username : nullptr;
+  const char* password = strlen(broker.password) > 0 ? broker.password : nullptr;
+  
+  mqttClient.setServer(broker.host, broker.port);
+  
   unsigned long startTime = millis();
   while (!mqttClient.connected() && (millis() - startTime < MQTT_TIMEOUT)) {
     // Conectar con usuario y contraseña
-    if (mqttClient.connect(clientId.c_str(), MQTT_USERNAME, MQTT_PASSWORD)) {
-      Serial.println(" connected!");
+    unsigned long attemptStart = millis();
+    if (mqttClient.connect(clientId.c_str(), username, password)) {
+      status[index].connectLatency = (long)(millis() - attemptStart);
+      status[index].failed = false;
+      activeBroker = index;
+      Serial.printf(" connected to %s in %ld ms (MQTT %s)\n", broker.name, status[index].connectLatency,
+                    mqttClient.getProtocolLevel() == 5 ? "5" : "3.1.1");
+      if (acceptsTraceCommands(index)) {
+        mqttClient.subscribe(commandTopic.c_str());
+      }
       return true;
     } else {
       Serial.print(".");
@@ -61,37 +189,456 @@ bool MQTTClient::connect() {
   if (mqttClient.state() == 4) {
     Serial.println("ERROR 4 (bad credentials) - Verify:");
     Serial.println("  Username format should be: user:vhost");
-    Serial.println("  Current username: " + String(MQTT_USERNAME));
-    Serial.println("  Password length: " + String(strlen(MQTT_PASSWORD)));
+    Serial.println("  Current username: " + String(broker.username));
+    Serial.println("  Password length: " + String(strlen(broker.password)));
   }
   
+  markFailure(index);
   return false;
 }
 
+void MQTTClient::markFailure(int index) {
+  status[index].failed = true;
+  status[index].lastFailure = millis();
+  if (activeBroker == index) {
+    activeBroker = -1;
+  }
+}
+
+bool MQTTClient::isEnabled(int index) {
+  return brokers[index].host[0] != '\0';
+}
+
+bool MQTTClient::isEligible(int index, unsigned long now) {
+  if (!isEnabled(index)) return false;
+  return !status[index].failed || now - status[index].lastFailure >= MQTT_RETRY_BACKOFF;
+}
+
+long MQTTClient::getScore(int index) {
+  // Latencia medida primero; sin medición se respeta el orden de prioridad
+  if (status[index].pingLatency >= 0) return status[index].pingLatency;
+  if (status[index].connectLatency >= 0) return status[index].connectLatency;
+  return MQTT_PROBE_TIMEOUT + index;
+}
+
 bool MQTTClient::isConnected() {
   return mqttClient.connected();
 }
 
 void MQTTClient::loop() {
-  mqttClient.loop();
+  if (!mqttClient.loop() && activeBroker >= 0) {
+    // Conexión perdida: el siguiente connect() pasa al otro broker
+    Serial.printf("MQTT broker %s lost\n", brokers[activeBroker].name);
+    markFailure(activeBroker);
+  }
+  
+  // Sondeo repartido entre vueltas: el loop de alertas y PIR nunca espera respuestas
+  if (probeStep == PROBE_IDLE && millis() - lastProbe >= MQTT_PROBE_INTERVAL) {
+    startProbeCycle();
+  }
+  if (probeStep != PROBE_IDLE) {
+    stepProbe();
+  }
+}
+
+void MQTTClient::startProbeCycle() {
+  lastProbe = millis();
+  probeIndex = -1;
+  probeStep = PROBE_NEXT;
+  
+  // Broker activo: RTT con la sesión que ya existe, sin abrir otra (CloudAMQP
+  // limita las conexiones por instancia)
+  activePingPending = activeBroker >= 0 && mqttClient.connected() && mqttClient.ping();
+  
+  // Misma espera corta que los sondeos: el PINGRESP de la LAN llega en pocos ms
+  unsigned long spinStart = millis();
+  long rtt;
+  while (activePingPending && millis() - spinStart < MQTT_PROBE_SPIN) {
+    if (!mqttClient.loop()) {
+      activePingPending = false;
+    } else if (mqttClient.takePingLatency(rtt)) {
+      activePingPending = false;
+      recordPing(activeBroker, rtt);
+    } else {
+      delay(1);
+    }
+  }
 }
 
-void MQTTClient::publishSensorData(const String& jsonPayload) {
+void MQTTClient::stepProbe() {
+  long rtt;
+  if (activePingPending && mqttClient.takePingLatency(rtt)) {
+    activePingPending = false;
+    if (activeBroker >= 0) recordPing(activeBroker, rtt);
+  }
+  
+  switch (probeStep) {
+    case PROBE_IDLE:
+      break;
+      
+    case PROBE_NEXT:
+      // Siguiente broker activado que no sea el de la sesión en curso
+      do {
+        probeIndex++;
+      } while (probeIndex < BROKER_COUNT && (!isEnabled(probeIndex) || probeIndex == activeBroker));
+      if (probeIndex >= BROKER_COUNT) {
+        probeStep = PROBE_FINISH;
+        break;
+      }
+      if (!openProbe(probeIndex)) {
+        failProbe();
+        break;
+      }
+      // La respuesta de la LAN suele llegar dentro de la espera corta de este mismo paso
+      probeStep = PROBE_CONNACK;
+      // fall through
+      
+    case PROBE_CONNACK: {
+      // CONNACK: 0x20 0x02 <flags> <return code>
+      if (!waitForProbeBytes(4)) break;
+      uint8_t response[4];
+      if (probeClient.read(response, 4) != 4 || response[0] != 0x20 || response[3] != 0x00) {
+        failProbe();
+        break;
+      }
+      probeConnectLatency = (long)(millis() - probeStepStart);
+      
+      const uint8_t pingRequest[] = {0xC0, 0x00};
+      probeStepStart = millis();
+      probeClient.write(pingRequest, sizeof(pingRequest));
+      probeStep = PROBE_PINGRESP;
+    }
+    // fall through
+    
+    case PROBE_PINGRESP: {
+      // PINGRESP: 0xD0 0x00
+      if (!waitForProbeBytes(2)) break;
+      uint8_t response[2];
+      long pingMs = (long)(millis() - probeStepStart);
+      if (probeClient.read(response, 2) != 2 || response[0] != 0xD0) {
+        failProbe();
+        break;
+      }
+      
+      const uint8_t disconnectRequest[] = {0xE0, 0x00};
+      probeClient.write(disconnectRequest, sizeof(disconnectRequest));
+      probeClient.stop();
+      
+      status[probeIndex].connectLatency = probeConnectLatency;
+      status[probeIndex].failed = false;
+      recordPing(probeIndex, pingMs);
+      probeStep = PROBE_NEXT;
+      break;
+    }
+    
+    case PROBE_FINISH:
+      // El PINGRESP del broker activo tiene el mismo plazo que un sondeo
+      if (activePingPending && millis() - lastProbe < MQTT_PROBE_TIMEOUT) break;
+      activePingPending = false;
+      probeStep = PROBE_IDLE;
+      failBackIfFaster();
+      break;
+  }
+}
+
+bool MQTTClient::openProbe(int index) {
+  const MqttBroker& broker = brokers[index];
+  
+  // Sesión efímera en un socket aparte: no interfiere con la conexión activa
+  char clientId[40];
+  snprintf(clientId, sizeof(clientId), "ESP32_%s_probe", deviceId.c_str());
+  
+  size_t idLength = strlen(clientId);
+  size_t userLength = strlen(broker.username);
+  size_t passLength = strlen(broker.password);
+  
+  // CONNECT MQTT 3.1.1 con clean session y keepalive de 10 s
+  uint8_t packet[160];
+  size_t remaining = 10 + 2 + idLength;
+  uint8_t flags = 0x02;
+  if (userLength > 0) {
+    flags |= 0x80;
+    remaining += 2 + userLength;
+  }
+  if (passLength > 0) {
+    flags |= 0x40;
+    remaining += 2 + passLength;
+  }
+  if (remaining + 3 > sizeof(packet)) {
+    return false;
+  }
+  
+  size_t pos = 0;
+  packet[pos++] = 0x10;
+  do {
+    uint8_t digit = remaining % 128;
+    remaining /= 128;
+    packet[pos++] = remaining > 0 ? (digit | 0x80) : digit;
+  } while (remaining > 0);
+  
+  const uint8_t header[] = {0x00, 0x04, 'M', 'Q', 'T', 'T', 0x04, flags, 0x00, 0x0A};
+  memcpy(packet + pos, header, sizeof(header));
+  pos += sizeof(header);
+  
+  const char* fields[] = {clientId, broker.username, broker.password};
+  const size_t lengths[] = {idLength, userLength, passLength};
+  for (int i = 0; i < 3; i++) {
+    if (i > 0 && lengths[i] == 0) continue;
+    packet[pos++] = (uint8_t)(lengths[i] >> 8);
+    packet[pos++] = (uint8_t)(lengths[i] & 0xFF);
+    memcpy(packet + pos, fields[i], lengths[i]);
+    pos += lengths[i];
+  }
+  
+  // La apertura TCP es el único paso bloqueante: acotada a MQTT_PROBE_CONNECT_TIMEOUT
+  probeStepStart = millis();
+  if (!probeClient.connect(broker.host, broker.port, MQTT_PROBE_CONNECT_TIMEOUT)) {
+    return false;
+  }
+  return probeClient.write(packet, pos) == pos;
+}
+
+bool MQTTClient::waitForProbeBytes(int count) {
+  // Espera corta dentro del paso: mide con precisión las respuestas de la LAN (pocos ms);
+  // las más lentas se detectan en vueltas siguientes, con la resolución del loop
+  unsigned long spinStart = millis();
+  while (probeClient.available() < count) {
+    if (millis() - probeStepStart >= MQTT_PROBE_TIMEOUT) {
+      failProbe();
+      return false;
+    }
+    if (millis() - spinStart >= MQTT_PROBE_SPIN) {
+      return false;
+    }
+    delay(1);
+  }
+  return true;
+}
+
+void MQTTClient::recordPing(int index, long pingMs) {
+  // Media móvil (3/4 histórico, 1/4 muestra) para no cambiar por un pico aislado
+  status[index].pingLatency = status[index].pingLatency < 0 ? pingMs : (3 * status[index].pingLatency + pingMs) / 4;
+  Serial.printf("MQTT probe %s: connect %ld ms, ping %ld ms%s\n", brokers[index].name,
+                status[index].connectLatency, status[index].pingLatency,
+                index == activeBroker ? " (active session)" : "");
+}
+
+void MQTTClient::failProbe() {
+  probeClient.stop();
+  
+  // El broker activo solo se marca caído si su propia conexión se pierde
+  if (probeIndex != activeBroker) {
+    status[probeIndex].failed = true;
+    status[probeIndex].lastFailure = millis();
+    Serial.printf("MQTT probe %s: unreachable\n", brokers[probeIndex].name);
+  }
+  probeStep = PROBE_NEXT;
+}
+
+void MQTTClient::failBackIfFaster() {
+  if (activeBroker < 0 || !mqttClient.connected() || status[activeBroker].pingLatency < 0) {
+    return;
+  }
+  
+  int best = activeBroker;
+  for (int i = 0; i < BROKER_COUNT; i++) {
+    if (i == activeBroker || status[i].failed || status[i].pingLatency < 0) continue;
+    if (status[i].pingLatency + MQTT_SWITCH_MARGIN < status[best].pingLatency) best = i;
+  }
+  
+  if (best != activeBroker) {
+    Serial.printf("Switching MQTT broker %s -> %s\n", brokers[activeBroker].name, brokers[best].name);
+    int previous = activeBroker;
+    mqttClient.disconnect();
+    activeBroker = -1;
+    if (!connectTo(best)) {
+      connectTo(previous);
+    }
+  }
+}
+
+const char* MQTTClient::getActiveBrokerName() {
+  return activeBroker >= 0 ? brokers[activeBroker].name : "none";
+}
+
+bool MQTTClient::publishSensorData(const char* jsonPayload) {
   if (!mqttClient.connected()) {
     Serial.println("MQTT not connected. Attempting reconnection...");
     if (!connect()) {
       Serial.println("Failed to reconnect to MQTT. Data not published.");
-      return;
+      return false;
     }
   }
   
-  bool published = mqttClient.publish(mqttTopic.c_str(), jsonPayload.c_str());
+  // Sin hueco para los campos de entrega se publica tal cual (telemetry-service no lo rastrea)
+  size_t length = appendDeliveryFields(jsonPayload);
+  const char* payload = length > 0 ? tracedPayload : jsonPayload;
+  if (length == 0) length = strlen(jsonPayload);
+  
+  bool published = mqttClient.publish(mqttTopic.c_str(), (const uint8_t*)payload, length,
+                                      false, MQTT_EXPIRY_SENSORS, CONTENT_TYPE_JSON);
   
   if (published) {
-    Serial.println("Data published to MQTT");
-    Serial.println("Topic: " + mqttTopic);
-    Serial.println("Payload: " + jsonPayload);
+    // Solo avanza con mensajes entregados al socket: un hueco en el servicio es pérdida en tránsito
+    sequence++;
+    Serial.print("Data published to MQTT (");
+    Serial.print(getActiveBrokerName());
+    Serial.println(")");
+    Serial.print("Topic: ");
+    Serial.println(mqttTopic);
+    Serial.print("Payload: ");
+    Serial.println(payload);
   } else {
     Serial.println("Failed to publish data to MQTT");
   }
+  
+  return published;
+}
+
+size_t MQTTClient::appendDeliveryFields(const char* jsonPayload) {
+  size_t length = strlen(jsonPayload);
+  if (length < 2 || jsonPayload[length - 1] != '}' || length >= sizeof(tracedPayload)) {
+    return 0;
+  }
+  
+  char publishedAt[WiFiManager::TIMESTAMP_MS_SIZE];
+  WiFiManager::formatTimestampMillis(publishedAt, sizeof(publishedAt), WiFiManager::getEpochMillis());
+  
+  // Reabrir el objeto raíz: se sustituye la '}' final
+  memcpy(tracedPayload, jsonPayload, length - 1);
+  size_t available = sizeof(tracedPayload) - (length - 1);
+  int written = snprintf(tracedPayload + length - 1, available, "%s\"seq\":%u,\"bootId\":\"%s\",\"publishedAt\":\"%s\"}",
+                         length > 2 ? "," : "", (unsigned)sequence, bootId, publishedAt);
+  if (written < 0 || (size_t)written >= available) {
+    return 0;
+  }
+  return length - 1 + written;
+}
+
+bool MQTTClient::publishAlert(const char* jsonPayload) {
+  // Sin reconexión bloqueante: la alerta queda pendiente y se reintenta en el siguiente loop
+  if (!mqttClient.connected()) {
+    return false;
+  }
+  
+  bool published = mqttClient.publish(alertTopic.c_str(), (const uint8_t*)jsonPayload, strlen(jsonPayload),
+                                      false, MQTT_EXPIRY_ALERTS, CONTENT_TYPE_JSON);
+  
+  if (published) {
+    Serial.println("Alert published to MQTT");
+    Serial.print("Topic: ");
+    Serial.println(alertTopic);
+    Serial.print("Payload: ");
+    Serial.println(jsonPayload);
+  } else {
+    Serial.println("Failed to publish alert to MQTT");
+  }
+  
+  return published;
+}
+
+bool MQTTClient::publishTrace(const char* line) {
+  if (!mqttClient.connected()) {
+    return false;
+  }
+  return mqttClient.publish(traceTopic.c_str(), (const uint8_t*)line, strlen(line), false,
+                            MQTT_EXPIRY_TRACE, CONTENT_TYPE_TEXT);
+}
+
+bool MQTTClient::publishBacklog(const uint8_t* block, size_t length) {
+  if (!mqttClient.connected()) {
+    return false;
+  }
+  return mqttClient.publish(backlogTopic.c_str(), block, length, false, MQTT_EXPIRY_BACKLOG,
+                            CONTENT_TYPE_BACKLOG);
+}
+
+bool MQTTClient::publishSelfTest(const char* jsonPayload) {
+  if (!mqttClient.connected()) {
+    return false;
+  }
+  
+  // Suscrito a su propio topic: el eco confirma credenciales, ACL y ruta completa
+  selfTestEchoed = false;
+  if (!mqttClient.subscribe(selfTestTopic.c_str())) {
+    return false;
+  }
+  if (!mqttClient.publish(selfTestTopic.c_str(), (const uint8_t*)jsonPayload, strlen(jsonPayload), false,
+                          MQTT_EXPIRY_SELFTEST, CONTENT_TYPE_JSON)) {
+    return false;
+  }
+  
+  unsigned long startTime = millis();
+  while (!selfTestEchoed && millis() - startTime < PROVISION_SELFTEST_TIMEOUT) {
+    if (!mqttClient.loop()) {
+      return false;
+    }
+    delay(10);
+  }
+  return selfTestEchoed;
+}
+
+bool MQTTClient::publishRelayed(const char* leafDeviceId, const char* jsonPayload) {
+  // Lectura de una hoja ESP-NOW en su propio topic; sin reconexión bloqueante
+  // (el gateway conserva el lote y lo reintenta)
+  if (!mqttClient.connected()) {
+    return false;
+  }
+  
+  // Shard de la hoja, no del gateway: el orden por dispositivo lo mantiene un solo consumidor
+  char topic[64];
+  formatIngestTopic(topic, sizeof(topic), leafDeviceId, "sensors");
+  return mqttClient.publish(topic, (const uint8_t*)jsonPayload, strlen(jsonPayload), false,
+                            MQTT_EXPIRY_SENSORS, CONTENT_TYPE_JSON);
+}
+
+uint32_t MQTTClient::getShard(const char* id) {
+  if (shardCount == 0) return 0;
+  
+  // FNV-1a de 32 bits: estable entre arranques y fácil de replicar en TypeScript
+  uint32_t hash = 2166136261u;
+  for (const char* c = id; *c; c++) {
+    hash ^= (uint8_t)*c;
+    hash *= 16777619u;
+  }
+  return hash % shardCount;
+}
+
+void MQTTClient::formatIngestTopic(char* buffer, size_t size, const char* id, const char* kind) {
+  if (shardCount == 0) {
+    snprintf(buffer, size, "devices/%s/%s", id, kind);
+  } else {
+    snprintf(buffer, size, "shard/%u/devices/%s/%s", (unsigned)getShard(id), id, kind);
+  }
+}
+
+bool MQTTClient::acceptsTraceCommands(int index) {
+  // Un broker sin usuario (anónimo) no puede restringir quién publica el comando
+  return index >= 0 && index < BROKER_COUNT && brokers[index].traceCommands &&
+         brokers[index].username[0] != '\0';
+}
+
+void MQTTClient::onMessage(char* topic, byte* payload, unsigned int length) {
+  if (selfTestTopic == topic) {
+    selfTestEchoed = true;
+    return;
+  }
+  
+  if (commandTopic != topic) {
+    return;
+  }
+  
+  // Solo se suscribe en brokers que lo admiten, pero la sesión pudo cambiar de broker
+  if (!acceptsTraceCommands(activeBroker)) {
+    Serial.println("Trace command ignored: broker without per-user ACL");
+    return;
+  }
+  
+  // Copiar antes de publicar: el cliente MQTT reutiliza su buffer para la respuesta
+  char command[32];
+  if (length >= sizeof(command)) length = sizeof(command) - 1;
+  memcpy(command, payload, length);
+  command[length] = '\0';
+  
+  TraceRecorder::handleCommand(command, TraceRecorder::SINK_MQTT);
 }
\ No newline at end of file
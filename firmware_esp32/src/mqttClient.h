@@ -4,22 +4,100 @@
 #ifndef MQTT_CLIENT_H
 #define MQTT_CLIENT_H
 
-#include <PubSubClient.h>
 #include <WiFi.h>
 
+#ifdef NATIVE_BUILD
+// Shim nativo: publica por NativeHost::MqttTransport (las propiedades MQTT 5 se ignoran)
+#include <PubSubClient.h>
+typedef PubSubClient MqttProtocolClient;
+#else
+#include "mqtt5Client.h"
+typedef Mqtt5Client MqttProtocolClient;
+#endif
+
+// Broker MQTT candidato (lista en orden de prioridad en mqttClient.cpp)
+struct MqttBroker {
+  const char* name;
+  const char* host;
+  uint16_t port;
+  const char* username;
+  const char* password;
+  bool traceCommands;    // ACL del broker: solo el operador escribe en trace/cmd
+};
+
+// Latencia medida y estado de disponibilidad de cada broker
+struct BrokerStatus {
+  long connectLatency;   // ms hasta CONNACK (-1 = sin medir)
+  long pingLatency;      // ms de PINGREQ a PINGRESP, media móvil (-1 = sin medir)
+  unsigned long lastFailure;
+  bool failed;
+};
+
 class MQTTClient {
 private:
   static WiFiClient wifiClient;
-  static PubSubClient mqttClient;
+  static WiFiClient probeClient;
+  static MqttProtocolClient mqttClient;
   static String deviceId;
   static String mqttTopic;
+  static String alertTopic;
+  static String commandTopic;
+  static String traceTopic;
+  static String backlogTopic;
+  static String selfTestTopic;
+  static bool selfTestEchoed;
+  static uint32_t shardCount;
+  
+  // Trazabilidad de entrega: secuencia por arranque de los mensajes de sensores
+  static char bootId[9];
+  static uint32_t sequence;
+  static char tracedPayload[];
   
+  static const MqttBroker brokers[];
+  static const int BROKER_COUNT;
+  static BrokerStatus status[];
+  static int activeBroker;
+  static unsigned long lastProbe;
+  
+  // Sondeo de latencia no bloqueante: un paso por loop(). Los brokers inactivos se
+  // miden con una sesión efímera; el activo, con PINGREQ en su propia sesión
+  enum ProbeStep { PROBE_IDLE, PROBE_NEXT, PROBE_CONNACK, PROBE_PINGRESP, PROBE_FINISH };
+  static ProbeStep probeStep;
+  static int probeIndex;
+  static unsigned long probeStepStart;
+  static long probeConnectLatency;
+  static bool activePingPending;
+  
+  static bool isEnabled(int index);
+  static bool connectTo(int index);
+  static void markFailure(int index);
+  static bool isEligible(int index, unsigned long now);
+  static long getScore(int index);
+  static void startProbeCycle();
+  static void stepProbe();
+  static bool openProbe(int index);
+  static bool waitForProbeBytes(int count);
+  static void recordPing(int index, long pingMs);
+  static void failProbe();
+  static void failBackIfFaster();
+  static void onMessage(char* topic, byte* payload, unsigned int length);
+  static bool acceptsTraceCommands(int index);
+  static void formatIngestTopic(char* buffer, size_t size, const char* id, const char* kind);
+  static size_t appendDeliveryFields(const char* jsonPayload);
+
 public:
   static void init();
   static bool connect();
   static bool isConnected();
   static void loop();
-  static void publishSensorData(const String& jsonPayload);
+  static bool publishSensorData(const char* jsonPayload);
+  static bool publishAlert(const char* jsonPayload);
+  static bool publishTrace(const char* line);
+  static bool publishBacklog(const uint8_t* block, size_t length);
+  static bool publishRelayed(const char* leafDeviceId, const char* jsonPayload);
+  static bool publishSelfTest(const char* jsonPayload);  // true = el broker devolvió el mensaje
+  static const char* getActiveBrokerName();
+  static uint32_t getShard(const char* id);  // FNV-1a del deviceId módulo shardCount
 };
 
 #endif
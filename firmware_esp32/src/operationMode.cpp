@@ -0,0 +1,181 @@
+// operationMode.cpp
+// ========================================
+
+#include "operationMode.h"
+#include "storage.h"
+#include "wifiManager.h"
+#include "mqttClient.h"
+#include "samplingScheduler.h"
+#include "alertEvaluator.h"
+#include "sensorBacklog.h"
+#include "espNowGateway.h"
+#include "espNowLeaf.h"
+#include "allocTracker.h"
+#include "config.h"
+
+unsigned long OperationMode::lastSensorReading = 0;
+unsigned long OperationMode::sensorInterval = SENSOR_INTERVAL;
+bool OperationMode::gatewayRole = false;
+bool OperationMode::leafRole = false;
+char OperationMode::payloadBuffer[Sensor::PAYLOAD_BUFFER_SIZE];
+char OperationMode::alertBuffer[256];
+
+void OperationMode::start() {
+  Serial.println("Starting operation mode...");
+  
+  String role = Storage::getDeviceRole();
+  gatewayRole = role == "gateway";
+  leafRole = role == "leaf";
+  Serial.println("Device role: " + role);
+  
+  if (leafRole) {
+    startLeaf();
+    return;
+  }
+  
+  // Conectar a WiFi. Sin red no se borra la configuración: un AP caído o fuera de
+  // alcance no debe devolver el equipo a modo setup (eso solo con el botón de reset)
+  bool wifiConnected = WiFiManager::connectToWiFi();
+  if (!wifiConnected) {
+    Serial.println("Failed to connect to WiFi. Running offline, will retry...");
+  }
+  
+  // Inicializar NTP
+  WiFiManager::initNTP();
+  
+  // Conectar a MQTT
+  SensorBacklog::init();
+  MQTTClient::init();
+  if (!wifiConnected || !MQTTClient::connect()) {
+    Serial.println("Failed to connect to MQTT. Will retry...");
+  } else {
+    Serial.println("MQTT connected successfully");
+  }
+  
+  // Gateway: ESP-NOW en el canal del AP al que ya está asociado
+  if (gatewayRole) {
+    EspNowGateway::init();
+  }
+  
+  Serial.println("Device ready for operation!");
+}
+
+void OperationMode::startLeaf() {
+  // Sin WiFi, NTP ni MQTT: el gateway pone la hora y publica por la hoja
+  if (!EspNowLeaf::init()) {
+    Serial.println("ESP-NOW unavailable on leaf node");
+  }
+  Serial.println("Leaf ready for operation!");
+}
+
+void OperationMode::loop() {
+  if (leafRole) {
+    loopLeaf();
+    return;
+  }
+  
+  // Reconexión y roaming WiFi (no bloquea salvo al reintentar o cambiar de AP)
+  WiFiManager::maintain();
+  
+  // Mantener conexión MQTT (sin WiFi cada intento solo agotaría el timeout)
+  if (!MQTTClient::isConnected() && WiFi.status() == WL_CONNECTED) {
+    Serial.println("MQTT disconnected, attempting reconnection...");
+    MQTTClient::connect();
+  }
+  MQTTClient::loop();
+  
+  // Subir lo acumulado sin conexión (un bloque por vuelta)
+  if (SensorBacklog::hasPending() && MQTTClient::isConnected()) {
+    SensorBacklog::uploadNext();
+  }
+  
+  // Lecturas de las hojas ESP-NOW
+  if (gatewayRole) {
+    EspNowGateway::loop();
+  }
+  
+  // Evaluar umbrales en cada muestra interna (no espera al siguiente intervalo)
+  checkAlerts();
+  
+  // Leer sensor periódicamente
+  unsigned long currentTime = millis();
+  if (currentTime - lastSensorReading >= sensorInterval) {
+    readAndPublishSensor();
+    lastSensorReading = currentTime;
+  }
+}
+
+void OperationMode::loopLeaf() {
+  EspNowLeaf::loop();
+  
+  // Umbrales: solo aceleran el muestreo; la alerta la genera el servicio con la lectura
+  float value;
+  if (Sensor::samplePrimaryValue(value) && AlertEvaluator::evaluate(value) &&
+      AlertEvaluator::isAlertActive()) {
+    sensorInterval = SamplingScheduler::resetToFloor();
+  }
+  AlertEvaluator::discardPending();
+  
+  unsigned long currentTime = millis();
+  if (currentTime - lastSensorReading >= sensorInterval) {
+    readAndPublishSensor();
+    lastSensorReading = currentTime;
+  }
+}
+
+void OperationMode::readAndPublishSensor() {
+  Serial.println("Reading sensor data...");
+  
+  // Para PIR, verificar si está estabilizado
+  if (Sensor::getSensorType() == "pir" && !Sensor::isPIRStabilized()) {
+    Serial.println("PIR still stabilizing, skipping this reading");
+    return;
+  }
+  
+  size_t length = Sensor::readAndFormat(payloadBuffer, sizeof(payloadBuffer));
+  if (length > 0) {
+    if (leafRole) {
+      if (!EspNowLeaf::sendReading(Sensor::getSensorType().c_str(), Sensor::getLastReading(),
+                                   Sensor::getMetricCount())) {
+        Serial.println("Reading not delivered to gateway (kept until next attempt)");
+      }
+    } else if (!MQTTClient::publishSensorData(payloadBuffer)) {
+      // Sin broker: guardar la lectura comprimida para subirla al reconectar.
+      // Arrancado sin red no hay hora NTP y la muestra no se puede fechar
+      if (WiFiManager::isTimeSet()) {
+        SensorBacklog::append(Sensor::getLastReadingTime(), Sensor::getLastReading());
+      } else {
+        Serial.println("Reading dropped: clock not synced yet");
+      }
+    }
+    
+    // Ajustar el intervalo según la dinámica de la señal
+    sensorInterval = SamplingScheduler::update(Sensor::getLastValue(), millis());
+  } else {
+    Serial.println("Failed to read sensor data");
+  }
+  
+  // Debug info
+  Serial.printf("Next reading in %lu seconds\n", sensorInterval/1000);
+  Serial.printf("Free heap: %u bytes\n", (unsigned)ESP.getFreeHeap());
+#ifdef ALLOC_TRACKING
+  AllocTracker::printStats("operation loop");
+#endif
+}
+
+void OperationMode::checkAlerts() {
+  float value;
+  if (Sensor::samplePrimaryValue(value) && AlertEvaluator::evaluate(value) &&
+      AlertEvaluator::isAlertActive()) {
+    // Acercarse al umbral ya acelera el muestreo; activar la alerta fuerza la
+    // siguiente lectura. Al desactivarse, el intervalo sigue su retroceso normal
+    sensorInterval = SamplingScheduler::resetToFloor();
+  }
+  
+  // En orden: una activación sin publicar sale antes que su desactivación
+  while (AlertEvaluator::hasPendingAlert() &&
+         AlertEvaluator::formatAlert(alertBuffer, sizeof(alertBuffer)) > 0 &&
+         MQTTClient::publishAlert(alertBuffer)) {
+    AlertEvaluator::markPublished();
+  }
+}
@@ -0,0 +1,34 @@
+// operationMode.h
+// ========================================
+
+#ifndef OPERATION_MODE_H
+#define OPERATION_MODE_H
+
+#include "sensor.h"
+
+// Bucle de operación (WiFi + MQTT + lecturas). Separado de main.cpp para que
+// el soak test nativo ejecute exactamente el mismo código.
+class OperationMode {
+private:
+  static unsigned long lastSensorReading;
+  static unsigned long sensorInterval;  // Ajustado por SamplingScheduler
+  
+  // Rol del nodo (Storage::getDeviceRole), resuelto una vez en start()
+  static bool gatewayRole;
+  static bool leafRole;
+  
+  // Buffers estáticos: una iteración en régimen estable no usa el heap
+  static char payloadBuffer[Sensor::PAYLOAD_BUFFER_SIZE];
+  static char alertBuffer[256];
+  
+  static void readAndPublishSensor();
+  static void checkAlerts();
+  static void startLeaf();
+  static void loopLeaf();
+  
+public:
+  static void start();
+  static void loop();
+};
+
+#endif
@@ -0,0 +1,269 @@
+// provisioning.cpp
+// ========================================
+
+#include "provisioning.h"
+#include "storage.h"
+#include "wifiManager.h"
+#include "mqttClient.h"
+#include "config.h"
+
+char Provisioning::ssid[33] = "";
+char Provisioning::password[65] = "";
+char Provisioning::deviceId[25] = "";
+char Provisioning::role[8] = DEVICE_ROLE;
+uint32_t Provisioning::shardCount = MQTT_SHARD_COUNT;
+char Provisioning::extraSsid[WIFI_MAX_PROFILES - 1][33];
+char Provisioning::extraPassword[WIFI_MAX_PROFILES - 1][65];
+uint8_t Provisioning::extraCount = 0;
+uint8_t Provisioning::espNowKey[16];
+bool Provisioning::hasEspNowKey = false;
+uint8_t Provisioning::leafMac[ESPNOW_MAX_LEAVES][6];
+char Provisioning::leafId[ESPNOW_MAX_LEAVES][25];
+uint8_t Provisioning::leafCount = 0;
+
+void Provisioning::handleCommand(const char* command) {
+  char line[96];
+  
+  if (strcmp(command, "hello") == 0) {
+    snprintf(line, sizeof(line), "PROV HELLO mac=%s sensor=%s role=%s configured=%d",
+             String(ESP.getEfuseMac(), HEX).c_str(), Storage::getSensorType().c_str(),
+             Storage::getDeviceRole().c_str(), Storage::hasConfig() ? 1 : 0);
+    reply(line);
+  } else if (strncmp(command, "ssid ", 5) == 0) {
+    store(ssid, sizeof(ssid), command + 5, "ssid");
+  } else if (strncmp(command, "pass ", 5) == 0) {
+    store(password, sizeof(password), command + 5, "pass");
+  } else if (strncmp(command, "id ", 3) == 0) {
+    if (!isValidDeviceId(command + 3)) {
+      reply("PROV ERROR id invalid");
+      return;
+    }
+    store(deviceId, sizeof(deviceId), command + 3, "id");
+  } else if (strncmp(command, "role ", 5) == 0) {
+    if (!isValidRole(command + 5)) {
+      reply("PROV ERROR role invalid");
+      return;
+    }
+    store(role, sizeof(role), command + 5, "role");
+  } else if (strncmp(command, "shards ", 7) == 0) {
+    char* end;
+    unsigned long count = strtoul(command + 7, &end, 10);
+    if (end == command + 7 || *end != '\0' || count > 255) {
+      reply("PROV ERROR shards invalid");
+      return;
+    }
+    shardCount = count;
+    reply("PROV ACK shards");
+  } else if (strncmp(command, "net ", 4) == 0) {
+    if (extraCount >= WIFI_MAX_PROFILES - 1) {
+      reply("PROV ERROR net too many networks");
+      return;
+    }
+    if (store(extraSsid[extraCount], sizeof(extraSsid[0]), command + 4, "net")) {
+      extraPassword[extraCount][0] = '\0';
+      extraCount++;
+    }
+  } else if (strncmp(command, "netpass ", 8) == 0) {
+    if (extraCount == 0) {
+      reply("PROV ERROR netpass no network");
+      return;
+    }
+    store(extraPassword[extraCount - 1], sizeof(extraPassword[0]), command + 8, "netpass");
+  } else if (strcmp(command, "netsave") == 0) {
+    // Añadir redes en campo: no toca el resto de la configuración ni reinicia
+    if (!Storage::hasConfig()) {
+      reply("PROV ERROR state not configured");
+    } else if (extraCount == 0) {
+      reply("PROV ERROR netsave no network");
+    } else if (!saveExtraNetworks()) {
+      reply("PROV ERROR netsave slots full");
+    } else {
+      reply("PROV ACK netsave");
+    }
+  } else if (strncmp(command, "espnowkey ", 10) == 0) {
+    if (!parseHex(command + 10, espNowKey, sizeof(espNowKey), '\0')) {
+      reply("PROV ERROR espnowkey invalid");
+      return;
+    }
+    hasEspNowKey = true;
+    reply("PROV ACK espnowkey");
+  } else if (strncmp(command, "leaf ", 5) == 0) {
+    addLeaf(command + 5);
+  } else if (strcmp(command, "leafsave") == 0) {
+    if (!Storage::hasConfig()) {
+      reply("PROV ERROR state not configured");
+    } else if (leafCount == 0) {
+      reply("PROV ERROR leafsave no leaf");
+    } else if (!saveLeaves()) {
+      reply("PROV ERROR leafsave slots full");
+    } else {
+      reply("PROV ACK leafsave");
+    }
+  } else if (strcmp(command, "commit") == 0) {
+    commit();
+  } else if (strcmp(command, "erase") == 0) {
+    Storage::clearConfig();
+    reply("PROV ERASED");
+    delay(200);
+    ESP.restart();
+  } else {
+    snprintf(line, sizeof(line), "PROV ERROR unknown command '%s'", command);
+    reply(line);
+  }
+}
+
+void Provisioning::reply(const char* line) {
+  Serial.println(line);
+}
+
+bool Provisioning::store(char* field, size_t size, const char* value, const char* name) {
+  char line[32];
+  size_t length = strlen(value);
+  if (length == 0 || length >= size) {
+    snprintf(line, sizeof(line), "PROV ERROR %s length", name);
+    reply(line);
+    return false;
+  }
+  
+  memcpy(field, value, length + 1);
+  snprintf(line, sizeof(line), "PROV ACK %s", name);
+  reply(line);
+  return true;
+}
+
+bool Provisioning::isValidDeviceId(const char* value) {
+  if (strlen(value) != 24) return false;
+  for (const char* c = value; *c; c++) {
+    if (!isxdigit((unsigned char)*c)) return false;
+  }
+  return true;
+}
+
+bool Provisioning::isValidRole(const char* value) {
+  return strcmp(value, "direct") == 0 || strcmp(value, "gateway") == 0 || strcmp(value, "leaf") == 0;
+}
+
+bool Provisioning::parseHex(const char* value, uint8_t* out, size_t size, char separator) {
+  // size bytes en hex, con un separador entre bytes si no es '\0' (MAC aa:bb:...)
+  for (size_t i = 0; i < size; i++) {
+    if (i > 0 && separator != '\0' && *value++ != separator) return false;
+    if (!isxdigit((unsigned char)value[0]) || !isxdigit((unsigned char)value[1])) return false;
+    char byte[3] = {value[0], value[1], '\0'};
+    out[i] = (uint8_t)strtoul(byte, nullptr, 16);
+    value += 2;
+  }
+  return *value == '\0';
+}
+
+void Provisioning::addLeaf(const char* value) {
+  if (leafCount >= ESPNOW_MAX_LEAVES) {
+    reply("PROV ERROR leaf too many leaves");
+    return;
+  }
+  
+  // "aa:bb:cc:dd:ee:ff <deviceId>"
+  const char* space = strchr(value, ' ');
+  char mac[18];
+  if (!space || space - value != 17) {
+    reply("PROV ERROR leaf invalid");
+    return;
+  }
+  memcpy(mac, value, 17);
+  mac[17] = '\0';
+  if (!parseHex(mac, leafMac[leafCount], 6, ':') || !isValidDeviceId(space + 1)) {
+    reply("PROV ERROR leaf invalid");
+    return;
+  }
+  
+  strcpy(leafId[leafCount], space + 1);
+  leafCount++;
+  reply("PROV ACK leaf");
+}
+
+void Provisioning::commit() {
+  // Solo sobre un dispositivo sin configurar: "prov erase" reinicia en modo setup
+  // antes de reaprovisionar, así el modo operación nunca queda a medias
+  if (Storage::hasConfig()) {
+    reply("PROV ERROR state already configured");
+    return;
+  }
+  if (ssid[0] == '\0' || deviceId[0] == '\0') {
+    reply("PROV ERROR state missing ssid or id");
+    return;
+  }
+  
+  Storage::saveConfig(ssid, password, deviceId);
+  Storage::setDeviceRole(role);
+  Storage::setShardCount(shardCount);
+  if (!saveExtraNetworks()) {
+    fail("wifi", "too many networks");
+    return;
+  }
+  if (hasEspNowKey) {
+    Storage::setEspNowKey(espNowKey);
+  }
+  if (!saveLeaves()) {
+    fail("espnow", "too many leaves");
+    return;
+  }
+  
+  reply("PROV TEST wifi");
+  if (!WiFiManager::connectToWiFi()) {
+    fail("wifi", "connection failed");
+    return;
+  }
+  
+  // Las hojas ESP-NOW también prueban WiFi y MQTT: son las credenciales del gateway
+  reply("PROV TEST mqtt");
+  WiFiManager::initNTP();
+  MQTTClient::init();
+  if (!MQTTClient::connect()) {
+    fail("mqtt", "no broker reachable");
+    return;
+  }
+  
+  reply("PROV TEST publish");
+  char payload[160];
+  snprintf(payload, sizeof(payload),
+           "{\"selfTest\":true,\"mac\":\"%s\",\"sensorType\":\"%s\",\"role\":\"%s\",\"rssi\":%d}",
+           String(ESP.getEfuseMac(), HEX).c_str(), Storage::getSensorType().c_str(), role, WiFi.RSSI());
+  if (!MQTTClient::publishSelfTest(payload)) {
+    fail("publish", "no echo from broker");
+    return;
+  }
+  
+  char line[96];
+  snprintf(line, sizeof(line), "PROV OK id=%s broker=%s rssi=%d shard=%u", deviceId,
+           MQTTClient::getActiveBrokerName(), WiFi.RSSI(), (unsigned)MQTTClient::getShard(deviceId));
+  reply(line);
+  
+  delay(200);
+  ESP.restart();
+}
+
+bool Provisioning::saveExtraNetworks() {
+  bool saved = true;
+  for (uint8_t i = 0; i < extraCount; i++) {
+    saved = Storage::addWiFiProfile(extraSsid[i], extraPassword[i]) && saved;
+  }
+  extraCount = 0;
+  return saved;
+}
+
+bool Provisioning::saveLeaves() {
+  bool saved = true;
+  for (uint8_t i = 0; i < leafCount; i++) {
+    saved = Storage::addEspNowLeaf(leafMac[i], leafId[i]) && saved;
+  }
+  leafCount = 0;
+  return saved;
+}
+
+void Provisioning::fail(const char* stage, const char* reason) {
+  Storage::clearConfig();
+  WiFi.disconnect();
+  
+  char line[96];
+  snprintf(line, sizeof(line), "PROV ERROR %s %s", stage, reason);
+  reply(line);
+}
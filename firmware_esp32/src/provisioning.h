@@ -0,0 +1,68 @@
+// provisioning.h
+// ========================================
+
+#ifndef PROVISIONING_H
+#define PROVISIONING_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Aprovisionamiento en bloque por USB (herramienta de host: native/provision).
+// Alternativa al portal cautivo: el deviceId ya viene activado en el backend,
+// así que no se llama a /api/devices/activate.
+//
+// Comandos (una línea cada uno, respuestas con prefijo "PROV"):
+//   prov hello             -> PROV HELLO mac=<efuse hex> sensor=<tipo> role=<rol> configured=<0|1>
+//   prov ssid <ssid>       -> PROV ACK ssid        (resto de la línea, admite espacios)
+//   prov pass <password>   -> PROV ACK pass
+//   prov id <deviceId>     -> PROV ACK id          (ObjectId de 24 caracteres hex)
+//   prov role <rol>        -> PROV ACK role        (direct | gateway | leaf)
+//   prov shards <n>        -> PROV ACK shards      (0-255, 0 = topics sin shard; ver MQTT_SHARD_COUNT)
+//   prov net <ssid>        -> PROV ACK net         (red extra, hasta WIFI_MAX_PROFILES - 1)
+//   prov netpass <pass>    -> PROV ACK netpass     (contraseña de la última red extra)
+//   prov netsave           -> PROV ACK netsave     (dispositivo ya configurado: guarda las
+//                             redes extra sin reiniciar ni borrar nada)
+//   prov espnowkey <hex>   -> PROV ACK espnowkey   (LMK de ESP-NOW, 32 hex; la misma en gateway y hojas)
+//   prov leaf <mac> <id>   -> PROV ACK leaf        (gateway: hoja aceptada, MAC aa:bb:cc:dd:ee:ff de
+//                             su STA, la que imprime al arrancar, y su deviceId; hasta ESPNOW_MAX_LEAVES)
+//   prov leafsave          -> PROV ACK leafsave    (como netsave, para las hojas)
+//   prov commit            -> PROV TEST wifi|mqtt|publish ... PROV OK id=<id> broker=<nombre> rssi=<dBm> shard=<n>
+//                             o PROV ERROR <etapa> <motivo>; tras OK reinicia en modo operación
+//   prov erase             -> PROV ERASED; borra la configuración y reinicia en modo setup
+//
+// commit guarda la configuración, conecta WiFi y MQTT y publica un mensaje de
+// prueba que el broker debe devolver. Si algo falla la configuración se borra:
+// un dispositivo solo queda configurado si pasó la prueba. La prueba WiFi vale
+// con cualquiera de las redes (se usa el AP conocido con mejor RSSI).
+class Provisioning {
+public:
+  static void handleCommand(const char* command);
+  
+private:
+  static char ssid[33];
+  static char password[65];
+  static char deviceId[25];
+  static char role[8];
+  static uint32_t shardCount;
+  static char extraSsid[WIFI_MAX_PROFILES - 1][33];
+  static char extraPassword[WIFI_MAX_PROFILES - 1][65];
+  static uint8_t extraCount;
+  static uint8_t espNowKey[16];
+  static bool hasEspNowKey;
+  static uint8_t leafMac[ESPNOW_MAX_LEAVES][6];
+  static char leafId[ESPNOW_MAX_LEAVES][25];
+  static uint8_t leafCount;
+  
+  static void reply(const char* line);
+  static bool store(char* field, size_t size, const char* value, const char* name);
+  static bool isValidDeviceId(const char* value);
+  static bool isValidRole(const char* value);
+  static bool parseHex(const char* value, uint8_t* out, size_t size, char separator);
+  static void addLeaf(const char* value);
+  static void commit();
+  static bool saveExtraNetworks();
+  static bool saveLeaves();
+  static void fail(const char* stage, const char* reason);
+};
+
+#endif
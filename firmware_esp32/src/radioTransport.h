@@ -0,0 +1,43 @@
+// radioTransport.h
+// ========================================
+
+#ifndef RADIO_TRANSPORT_H
+#define RADIO_TRANSPORT_H
+
+#include <Arduino.h>
+
+// Enlace de radio punto a punto entre nodos (ESP-NOW en el ESP32).
+// El build nativo lo sustituye por LoopbackRadio (native/arduino), un bus en
+// memoria entre placas virtuales, para probar gateway y hojas sin radios.
+class RadioTransport {
+public:
+  static const size_t MAC_SIZE = 6;
+  static const size_t MAX_FRAME_SIZE = 250;  // ESP_NOW_MAX_DATA_LEN
+  static const size_t KEY_SIZE = 16;         // ESP_NOW_KEY_LEN
+  static const uint8_t BROADCAST_MAC[MAC_SIZE];
+  
+  virtual ~RadioTransport() {}
+  
+  // Canal WiFi del enlace; con la STA asociada manda el canal del AP
+  virtual bool begin(uint8_t channel) = 0;
+  virtual uint8_t getChannel() = 0;
+  virtual void getMacAddress(uint8_t* mac) = 0;
+  
+  // Tras begin(): el unicast posterior va cifrado con la LMK (CCMP). El broadcast
+  // no admite cifrado y sigue en claro
+  virtual bool setKeys(const uint8_t* pmk, const uint8_t* lmk) = 0;
+  
+  // Registra un par cifrado: sin él no se descifran sus tramas aunque nunca se le envíe
+  virtual bool addPeer(const uint8_t* mac) = 0;
+  
+  // true = entregado (ACK de capa MAC en unicast, enviado en broadcast)
+  virtual bool send(const uint8_t* mac, const uint8_t* data, size_t length) = 0;
+  
+  // No bloqueante: copia la trama pendiente más antigua, 0 si no hay ninguna
+  virtual size_t receive(uint8_t* mac, uint8_t* data, size_t capacity) = 0;
+  
+  // Transporte de la plataforma (nullptr si la placa no tiene radio)
+  static RadioTransport* platform();
+};
+
+#endif
@@ -0,0 +1,88 @@
+// samplingScheduler.cpp
+// ========================================
+
+#include "samplingScheduler.h"
+#include "config.h"
+
+String SamplingScheduler::sensorType = "";
+unsigned long SamplingScheduler::currentInterval = SENSOR_INTERVAL;
+float SamplingScheduler::lastValue = 0.0f;
+unsigned long SamplingScheduler::lastSampleTime = 0;
+bool SamplingScheduler::hasLastValue = false;
+
+void SamplingScheduler::init(const String& type) {
+  sensorType = type;
+  currentInterval = SENSOR_INTERVAL;
+  hasLastValue = false;
+
+  Serial.println("Adaptive sampling: " + String(SAMPLING_MIN_INTERVAL/1000) + "s - " +
+                 String(SAMPLING_MAX_INTERVAL/1000) + "s");
+}
+
+float SamplingScheduler::getRateThreshold() {
+  if (sensorType == "dht22") return SAMPLING_RATE_DHT22;
+  return SAMPLING_RATE_MQ4;
+}
+
+bool SamplingScheduler::isBoolean() {
+  return sensorType == "pir";
+}
+
+bool SamplingScheduler::isNearThreshold(float value) {
+  // Margen absoluto: un porcentaje del umbral de temperatura cubriría
+  // cualquier habitación templada y el muestreo nunca se relajaría
+  if (sensorType == "dht22") {
+    return value >= THRESHOLD_DHT22_TEMPERATURE - SAMPLING_PROXIMITY_DHT22;
+  }
+  if (sensorType == "mq4") {
+    return value >= THRESHOLD_MQ4_GAS - SAMPLING_PROXIMITY_MQ4;
+  }
+  return false;  // PIR no tiene umbral, solo dinámica (movimiento)
+}
+
+unsigned long SamplingScheduler::update(float value, unsigned long now) {
+  float ratePerMinute = 0.0f;
+  if (hasLastValue && now > lastSampleTime) {
+    ratePerMinute = fabsf(value - lastValue) * 60000.0f / (float)(now - lastSampleTime);
+  }
+
+  // PIR es 0/1: un cambio entre lecturas separadas por el techo (5 min) da
+  // 0.2/min, así que una tasa no sirve; cualquier cambio de estado es dinámica
+  bool dynamic;
+  if (isBoolean()) {
+    dynamic = hasLastValue && value != lastValue;
+  } else {
+    dynamic = ratePerMinute >= getRateThreshold();
+  }
+  bool nearThreshold = isNearThreshold(value);
+
+  if (dynamic || nearThreshold) {
+    // Señal activa: muestrear al máximo ritmo permitido
+    currentInterval = SAMPLING_MIN_INTERVAL;
+  } else {
+    // Señal plana: retroceso exponencial hasta el techo
+    currentInterval = currentInterval * 2;
+    if (currentInterval > SAMPLING_MAX_INTERVAL) {
+      currentInterval = SAMPLING_MAX_INTERVAL;
+    }
+  }
+
+  lastValue = value;
+  lastSampleTime = now;
+  hasLastValue = true;
+
+  Serial.printf("Sampling rate: %.2f/min%s, next interval %lus\n",
+                ratePerMinute, nearThreshold ? " (near)" : "", currentInterval/1000);
+
+  return currentInterval;
+}
+
+unsigned long SamplingScheduler::resetToFloor() {
+  // El retroceso exponencial vuelve a empezar desde el piso, no desde el techo
+  currentInterval = SAMPLING_MIN_INTERVAL;
+  return currentInterval;
+}
+
+unsigned long SamplingScheduler::getInterval() {
+  return currentInterval;
+}
@@ -0,0 +1,30 @@
+// samplingScheduler.h
+// ========================================
+
+#ifndef SAMPLING_SCHEDULER_H
+#define SAMPLING_SCHEDULER_H
+
+#include <Arduino.h>
+
+// Intervalo de muestreo adaptativo: baja al piso cuando la señal cambia rápido
+// o se acerca al umbral de alerta, y se duplica hasta el techo cuando está plana.
+class SamplingScheduler {
+private:
+  static String sensorType;
+  static unsigned long currentInterval;
+  static float lastValue;
+  static unsigned long lastSampleTime;
+  static bool hasLastValue;
+
+  static float getRateThreshold();
+  static bool isBoolean();
+  static bool isNearThreshold(float value);
+
+public:
+  static void init(const String& type);
+  static unsigned long update(float value, unsigned long now);
+  static unsigned long resetToFloor();  // Alerta activada: siguiente lectura al piso
+  static unsigned long getInterval();
+};
+
+#endif
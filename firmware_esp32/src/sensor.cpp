@@ -4,6 +4,7 @@
 #include "sensor.h"
 #include "storage.h"
 #include "wifiManager.h"
+#include "traceRecorder.h"
 #include "config.h"
 #include <ArduinoJson.h>
 
@@ -20,6 +21,10 @@ bool Sensor::pirStabilized = false;
 unsigned long Sensor::pirInitTime = 0;
 bool Sensor::ledState = false;
 unsigned long Sensor::ledOffTime = 0;
+float Sensor::lastValue = 0.0f;
+unsigned long Sensor::lastDHTSampleTime = 0;
+float Sensor::lastReading[2] = {0.0f, 0.0f};
+uint32_t Sensor::lastReadingTime = 0;
 
 void Sensor::init() {
   // Cachear tipo de sensor una sola vez
@@ -73,7 +78,7 @@ bool Sensor::isPIRStabilized() {
       static unsigned long lastProgress = 0;
       if (millis() - lastProgress > 10000) {
         int remaining = (PIR_STABILIZATION_TIME - elapsed) / 1000;
-        Serial.println("PIR stabilizing... " + String(remaining) + " seconds remaining");
+        Serial.printf("PIR stabilizing... %d seconds remaining\n", remaining);
         lastProgress = millis();
       }
     }
@@ -88,13 +93,13 @@ void Sensor::checkPIRContinuously() {
   // No leer hasta que esté estabilizado
   if (!isPIRStabilized()) return;
   
-  bool currentReading = digitalRead(PIR_PIN) == HIGH;
+  bool currentReading = readMotionPin();
   
   // Si detecta movimiento
   if (currentReading) {
     if (!motionDetectedInInterval) {
       // Primera detección en este intervalo
-      Serial.println("MOTION DETECTED! Time: " + String(millis()));
+      Serial.printf("MOTION DETECTED! Time: %lu\n", millis());
       motionDetectedInInterval = true;
     }
     lastMotionTime = millis();
@@ -114,7 +119,7 @@ void Sensor::checkPIRContinuously() {
   if (ledState && millis() >= ledOffTime) {
     digitalWrite(LED_BUILTIN, LOW);
     ledState = false;
-    Serial.println("LED OFF - No motion for " + String(PIR_LED_DURATION/1000) + " seconds");
+    Serial.printf("LED OFF - No motion for %d seconds\n", PIR_LED_DURATION/1000);
   }
   
   // Debug cada 30 segundos si no hay movimiento
@@ -125,94 +130,187 @@ void Sensor::checkPIRContinuously() {
   }
 }
 
-String Sensor::readAndFormat() {
+size_t Sensor::readAndFormat(char* buffer, size_t size) {
   if (cachedSensorType == "dht22") {
-    return formatDHT22Reading();
+    return formatDHT22Reading(buffer, size);
   } else if (cachedSensorType == "mq4") {
-    return formatMQ4Reading();
+    return formatMQ4Reading(buffer, size);
   } else if (cachedSensorType == "pir") {
-    return formatPIRReading();
+    return formatPIRReading(buffer, size);
   }
   
-  return "";
+  return 0;
 }
 
-String Sensor::formatDHT22Reading() {
-  if (!dhtInitialized) {
-    Serial.println("DHT22 not initialized");
-    return "";
+const String& Sensor::getSensorType() {
+  return cachedSensorType;
+}
+
+float Sensor::getLastValue() {
+  return lastValue;
+}
+
+uint8_t Sensor::getMetricCount() {
+  return cachedSensorType == "dht22" ? 2 : 1;
+}
+
+const char* Sensor::getMetricName(uint8_t index) {
+  // Mismo orden que las lecturas del JSON
+  if (cachedSensorType == "dht22") return index == 0 ? "temperature" : "humidity";
+  if (cachedSensorType == "mq4") return "gas";
+  return "motion";
+}
+
+const float* Sensor::getLastReading() {
+  return lastReading;
+}
+
+uint32_t Sensor::getLastReadingTime() {
+  return lastReadingTime;
+}
+
+bool Sensor::samplePrimaryValue(float& value) {
+  if (cachedSensorType == "mq4") {
+    // Lectura analógica barata: se evalúa en cada vuelta del loop
+    value = (readGasRaw() / 4095.0) * 1000.0;
+    return true;
+  }
+  
+  if (cachedSensorType == "dht22" && dhtInitialized) {
+    if (lastDHTSampleTime != 0 && millis() - lastDHTSampleTime < DHT22_MIN_SAMPLE_INTERVAL) {
+      return false;
+    }
+    lastDHTSampleTime = millis();
+    float temperature = readTemperature();
+    if (isnan(temperature)) return false;
+    value = temperature;
+    return true;
   }
   
+  return false;
+}
+
+int Sensor::readGasRaw() {
+  int rawValue = analogRead(MQ4_PIN);
+  TraceRecorder::record(TraceRecorder::CHANNEL_MQ4_RAW, (float)rawValue);
+  return rawValue;
+}
+
+bool Sensor::readMotionPin() {
+  bool motion = digitalRead(PIR_PIN) == HIGH;
+  TraceRecorder::record(TraceRecorder::CHANNEL_PIR_PIN, motion ? 1.0f : 0.0f);
+  return motion;
+}
+
+float Sensor::readTemperature() {
   float temperature = dht.readTemperature();
+  TraceRecorder::record(TraceRecorder::CHANNEL_DHT_TEMPERATURE, temperature);
+  return temperature;
+}
+
+float Sensor::readHumidity() {
   float humidity = dht.readHumidity();
+  TraceRecorder::record(TraceRecorder::CHANNEL_DHT_HUMIDITY, humidity);
+  return humidity;
+}
+
+size_t Sensor::formatDHT22Reading(char* buffer, size_t size) {
+  if (!dhtInitialized) {
+    Serial.println("DHT22 not initialized");
+    return 0;
+  }
+  
+  float temperature = readTemperature();
+  float humidity = readHumidity();
   
   if (isnan(temperature) || isnan(humidity)) {
     Serial.println("Failed to read from DHT22 sensor");
-    return "";
+    return 0;
   }
   
-  String timestamp = WiFiManager::getCurrentTimestamp();
+  lastValue = temperature;
+  lastReading[0] = round(temperature * 10) / 10.0;
+  lastReading[1] = round(humidity * 10) / 10.0;
   
-  DynamicJsonDocument doc(1024);
+  char timestamp[WiFiManager::TIMESTAMP_SIZE];
+  WiFiManager::getCurrentTimestamp(timestamp, sizeof(timestamp));
+  lastReadingTime = WiFiManager::getEpochTime();
+  char sampledAt[WiFiManager::TIMESTAMP_MS_SIZE];
+  WiFiManager::formatTimestampMillis(sampledAt, sizeof(sampledAt), WiFiManager::getEpochMillis());
+  
+  StaticJsonDocument<384> doc;
   doc["sensorType"] = "dht22";
+  doc["sampledAt"] = sampledAt;  // Marca de adquisición con ms (latencia por salto)
   
   JsonArray readings = doc.createNestedArray("readings");
   
   JsonObject tempReading = readings.createNestedObject();
   tempReading["metric"] = "temperature";
-  tempReading["value"] = round(temperature * 10) / 10.0;
+  tempReading["value"] = lastReading[0];
   tempReading["timestamp"] = timestamp;
   
   JsonObject humReading = readings.createNestedObject();
   humReading["metric"] = "humidity";
-  humReading["value"] = round(humidity * 10) / 10.0;
+  humReading["value"] = lastReading[1];
   humReading["timestamp"] = timestamp;
   
-  String jsonString;
-  serializeJson(doc, jsonString);
+  size_t length = serializeJson(doc, buffer, size);
   
-  Serial.println("DHT22 Reading - Temp: " + String(temperature) + "°C, Humidity: " + String(humidity) + "%");
+  Serial.printf("DHT22 Reading - Temp: %.2f°C, Humidity: %.2f%%\n", temperature, humidity);
   
-  return jsonString;
+  return length;
 }
 
-String Sensor::formatMQ4Reading() {
-  int rawValue = analogRead(MQ4_PIN);
+size_t Sensor::formatMQ4Reading(char* buffer, size_t size) {
+  int rawValue = readGasRaw();
   float gasLevel = (rawValue / 4095.0) * 1000.0;
+  lastValue = gasLevel;
+  lastReading[0] = round(gasLevel * 10) / 10.0;
   
-  String timestamp = WiFiManager::getCurrentTimestamp();
+  char timestamp[WiFiManager::TIMESTAMP_SIZE];
+  WiFiManager::getCurrentTimestamp(timestamp, sizeof(timestamp));
+  lastReadingTime = WiFiManager::getEpochTime();
+  char sampledAt[WiFiManager::TIMESTAMP_MS_SIZE];
+  WiFiManager::formatTimestampMillis(sampledAt, sizeof(sampledAt), WiFiManager::getEpochMillis());
   
-  DynamicJsonDocument doc(1024);
+  StaticJsonDocument<256> doc;
   doc["sensorType"] = "mq4";
+  doc["sampledAt"] = sampledAt;
   
   JsonArray readings = doc.createNestedArray("readings");
   
   JsonObject gasReading = readings.createNestedObject();
   gasReading["metric"] = "gas";
-  gasReading["value"] = round(gasLevel * 10) / 10.0;
+  gasReading["value"] = lastReading[0];
   gasReading["timestamp"] = timestamp;
   
-  String jsonString;
-  serializeJson(doc, jsonString);
+  size_t length = serializeJson(doc, buffer, size);
   
-  Serial.println("MQ4 Reading - Gas: " + String(gasLevel) + " ppm (raw: " + String(rawValue) + ")");
+  Serial.printf("MQ4 Reading - Gas: %.2f ppm (raw: %d)\n", gasLevel, rawValue);
   
-  return jsonString;
+  return length;
 }
 
-String Sensor::formatPIRReading() {
+size_t Sensor::formatPIRReading(char* buffer, size_t size) {
   if (!isPIRStabilized()) {
     Serial.println("PIR not stabilized yet, skipping reading");
-    return "";
+    return 0;
   }
   
   // Usar el flag acumulado del intervalo, no lectura instantánea
   bool motionInLastMinute = motionDetectedInInterval;
+  lastValue = motionInLastMinute ? 1.0f : 0.0f;
+  lastReading[0] = lastValue;
   
-  String timestamp = WiFiManager::getCurrentTimestamp();
+  char timestamp[WiFiManager::TIMESTAMP_SIZE];
+  WiFiManager::getCurrentTimestamp(timestamp, sizeof(timestamp));
+  lastReadingTime = WiFiManager::getEpochTime();
+  char sampledAt[WiFiManager::TIMESTAMP_MS_SIZE];
+  WiFiManager::formatTimestampMillis(sampledAt, sizeof(sampledAt), WiFiManager::getEpochMillis());
   
-  DynamicJsonDocument doc(1024);
+  StaticJsonDocument<256> doc;
   doc["sensorType"] = "pir";
+  doc["sampledAt"] = sampledAt;
   
   JsonArray readings = doc.createNestedArray("readings");
   
@@ -221,16 +319,49 @@ String Sensor::formatPIRReading() {
   motionReading["value"] = motionInLastMinute;
   motionReading["timestamp"] = timestamp;
   
-  String jsonString;
-  serializeJson(doc, jsonString);
+  size_t length = serializeJson(doc, buffer, size);
   
-  Serial.println("PIR Reading - Motion in last minute: " + String(motionInLastMinute ? "YES" : "NO"));
+  Serial.printf("PIR Reading - Motion in last minute: %s\n", motionInLastMinute ? "YES" : "NO");
   if (motionInLastMinute) {
-    Serial.println("   Last motion detected at: " + String(lastMotionTime));
+    Serial.printf("   Last motion detected at: %lu\n", lastMotionTime);
   }
   
   // Reset del flag para el siguiente intervalo
   motionDetectedInInterval = false;
   
-  return jsonString;
+  return length;
+}
+
+size_t Sensor::formatRelayedReading(char* buffer, size_t size, const char* sensorType,
+                                    const float* values, uint8_t count, const char* timestamp) {
+  StaticJsonDocument<384> doc;
+  doc["sensorType"] = sensorType;
+  
+  JsonArray readings = doc.createNestedArray("readings");
+  
+  if (strcmp(sensorType, "dht22") == 0 && count == 2) {
+    JsonObject tempReading = readings.createNestedObject();
+    tempReading["metric"] = "temperature";
+    tempReading["value"] = values[0];
+    tempReading["timestamp"] = timestamp;
+    
+    JsonObject humReading = readings.createNestedObject();
+    humReading["metric"] = "humidity";
+    humReading["value"] = values[1];
+    humReading["timestamp"] = timestamp;
+  } else if (strcmp(sensorType, "mq4") == 0 && count == 1) {
+    JsonObject gasReading = readings.createNestedObject();
+    gasReading["metric"] = "gas";
+    gasReading["value"] = values[0];
+    gasReading["timestamp"] = timestamp;
+  } else if (strcmp(sensorType, "pir") == 0 && count == 1) {
+    JsonObject motionReading = readings.createNestedObject();
+    motionReading["metric"] = "motion";
+    motionReading["value"] = values[0] != 0.0f;
+    motionReading["timestamp"] = timestamp;
+  } else {
+    return 0;
+  }
+  
+  return serializeJson(doc, buffer, size);
 }
\ No newline at end of file
@@ -22,15 +22,43 @@ private:
   static bool ledState;
   static unsigned long ledOffTime;
   
-  static String formatDHT22Reading();
-  static String formatMQ4Reading();
-  static String formatPIRReading();
+  // Valor principal de la última lectura válida (para el muestreo adaptativo)
+  static float lastValue;
+  static unsigned long lastDHTSampleTime;
+  
+  // Última lectura publicada (valores redondeados como en el JSON), para el backlog
+  static float lastReading[2];
+  static uint32_t lastReadingTime;
+  
+  // Lecturas de hardware: único acceso a pines y DHT, grabadas por TraceRecorder
+  static int readGasRaw();
+  static bool readMotionPin();
+  static float readTemperature();
+  static float readHumidity();
+  
+  // Formatean en un buffer del llamador para no usar heap en cada lectura
+  static size_t formatDHT22Reading(char* buffer, size_t size);
+  static size_t formatMQ4Reading(char* buffer, size_t size);
+  static size_t formatPIRReading(char* buffer, size_t size);
   
 public:
+  static const size_t PAYLOAD_BUFFER_SIZE = 384;
+  
   static void init();
-  static String readAndFormat();
+  static size_t readAndFormat(char* buffer, size_t size);  // 0 si la lectura falla
   static void checkPIRContinuously();  // Nueva función para PIR
   static bool isPIRStabilized();       // Verificar si PIR está listo
+  static const String& getSensorType();
+  static float getLastValue();
+  static uint8_t getMetricCount();
+  static const char* getMetricName(uint8_t index);
+  static const float* getLastReading();
+  static uint32_t getLastReadingTime();
+  static bool samplePrimaryValue(float& value);  // Muestra interna para alertas
+  
+  // Mismo JSON que readAndFormat() para una lectura de otro nodo (hoja ESP-NOW)
+  static size_t formatRelayedReading(char* buffer, size_t size, const char* sensorType,
+                                     const float* values, uint8_t count, const char* timestamp);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,72 @@
+// sensorBacklog.cpp
+// ========================================
+
+#include "sensorBacklog.h"
+#include "sensor.h"
+#include "mqttClient.h"
+
+uint8_t SensorBacklog::storage[BACKLOG_BLOCK_COUNT][BACKLOG_BLOCK_SIZE];
+TimeSeriesBlock SensorBacklog::blocks[BACKLOG_BLOCK_COUNT];
+int SensorBacklog::oldest = 0;
+int SensorBacklog::used = 0;
+unsigned long SensorBacklog::droppedSamples = 0;
+
+void SensorBacklog::init() {
+  oldest = 0;
+  used = 0;
+  droppedSamples = 0;
+}
+
+void SensorBacklog::beginBlock(int index) {
+  const char* metricNames[TimeSeriesBlock::MAX_METRICS];
+  uint8_t metricCount = Sensor::getMetricCount();
+  for (uint8_t i = 0; i < metricCount && i < TimeSeriesBlock::MAX_METRICS; i++) {
+    metricNames[i] = Sensor::getMetricName(i);
+  }
+  blocks[index].begin(storage[index], BACKLOG_BLOCK_SIZE, Sensor::getSensorType().c_str(),
+                      metricNames, metricCount);
+}
+
+void SensorBacklog::append(uint32_t timestamp, const float* values) {
+  if (used == 0) {
+    beginBlock(oldest);
+    used = 1;
+  }
+  
+  int current = (oldest + used - 1) % BACKLOG_BLOCK_COUNT;
+  if (blocks[current].append(timestamp, values)) {
+    return;
+  }
+  
+  // Bloque lleno: abrir el siguiente, sacrificando el más antiguo si no hay sitio
+  if (used == BACKLOG_BLOCK_COUNT) {
+    droppedSamples += blocks[oldest].count();
+    Serial.printf("Backlog full, dropped %lu samples so far\n", droppedSamples);
+    oldest = (oldest + 1) % BACKLOG_BLOCK_COUNT;
+    used--;
+  }
+  
+  current = (oldest + used) % BACKLOG_BLOCK_COUNT;
+  beginBlock(current);
+  used++;
+  blocks[current].append(timestamp, values);
+}
+
+bool SensorBacklog::hasPending() {
+  return used > 0;
+}
+
+void SensorBacklog::uploadNext() {
+  if (used == 0) return;
+  
+  TimeSeriesBlock& block = blocks[oldest];
+  if (block.count() > 0 && !MQTTClient::publishBacklog(block.data(), block.size())) {
+    return;  // Se reintenta en la siguiente vuelta
+  }
+  
+  Serial.printf("Backlog block uploaded: %u samples, %u bytes\n",
+                (unsigned)block.count(), (unsigned)block.size());
+  
+  oldest = (oldest + 1) % BACKLOG_BLOCK_COUNT;
+  used--;
+}
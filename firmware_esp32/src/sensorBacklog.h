@@ -0,0 +1,30 @@
+// sensorBacklog.h
+// ========================================
+
+#ifndef SENSOR_BACKLOG_H
+#define SENSOR_BACKLOG_H
+
+#include "timeSeriesBlock.h"
+#include "config.h"
+
+// Lecturas que no se pudieron publicar (sin broker), comprimidas en bloques
+// TimeSeriesBlock en RAM. Al reconectar se suben a devices/{id}/backlog, un
+// bloque por vuelta del loop. Si se llenan todos, se descarta el más antiguo.
+class SensorBacklog {
+private:
+  static uint8_t storage[BACKLOG_BLOCK_COUNT][BACKLOG_BLOCK_SIZE];
+  static TimeSeriesBlock blocks[BACKLOG_BLOCK_COUNT];
+  static int oldest;   // Índice del bloque más antiguo del anillo
+  static int used;     // Bloques con muestras (el último es el que se está llenando)
+  static unsigned long droppedSamples;
+  
+  static void beginBlock(int index);
+  
+public:
+  static void init();
+  static void append(uint32_t timestamp, const float* values);
+  static bool hasPending();
+  static void uploadNext();
+};
+
+#endif
@@ -0,0 +1,51 @@
+// serialConsole.cpp
+// ========================================
+
+#include "serialConsole.h"
+#include "traceRecorder.h"
+#include "provisioning.h"
+
+char SerialConsole::line[96];
+size_t SerialConsole::length = 0;
+bool SerialConsole::overflow = false;
+
+void SerialConsole::poll() {
+  while (Serial.available() > 0) {
+    char c = (char)Serial.read();
+    
+    if (c == '\r') continue;
+    
+    if (c == '\n') {
+      line[length] = '\0';
+      if (overflow) {
+        Serial.println("Serial command too long, ignored");
+      } else if (length > 0) {
+        dispatch(line);
+      }
+      length = 0;
+      overflow = false;
+      continue;
+    }
+    
+    if (length < sizeof(line) - 1) {
+      line[length++] = c;
+    } else {
+      overflow = true;
+    }
+  }
+}
+
+void SerialConsole::dispatch(const char* command) {
+  if (strncmp(command, "trace ", 6) == 0) {
+    TraceRecorder::handleCommand(command + 6, TraceRecorder::SINK_SERIAL);
+    return;
+  }
+  
+  if (strncmp(command, "prov ", 5) == 0) {
+    Provisioning::handleCommand(command + 5);
+    return;
+  }
+  
+  Serial.print("Unknown serial command: ");
+  Serial.println(command);
+}
@@ -0,0 +1,24 @@
+// serialConsole.h
+// ========================================
+
+#ifndef SERIAL_CONSOLE_H
+#define SERIAL_CONSOLE_H
+
+#include <Arduino.h>
+
+// Comandos por línea en el puerto serie (monitor de PlatformIO o scripts):
+//   trace start|stop|boot|dump|status|clear
+//   prov hello|ssid|pass|id|role|shards|net|netpass|netsave|commit|erase  (ver provisioning.h)
+class SerialConsole {
+private:
+  static char line[96];
+  static size_t length;
+  static bool overflow;
+  
+  static void dispatch(const char* command);
+  
+public:
+  static void poll();
+};
+
+#endif
@@ -44,6 +44,58 @@ bool Storage::loadConfig(String& ssid, String& password, String& deviceId) {
   return true;
 }
 
+void Storage::profileKeys(uint8_t slot, char* ssidKey, char* passwordKey) {
+  // Slot 0 = claves originales: hasConfig() y loadConfig() no cambian
+  if (slot == 0) {
+    strcpy(ssidKey, "ssid");
+    strcpy(passwordKey, "password");
+  } else {
+    sprintf(ssidKey, "ssid%u", (unsigned)slot);
+    sprintf(passwordKey, "password%u", (unsigned)slot);
+  }
+}
+
+bool Storage::loadWiFiProfile(uint8_t slot, String& ssid, String& password) {
+  char ssidKey[12], passwordKey[12];
+  if (slot >= WIFI_MAX_PROFILES) return false;
+  profileKeys(slot, ssidKey, passwordKey);
+  if (!prefs.isKey(ssidKey)) return false;
+  
+  ssid = prefs.getString(ssidKey, "");
+  password = prefs.getString(passwordKey, "");
+  return ssid.length() > 0;
+}
+
+bool Storage::addWiFiProfile(const String& ssid, const String& password) {
+  char ssidKey[12], passwordKey[12];
+  int freeSlot = -1;
+  
+  // Mismo SSID: se actualiza la contraseña; si no, primer slot extra libre
+  for (uint8_t slot = 0; slot < WIFI_MAX_PROFILES; slot++) {
+    profileKeys(slot, ssidKey, passwordKey);
+    if (!prefs.isKey(ssidKey)) {
+      if (slot > 0 && freeSlot < 0) freeSlot = slot;
+      continue;
+    }
+    if (prefs.getString(ssidKey, "") == ssid) {
+      prefs.putString(passwordKey, password);
+      Serial.println("WiFi profile updated: " + ssid);
+      return true;
+    }
+  }
+  
+  if (freeSlot < 0) {
+    Serial.println("WiFi profile not saved (all slots in use): " + ssid);
+    return false;
+  }
+  
+  profileKeys(freeSlot, ssidKey, passwordKey);
+  prefs.putString(ssidKey, ssid);
+  prefs.putString(passwordKey, password);
+  Serial.printf("WiFi profile %d saved: %s\n", freeSlot, ssid.c_str());
+  return true;
+}
+
 void Storage::clearConfig() {
   prefs.clear();
   Serial.println("Configuration cleared from flash");
@@ -56,4 +108,110 @@ void Storage::clearConfig() {
 String Storage::getSensorType() {
   // Usar valor por defecto de config.h si no existe en flash
   return prefs.getString("sensorType", SENSOR_TYPE);
-}
\ No newline at end of file
+}
+
+void Storage::setTraceOnBoot(bool enabled) {
+  // Bandera de un solo uso: TraceRecorder::init() la consume al arrancar
+  prefs.putBool("traceOnBoot", enabled);
+}
+
+bool Storage::getTraceOnBoot() {
+  return prefs.getBool("traceOnBoot", false);
+}
+
+String Storage::getDeviceRole() {
+  // "direct" | "gateway" | "leaf"; por defecto el de config.h
+  return prefs.getString("role", DEVICE_ROLE);
+}
+
+void Storage::setDeviceRole(const String& role) {
+  prefs.putString("role", role);
+}
+
+uint32_t Storage::getShardCount() {
+  // Toda la flota debe usar el mismo número: define el reparto entre consumidores
+  return prefs.getUInt("shardCount", MQTT_SHARD_COUNT);
+}
+
+void Storage::setShardCount(uint32_t count) {
+  prefs.putUInt("shardCount", count);
+}
+
+void Storage::saveEspNowGateway(const uint8_t* mac, uint8_t channel) {
+  // Caché del descubrimiento: la hoja no barre canales en cada arranque
+  prefs.putBytes("espnowGateway", mac, 6);
+  prefs.putUInt("espnowChannel", channel);
+}
+
+bool Storage::loadEspNowGateway(uint8_t* mac, uint8_t& channel) {
+  if (prefs.getBytesLength("espnowGateway") != 6) {
+    return false;
+  }
+  prefs.getBytes("espnowGateway", mac, 6);
+  channel = prefs.getUInt("espnowChannel", 1);
+  return true;
+}
+
+void Storage::clearEspNowGateway() {
+  prefs.remove("espnowGateway");
+  prefs.remove("espnowChannel");
+}
+
+void Storage::setEspNowKey(const uint8_t* lmk) {
+  prefs.putBytes("espnowLmk", lmk, 16);
+}
+
+void Storage::loadEspNowKey(uint8_t* lmk) {
+  if (prefs.getBytesLength("espnowLmk") == 16) {
+    prefs.getBytes("espnowLmk", lmk, 16);
+  } else {
+    memcpy(lmk, ESPNOW_LMK, 16);
+  }
+}
+
+void Storage::leafKeys(uint8_t slot, char* macKey, char* idKey) {
+  sprintf(macKey, "leafMac%u", (unsigned)slot);
+  sprintf(idKey, "leafId%u", (unsigned)slot);
+}
+
+bool Storage::addEspNowLeaf(const uint8_t* mac, const String& deviceId) {
+  char macKey[12], idKey[12];
+  int freeSlot = -1;
+  
+  // Misma MAC: se actualiza el deviceId; si no, primer slot libre
+  for (uint8_t slot = 0; slot < ESPNOW_MAX_LEAVES; slot++) {
+    leafKeys(slot, macKey, idKey);
+    if (prefs.getBytesLength(macKey) != 6) {
+      if (freeSlot < 0) freeSlot = slot;
+      continue;
+    }
+    uint8_t stored[6];
+    prefs.getBytes(macKey, stored, 6);
+    if (memcmp(stored, mac, 6) == 0) {
+      prefs.putString(idKey, deviceId);
+      return true;
+    }
+  }
+  
+  if (freeSlot < 0) {
+    Serial.println("ESP-NOW leaf not saved (all slots in use): " + deviceId);
+    return false;
+  }
+  
+  leafKeys(freeSlot, macKey, idKey);
+  prefs.putBytes(macKey, mac, 6);
+  prefs.putString(idKey, deviceId);
+  Serial.printf("ESP-NOW leaf %d saved: %s\n", freeSlot, deviceId.c_str());
+  return true;
+}
+
+bool Storage::loadEspNowLeaf(uint8_t slot, uint8_t* mac, String& deviceId) {
+  char macKey[12], idKey[12];
+  if (slot >= ESPNOW_MAX_LEAVES) return false;
+  leafKeys(slot, macKey, idKey);
+  if (prefs.getBytesLength(macKey) != 6) return false;
+  
+  prefs.getBytes(macKey, mac, 6);
+  deviceId = prefs.getString(idKey, "");
+  return deviceId.length() > 0;
+}
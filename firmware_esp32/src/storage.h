@@ -10,13 +10,34 @@ class Storage {
 private:
   static Preferences prefs;
   
+  static void profileKeys(uint8_t slot, char* ssidKey, char* passwordKey);
+  static void leafKeys(uint8_t slot, char* macKey, char* idKey);
+  
 public:
   static void init();
   static bool hasConfig();
   static void saveConfig(const String& ssid, const String& password, const String& deviceId);
   static bool loadConfig(String& ssid, String& password, String& deviceId);
   static void clearConfig();
+  // Perfiles WiFi: el slot 0 es la red de saveConfig(); 1..WIFI_MAX_PROFILES-1 son extra
+  static bool loadWiFiProfile(uint8_t slot, String& ssid, String& password);
+  static bool addWiFiProfile(const String& ssid, const String& password);
   static String getSensorType();
+  static void setTraceOnBoot(bool enabled);
+  static bool getTraceOnBoot();
+  static String getDeviceRole();
+  static void setDeviceRole(const String& role);
+  static uint32_t getShardCount();
+  static void setShardCount(uint32_t count);
+  static void saveEspNowGateway(const uint8_t* mac, uint8_t channel);
+  static bool loadEspNowGateway(uint8_t* mac, uint8_t& channel);
+  static void clearEspNowGateway();
+  // LMK de ESP-NOW aprovisionada ("prov espnowkey"); sin ella, ESPNOW_LMK de config.h
+  static void setEspNowKey(const uint8_t* lmk);
+  static void loadEspNowKey(uint8_t* lmk);
+  // Hojas que un gateway acepta: MAC de la STA y deviceId (slots 0..ESPNOW_MAX_LEAVES-1)
+  static bool addEspNowLeaf(const uint8_t* mac, const String& deviceId);
+  static bool loadEspNowLeaf(uint8_t slot, uint8_t* mac, String& deviceId);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,152 @@
+// timeSeriesBlock.cpp
+// ========================================
+
+#include "timeSeriesBlock.h"
+
+// Peor caso por muestra: '1111' + 32 bits de timestamp y '11' + 5 + 5 + 32 bits por métrica
+static const size_t WORST_TIMESTAMP_BITS = 36;
+static const size_t WORST_VALUE_BITS = 44;
+
+void TimeSeriesBlock::begin(uint8_t* buffer, size_t capacity, const char* sensorType,
+                            const char* const* metricNames, uint8_t metricCount) {
+  this->buffer = buffer;
+  this->capacity = capacity;
+  this->metricCount = metricCount > MAX_METRICS ? MAX_METRICS : metricCount;
+  
+  size_t pos = 0;
+  buffer[pos++] = MAGIC;
+  buffer[pos++] = FORMAT_VERSION;
+  
+  size_t length = strlen(sensorType);
+  buffer[pos++] = (uint8_t)length;
+  memcpy(buffer + pos, sensorType, length);
+  pos += length;
+  
+  buffer[pos++] = this->metricCount;
+  for (uint8_t i = 0; i < this->metricCount; i++) {
+    length = strlen(metricNames[i]);
+    buffer[pos++] = (uint8_t)length;
+    memcpy(buffer + pos, metricNames[i], length);
+    pos += length;
+  }
+  
+  // Contador de muestras (se actualiza en cada append)
+  headerSize = pos + 2;
+  reset();
+}
+
+void TimeSeriesBlock::reset() {
+  sampleCount = 0;
+  bitPosition = headerSize * 8;
+  buffer[headerSize - 2] = 0;
+  buffer[headerSize - 1] = 0;
+  previousTimestamp = 0;
+  previousDelta = 0;
+  for (uint8_t i = 0; i < MAX_METRICS; i++) {
+    previousValue[i] = 0;
+    hasWindow[i] = false;
+  }
+}
+
+bool TimeSeriesBlock::append(uint32_t timestamp, const float* values) {
+  size_t worstBits = WORST_TIMESTAMP_BITS + WORST_VALUE_BITS * metricCount;
+  if (bitPosition + worstBits > capacity * 8 || sampleCount == 0xFFFF) {
+    return false;
+  }
+  
+  writeTimestamp(timestamp);
+  for (uint8_t i = 0; i < metricCount; i++) {
+    writeValue(i, values[i]);
+  }
+  
+  sampleCount++;
+  buffer[headerSize - 2] = sampleCount & 0xFF;
+  buffer[headerSize - 1] = sampleCount >> 8;
+  return true;
+}
+
+void TimeSeriesBlock::writeTimestamp(uint32_t timestamp) {
+  if (sampleCount == 0) {
+    writeBits(timestamp, 32);
+    previousTimestamp = timestamp;
+    previousDelta = 0;
+    return;
+  }
+  
+  // Intervalo regular => delta-of-delta 0 => un solo bit
+  int32_t delta = (int32_t)(timestamp - previousTimestamp);
+  int32_t deltaOfDelta = delta - previousDelta;
+  
+  if (deltaOfDelta == 0) {
+    writeBits(0x0, 1);
+  } else if (deltaOfDelta >= -63 && deltaOfDelta <= 64) {
+    writeBits(0x2, 2);
+    writeBits((uint32_t)(deltaOfDelta + 63), 7);
+  } else if (deltaOfDelta >= -255 && deltaOfDelta <= 256) {
+    writeBits(0x6, 3);
+    writeBits((uint32_t)(deltaOfDelta + 255), 9);
+  } else if (deltaOfDelta >= -2047 && deltaOfDelta <= 2048) {
+    writeBits(0xE, 4);
+    writeBits((uint32_t)(deltaOfDelta + 2047), 12);
+  } else {
+    writeBits(0xF, 4);
+    writeBits((uint32_t)deltaOfDelta, 32);
+  }
+  
+  previousTimestamp = timestamp;
+  previousDelta = delta;
+}
+
+void TimeSeriesBlock::writeValue(uint8_t metric, float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  
+  if (sampleCount == 0) {
+    writeBits(bits, 32);
+    previousValue[metric] = bits;
+    return;
+  }
+  
+  uint32_t xorValue = bits ^ previousValue[metric];
+  previousValue[metric] = bits;
+  
+  if (xorValue == 0) {
+    writeBits(0x0, 1);
+    return;
+  }
+  
+  uint8_t leading = __builtin_clz(xorValue);
+  uint8_t trailing = __builtin_ctz(xorValue);
+  
+  if (hasWindow[metric] && leading >= previousLeading[metric] && trailing >= previousTrailing[metric]) {
+    // Cabe en la ventana anterior: solo los bits significativos
+    uint8_t meaningful = 32 - previousLeading[metric] - previousTrailing[metric];
+    writeBits(0x2, 2);
+    writeBits(xorValue >> previousTrailing[metric], meaningful);
+    return;
+  }
+  
+  uint8_t meaningful = 32 - leading - trailing;
+  writeBits(0x3, 2);
+  writeBits(leading, 5);
+  writeBits(meaningful - 1, 5);
+  writeBits(xorValue >> trailing, meaningful);
+  
+  previousLeading[metric] = leading;
+  previousTrailing[metric] = trailing;
+  hasWindow[metric] = true;
+}
+
+void TimeSeriesBlock::writeBits(uint32_t value, uint8_t bits) {
+  for (int i = bits - 1; i >= 0; i--) {
+    size_t byteIndex = bitPosition / 8;
+    uint8_t mask = 0x80 >> (bitPosition % 8);
+    if (bitPosition % 8 == 0) {
+      buffer[byteIndex] = 0;
+    }
+    if ((value >> i) & 1) {
+      buffer[byteIndex] |= mask;
+    }
+    bitPosition++;
+  }
+}
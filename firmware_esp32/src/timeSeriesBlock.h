@@ -0,0 +1,55 @@
+// timeSeriesBlock.h
+// ========================================
+
+#ifndef TIME_SERIES_BLOCK_H
+#define TIME_SERIES_BLOCK_H
+
+#include <Arduino.h>
+
+// Bloque comprimido de lecturas (estilo Gorilla) para subir el backlog offline.
+// Decodificador espejo en telemetry-service (src/utils/timeSeriesBlock.ts).
+//
+// Cabecera:
+//   0x47 | versión u8 | len u8 + sensorType | nMétricas u8 | (len u8 + nombre)* | nMuestras u16 LE
+// Flujo de bits (MSB primero), por muestra:
+//   timestamp  1ª: 32 bits (epoch s). Resto: delta-of-delta
+//              '0' = 0 | '10' + 7 bits | '110' + 9 bits | '1110' + 12 bits | '1111' + 32 bits
+//   valor      1º: 32 bits (float). Resto: XOR con el anterior
+//              '0' = igual | '10' + bits significativos en la ventana previa
+//              | '11' + 5 bits ceros a la izquierda + 5 bits (longitud - 1) + bits significativos
+class TimeSeriesBlock {
+public:
+  static const uint8_t MAGIC = 0x47;
+  static const uint8_t FORMAT_VERSION = 1;
+  static const uint8_t MAX_METRICS = 2;
+  
+  void begin(uint8_t* buffer, size_t capacity, const char* sensorType,
+             const char* const* metricNames, uint8_t metricCount);
+  bool append(uint32_t timestamp, const float* values);  // false = bloque lleno
+  void reset();  // Vacía las muestras conservando la cabecera
+  
+  const uint8_t* data() const { return buffer; }
+  size_t size() const { return (bitPosition + 7) / 8; }
+  uint16_t count() const { return sampleCount; }
+  
+private:
+  uint8_t* buffer = nullptr;
+  size_t capacity = 0;
+  size_t headerSize = 0;
+  size_t bitPosition = 0;
+  uint8_t metricCount = 0;
+  uint16_t sampleCount = 0;
+  
+  uint32_t previousTimestamp = 0;
+  int32_t previousDelta = 0;
+  uint32_t previousValue[MAX_METRICS] = {0};
+  uint8_t previousLeading[MAX_METRICS] = {0};
+  uint8_t previousTrailing[MAX_METRICS] = {0};
+  bool hasWindow[MAX_METRICS] = {false};
+  
+  void writeBits(uint32_t value, uint8_t bits);
+  void writeTimestamp(uint32_t timestamp);
+  void writeValue(uint8_t metric, float value);
+};
+
+#endif
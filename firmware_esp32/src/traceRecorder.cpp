@@ -0,0 +1,344 @@
+// traceRecorder.cpp
+// ========================================
+
+#include "traceRecorder.h"
+#include "storage.h"
+#include "mqttClient.h"
+#include "wifiManager.h"
+#include "config.h"
+
+bool TraceRecorder::mounted = false;
+bool TraceRecorder::recording = false;
+uint32_t TraceRecorder::startMillis = 0;
+uint32_t TraceRecorder::startEpoch = 0;
+float TraceRecorder::lastValues[CHANNEL_COUNT];
+bool TraceRecorder::hasLastValue[CHANNEL_COUNT];
+uint8_t TraceRecorder::buffer[512];
+size_t TraceRecorder::buffered = 0;
+size_t TraceRecorder::fileSize = 0;
+unsigned long TraceRecorder::lastFlush = 0;
+
+bool TraceRecorder::uploading = false;
+TraceRecorder::Sink TraceRecorder::uploadSink = TraceRecorder::SINK_SERIAL;
+File TraceRecorder::uploadFile;
+size_t TraceRecorder::uploadSize = 0;
+size_t TraceRecorder::uploadOffset = 0;
+uint32_t TraceRecorder::uploadCrc = 0;
+
+// Epoch anterior a esta fecha = NTP aún sin sincronizar
+static const uint32_t MIN_VALID_EPOCH = 1600000000UL;
+
+void TraceRecorder::init() {
+  // formatOnFail: la primera vez la partición spiffs viene sin formato
+  mounted = LittleFS.begin(true);
+  if (!mounted) {
+    Serial.println("LittleFS mount failed, sensor trace disabled");
+    return;
+  }
+  
+  if (LittleFS.exists(TRACE_FILE_PATH)) {
+    File file = LittleFS.open(TRACE_FILE_PATH, FILE_READ);
+    Serial.printf("Sensor trace on flash: %u bytes\n", (unsigned)file.size());
+    file.close();
+  }
+  
+  // "trace boot" arma la grabación desde el arranque (estabilización PIR incluida)
+  if (Storage::getTraceOnBoot()) {
+    Storage::setTraceOnBoot(false);
+    start();
+  }
+}
+
+void TraceRecorder::loop() {
+  if (recording) {
+    resolveStartEpoch();
+    if (buffered > 0 && millis() - lastFlush >= TRACE_FLUSH_INTERVAL) {
+      flush();
+    }
+  }
+  
+  if (uploading) {
+    continueUpload();
+  }
+}
+
+bool TraceRecorder::isRecording() {
+  return recording;
+}
+
+void TraceRecorder::record(Channel channel, float value) {
+  if (!recording) return;
+  
+  // Solo cambios (comparación bit a bit: NaN repetido de un DHT fallido no se graba dos veces)
+  if (hasLastValue[channel] && memcmp(&lastValues[channel], &value, sizeof(float)) == 0) {
+    return;
+  }
+  
+  // Ruido dentro de la banda muerta: la reproducción mantiene el último valor grabado
+  if (hasLastValue[channel] && fabsf(value - lastValues[channel]) < getDeadband(channel)) {
+    return;
+  }
+  
+  if (fileSize + buffered + RECORD_SIZE > TRACE_MAX_BYTES) {
+    Serial.println("Sensor trace full, recording stopped");
+    stop();
+    return;
+  }
+  
+  lastValues[channel] = value;
+  hasLastValue[channel] = true;
+  
+  encodeRecord(buffer + buffered, millis() - startMillis, channel, value);
+  buffered += RECORD_SIZE;
+  
+  if (buffered + RECORD_SIZE > sizeof(buffer)) {
+    flush();
+  }
+}
+
+float TraceRecorder::getDeadband(Channel channel) {
+  return channel == CHANNEL_MQ4_RAW ? TRACE_DEADBAND_MQ4_RAW : 0.0f;
+}
+
+void TraceRecorder::start() {
+  if (!mounted) {
+    Serial.println("Sensor trace unavailable (no filesystem)");
+    return;
+  }
+  
+  startMillis = millis();
+  startEpoch = 0;
+  resolveStartEpoch();
+  
+  // Desde flash: con "trace boot" se arranca antes de Sensor::init()
+  String sensorType = Storage::getSensorType();
+  uint8_t header[HEADER_SIZE];
+  encodeHeader(header, sensorType.c_str(), startMillis, startEpoch);
+  
+  File file = LittleFS.open(TRACE_FILE_PATH, FILE_WRITE);
+  if (!file) {
+    Serial.println("Failed to create sensor trace file");
+    return;
+  }
+  file.write(header, sizeof(header));
+  file.close();
+  
+  fileSize = HEADER_SIZE;
+  buffered = 0;
+  lastFlush = millis();
+  for (int i = 0; i < CHANNEL_COUNT; i++) {
+    hasLastValue[i] = false;
+  }
+  recording = true;
+  
+  Serial.printf("Sensor trace recording started at %lu ms\n", (unsigned long)startMillis);
+}
+
+void TraceRecorder::stop() {
+  if (!recording) return;
+  
+  flush();
+  recording = false;
+  Serial.printf("Sensor trace stopped: %u bytes\n", (unsigned)fileSize);
+}
+
+void TraceRecorder::flush() {
+  lastFlush = millis();
+  if (buffered == 0) return;
+  
+  // Abrir y cerrar en cada volcado: un corte de energía solo pierde el buffer
+  File file = LittleFS.open(TRACE_FILE_PATH, FILE_APPEND);
+  if (!file) {
+    Serial.println("Failed to append to sensor trace");
+    return;
+  }
+  fileSize += file.write(buffer, buffered);
+  file.close();
+  buffered = 0;
+}
+
+void TraceRecorder::resolveStartEpoch() {
+  if (startEpoch != 0) return;
+  
+  uint32_t epoch = WiFiManager::getEpochTime();
+  if (epoch < MIN_VALID_EPOCH) return;
+  
+  // Grabación iniciada antes de NTP: completar la cabecera en cuanto hay hora
+  startEpoch = epoch - (millis() - startMillis) / 1000;
+  
+  if (fileSize >= HEADER_SIZE) {
+    String sensorType = Storage::getSensorType();
+    uint8_t header[HEADER_SIZE];
+    encodeHeader(header, sensorType.c_str(), startMillis, startEpoch);
+    File file = LittleFS.open(TRACE_FILE_PATH, "r+");
+    if (file) {
+      file.write(header, sizeof(header));
+      file.close();
+    }
+  }
+}
+
+void TraceRecorder::handleCommand(const char* command, Sink sink) {
+  char reply[96];
+  
+  if (strcmp(command, "start") == 0) {
+    start();
+  } else if (strcmp(command, "stop") == 0) {
+    stop();
+  } else if (strcmp(command, "boot") == 0) {
+    Storage::setTraceOnBoot(true);
+    emit(sink, "TRACE ARMED for next boot");
+    return;
+  } else if (strcmp(command, "clear") == 0) {
+    stop();
+    if (mounted) LittleFS.remove(TRACE_FILE_PATH);
+    fileSize = 0;
+  } else if (strcmp(command, "dump") == 0) {
+    beginUpload(sink);
+    return;
+  } else if (strcmp(command, "status") != 0) {
+    snprintf(reply, sizeof(reply), "TRACE ERROR unknown command '%s'", command);
+    emit(sink, reply);
+    return;
+  }
+  
+  size_t size = fileSize + buffered;
+  if (!recording && mounted && LittleFS.exists(TRACE_FILE_PATH)) {
+    File file = LittleFS.open(TRACE_FILE_PATH, FILE_READ);
+    size = file.size();
+    file.close();
+  }
+  snprintf(reply, sizeof(reply), "TRACE STATUS recording=%d bytes=%u records=%u",
+           recording ? 1 : 0, (unsigned)size,
+           (unsigned)(size > HEADER_SIZE ? (size - HEADER_SIZE) / RECORD_SIZE : 0));
+  emit(sink, reply);
+}
+
+void TraceRecorder::beginUpload(Sink sink) {
+  if (uploading) {
+    uploadFile.close();
+  }
+  
+  // Lo grabado hasta ahora; si la grabación sigue, lo nuevo queda para otra descarga
+  if (recording) flush();
+  
+  uploadFile = mounted ? LittleFS.open(TRACE_FILE_PATH, FILE_READ) : File();
+  if (!uploadFile) {
+    emit(sink, "TRACE ERROR no trace recorded");
+    return;
+  }
+  
+  uploading = true;
+  uploadSink = sink;
+  uploadSize = uploadFile.size();
+  uploadOffset = 0;
+  uploadCrc = 0;
+  
+  char line[40];
+  snprintf(line, sizeof(line), "TRACE BEGIN %u", (unsigned)uploadSize);
+  if (!emit(sink, line)) {
+    uploadFile.close();
+    uploading = false;
+  }
+}
+
+void TraceRecorder::continueUpload() {
+  // Unas pocas líneas por vuelta: el loop sigue leyendo y publicando mientras tanto
+  for (int i = 0; i < TRACE_UPLOAD_LINES_PER_LOOP && uploadOffset < uploadSize; i++) {
+    uint8_t data[TRACE_UPLOAD_BYTES_PER_LINE];
+    size_t count = uploadSize - uploadOffset;
+    if (count > sizeof(data)) count = sizeof(data);
+  
+    uploadFile.seek(uploadOffset);
+    count = uploadFile.read(data, count);
+    if (count == 0) break;
+  
+    char line[16 + 2 * TRACE_UPLOAD_BYTES_PER_LINE];
+    int pos = snprintf(line, sizeof(line), "TRACE %08x ", (unsigned)uploadOffset);
+    for (size_t j = 0; j < count; j++) {
+      pos += snprintf(line + pos, sizeof(line) - pos, "%02x", data[j]);
+    }
+  
+    // MQTT caído: se reintenta la misma línea en la siguiente vuelta
+    if (!emit(uploadSink, line)) return;
+  
+    uploadCrc = crc32(uploadCrc, data, count);
+    uploadOffset += count;
+  }
+  
+  if (uploadOffset >= uploadSize) {
+    char line[48];
+    snprintf(line, sizeof(line), "TRACE END %u %08x", (unsigned)uploadSize, (unsigned)uploadCrc);
+    if (!emit(uploadSink, line)) return;
+    uploadFile.close();
+    uploading = false;
+  }
+}
+
+bool TraceRecorder::emit(Sink sink, const char* line) {
+  if (sink == SINK_MQTT) {
+    return MQTTClient::publishTrace(line);
+  }
+  Serial.println(line);
+  return true;
+}
+
+// === Formato binario ===
+
+static void writeUint32(uint8_t* out, uint32_t value) {
+  out[0] = value & 0xFF;
+  out[1] = (value >> 8) & 0xFF;
+  out[2] = (value >> 16) & 0xFF;
+  out[3] = (value >> 24) & 0xFF;
+}
+
+static uint32_t readUint32(const uint8_t* in) {
+  return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+void TraceRecorder::encodeHeader(uint8_t* out, const char* sensorType, uint32_t startMillis, uint32_t startEpoch) {
+  memcpy(out, "STRC", 4);
+  out[4] = FORMAT_VERSION;
+  memset(out + 5, 0, SENSOR_TYPE_SIZE);
+  strncpy((char*)out + 5, sensorType, SENSOR_TYPE_SIZE);
+  writeUint32(out + 12, startMillis);
+  writeUint32(out + 16, startEpoch);
+}
+
+bool TraceRecorder::decodeHeader(const uint8_t* in, char* sensorType, uint32_t& startMillis, uint32_t& startEpoch) {
+  if (memcmp(in, "STRC", 4) != 0 || in[4] != FORMAT_VERSION) {
+    return false;
+  }
+  memcpy(sensorType, in + 5, SENSOR_TYPE_SIZE);
+  sensorType[SENSOR_TYPE_SIZE] = '\0';
+  startMillis = readUint32(in + 12);
+  startEpoch = readUint32(in + 16);
+  return true;
+}
+
+void TraceRecorder::encodeRecord(uint8_t* out, uint32_t offset, uint8_t channel, float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  writeUint32(out, offset);
+  out[4] = channel;
+  writeUint32(out + 5, bits);
+}
+
+void TraceRecorder::decodeRecord(const uint8_t* in, uint32_t& offset, uint8_t& channel, float& value) {
+  uint32_t bits = readUint32(in + 5);
+  offset = readUint32(in);
+  channel = in[4];
+  memcpy(&value, &bits, sizeof(value));
+}
+
+uint32_t TraceRecorder::crc32(uint32_t crc, const uint8_t* data, size_t length) {
+  // CRC-32 (IEEE) bit a bit: sin tabla, la descarga no es un camino caliente
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
@@ -0,0 +1,89 @@
+// traceRecorder.h
+// ========================================
+
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+// Grabación de las lecturas crudas de hardware del sensor a un archivo en flash,
+// para reproducirlas en native/replay con el mismo código de Sensor.
+//
+// Archivo (little-endian):
+//   cabecera  "STRC" | versión u8 | sensorType char[7] | startMillis u32 | startEpoch u32
+//   registro  offset ms u32 | canal u8 | valor float
+// Solo se graban los cambios de valor: el pin mantiene su nivel entre registros,
+// así que la reproducción es exacta para PIR y DHT22. El MQ4 crudo tiene banda
+// muerta (TRACE_DEADBAND_MQ4_RAW): al reproducir, cada lectura vale el último
+// valor grabado y difiere de la real en menos de la banda.
+//
+// Comandos por serial ("trace ...") o por MQTT en devices/{id}/trace/cmd; por MQTT
+// solo en brokers con ACL por usuario (MQTTClient::acceptsTraceCommands).
+// Descarga por serial o MQTT en líneas de texto (mismo formato en ambos):
+//   TRACE BEGIN <bytes>
+//   TRACE <offset hex> <datos hex>
+//   TRACE END <bytes> <crc32 hex>
+class TraceRecorder {
+public:
+  enum Channel : uint8_t {
+    CHANNEL_MQ4_RAW = 0,
+    CHANNEL_PIR_PIN = 1,
+    CHANNEL_DHT_TEMPERATURE = 2,
+    CHANNEL_DHT_HUMIDITY = 3,
+    CHANNEL_COUNT = 4
+  };
+  
+  enum Sink {
+    SINK_SERIAL,
+    SINK_MQTT
+  };
+  
+  static const uint8_t FORMAT_VERSION = 1;
+  static const size_t SENSOR_TYPE_SIZE = 7;
+  static const size_t HEADER_SIZE = 20;
+  static const size_t RECORD_SIZE = 9;
+  
+  static void init();  // Monta LittleFS y arranca si se armó "trace boot"
+  static void loop();  // Vuelca el buffer a flash y avanza la descarga en curso
+  static void record(Channel channel, float value);
+  static void handleCommand(const char* command, Sink sink);
+  static bool isRecording();
+  
+  // Formato binario (compartido con native/replay)
+  static void encodeHeader(uint8_t* out, const char* sensorType, uint32_t startMillis, uint32_t startEpoch);
+  static bool decodeHeader(const uint8_t* in, char* sensorType, uint32_t& startMillis, uint32_t& startEpoch);
+  static void encodeRecord(uint8_t* out, uint32_t offset, uint8_t channel, float value);
+  static void decodeRecord(const uint8_t* in, uint32_t& offset, uint8_t& channel, float& value);
+  static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t length);
+  
+private:
+  static bool mounted;
+  static bool recording;
+  static uint32_t startMillis;
+  static uint32_t startEpoch;
+  static float lastValues[CHANNEL_COUNT];
+  static bool hasLastValue[CHANNEL_COUNT];
+  static uint8_t buffer[512];
+  static size_t buffered;
+  static size_t fileSize;
+  static unsigned long lastFlush;
+  
+  static bool uploading;
+  static Sink uploadSink;
+  static File uploadFile;
+  static size_t uploadSize;
+  static size_t uploadOffset;
+  static uint32_t uploadCrc;
+  
+  static float getDeadband(Channel channel);
+  static void start();
+  static void stop();
+  static void flush();
+  static void resolveStartEpoch();
+  static void beginUpload(Sink sink);
+  static void continueUpload();
+  static bool emit(Sink sink, const char* line);
+};
+
+#endif
@@ -10,6 +10,11 @@
 WebServer WiFiManager::server(80);
 WiFiUDP WiFiManager::ntpUDP;
 NTPClient WiFiManager::timeClient(ntpUDP, NTP_SERVER, UTC_OFFSET_SECONDS, 60000);
+uint64_t WiFiManager::epochOffsetMillis = 0;
+unsigned long WiFiManager::lastReconnectAttempt = 0;
+unsigned long WiFiManager::lastRoamCheck = 0;
+unsigned long WiFiManager::lastRoamScan = 0;
+bool WiFiManager::roamScanRunning = false;
 
 void WiFiManager::startSetupMode() {
   // Crear Access Point
@@ -93,7 +98,7 @@ void WiFiManager::handleRoot() {
 </body>
 </html>
 )";
-  
+
   server.send(200, "text/html", html);
 }
 
@@ -202,13 +207,86 @@ bool WiFiManager::activateDevice(const String& token, String& deviceId) {
 }
 
 bool WiFiManager::connectToWiFi() {
-  String ssid, password, deviceId;
-  if (!Storage::loadConfig(ssid, password, deviceId)) {
+  // Con varios AP del mismo SSID el ESP32 se asocia al primero que oye, no al más
+  // fuerte: se escanea y se prueba cada AP conocido fijando BSSID y canal
+  Serial.println("Scanning WiFi networks...");
+  Candidate candidates[WIFI_MAX_CANDIDATES];
+  int found = WiFi.scanNetworks();
+  int count = rankCandidates(found, candidates, WIFI_MAX_CANDIDATES);
+  WiFi.scanDelete();
+  
+  for (int i = 0; i < count; i++) {
+    if (connectToProfile(candidates[i].slot, &candidates[i])) {
+      return true;
+    }
+    WiFi.disconnect();
+  }
+  
+  // Nada conocido a la vista (SSID oculto o escaneo fallido): cada red a ciegas
+  if (count == 0) {
+    String ssid, password;
+    for (uint8_t slot = 0; slot < WIFI_MAX_PROFILES; slot++) {
+      if (!Storage::loadWiFiProfile(slot, ssid, password)) continue;
+      if (connectToProfile(slot, nullptr)) {
+        return true;
+      }
+      WiFi.disconnect();
+    }
+  }
+  
+  Serial.println("WiFi connection failed (no stored network reachable)");
+  return false;
+}
+
+int WiFiManager::rankCandidates(int found, Candidate* candidates, int maxCandidates) {
+  String ssids[WIFI_MAX_PROFILES];
+  String password;
+  bool hasProfile[WIFI_MAX_PROFILES];
+  for (uint8_t slot = 0; slot < WIFI_MAX_PROFILES; slot++) {
+    hasProfile[slot] = Storage::loadWiFiProfile(slot, ssids[slot], password);
+  }
+  
+  // Inserción ordenada por RSSI descendente; si no cabe, se descarta el más débil
+  int count = 0;
+  for (int i = 0; i < found; i++) {
+    String ssid = WiFi.SSID(i);
+    for (uint8_t slot = 0; slot < WIFI_MAX_PROFILES; slot++) {
+      if (!hasProfile[slot] || ssids[slot] != ssid) continue;
+      
+      int32_t rssi = WiFi.RSSI(i);
+      int pos = count < maxCandidates ? count : maxCandidates - 1;
+      if (count == maxCandidates && candidates[pos].rssi >= rssi) break;
+      while (pos > 0 && candidates[pos - 1].rssi < rssi) {
+        candidates[pos] = candidates[pos - 1];
+        pos--;
+      }
+      candidates[pos].slot = slot;
+      candidates[pos].rssi = rssi;
+      candidates[pos].channel = WiFi.channel(i);
+      memcpy(candidates[pos].bssid, WiFi.BSSID(i), 6);
+      if (count < maxCandidates) count++;
+      break;
+    }
+  }
+  return count;
+}
+
+bool WiFiManager::connectToProfile(uint8_t slot, const Candidate* candidate) {
+  String ssid, password;
+  if (!Storage::loadWiFiProfile(slot, ssid, password)) {
     return false;
   }
   
-  Serial.println("Connecting to WiFi: " + ssid);
-  WiFi.begin(ssid.c_str(), password.c_str());
+  if (candidate) {
+    const uint8_t* b = candidate->bssid;
+    Serial.printf("Connecting to WiFi: %s (%02X:%02X:%02X:%02X:%02X:%02X, channel %d, %d dBm)\n",
+                  ssid.c_str(), b[0], b[1], b[2], b[3], b[4], b[5], (int)candidate->channel,
+                  (int)candidate->rssi);
+    WiFi.begin(ssid.c_str(), password.c_str(), candidate->channel, candidate->bssid);
+  } else {
+    Serial.println("Connecting to WiFi: " + ssid);
+    WiFi.begin(ssid.c_str(), password.c_str());
+  }
   
   unsigned long startTime = millis();
   while (WiFi.status() != WL_CONNECTED && (millis() - startTime < WIFI_TIMEOUT)) {
@@ -221,27 +299,120 @@ bool WiFiManager::connectToWiFi() {
     Serial.println("IP address: " + WiFi.localIP().toString());
     return true;
   } else {
-    Serial.println("\nWiFi connection failed");
+    Serial.println("\nWiFi connection failed: " + ssid);
     return false;
   }
 }
 
+void WiFiManager::maintain() {
+  unsigned long now = millis();
+  
+  if (WiFi.status() != WL_CONNECTED) {
+    // Cada intento puede bloquear WIFI_TIMEOUT por AP: espaciarlos deja al loop
+    // leer el sensor y guardar en el backlog mientras no hay red
+    roamScanRunning = false;
+    if (lastReconnectAttempt != 0 && now - lastReconnectAttempt < WIFI_RETRY_INTERVAL) return;
+    Serial.println("WiFi disconnected. Attempting reconnection...");
+    connectToWiFi();
+    lastReconnectAttempt = millis();  // Contar desde el final: el intento ya bloqueó
+    return;
+  }
+  
+  if (roamScanRunning) {
+    finishRoamScan();
+    return;
+  }
+  
+  if (now - lastRoamCheck < WIFI_ROAM_CHECK_INTERVAL) return;
+  lastRoamCheck = now;
+  
+  int8_t rssi = WiFi.RSSI();
+  if (rssi >= WIFI_ROAM_RSSI_THRESHOLD) return;
+  if (lastRoamScan != 0 && now - lastRoamScan < WIFI_ROAM_SCAN_INTERVAL) return;
+  lastRoamScan = now;
+  
+  // Escaneo asíncrono: el loop sigue publicando mientras la radio barre canales
+  Serial.printf("WiFi signal weak (%d dBm), scanning for a better AP...\n", rssi);
+  if (WiFi.scanNetworks(true) != WIFI_SCAN_FAILED) {
+    roamScanRunning = true;
+  }
+}
+
+void WiFiManager::finishRoamScan() {
+  int found = WiFi.scanComplete();
+  if (found == WIFI_SCAN_RUNNING) return;
+  roamScanRunning = false;
+  
+  Candidate candidates[WIFI_MAX_CANDIDATES];
+  int count = rankCandidates(found, candidates, WIFI_MAX_CANDIDATES);
+  WiFi.scanDelete();
+  if (count == 0) return;
+  
+  // Histéresis: sin ella dos AP con RSSI parecido provocan cambios continuos
+  const Candidate& best = candidates[0];
+  int8_t current = WiFi.RSSI();
+  if (memcmp(best.bssid, WiFi.BSSID(), 6) == 0 || best.rssi < current + WIFI_ROAM_HYSTERESIS) {
+    Serial.printf("No better AP found (current %d dBm, best %d dBm)\n", current, (int)best.rssi);
+    return;
+  }
+  
+  Serial.printf("Roaming: %d dBm -> %d dBm\n", current, (int)best.rssi);
+  WiFi.disconnect();
+  if (!connectToProfile(best.slot, &best)) {
+    // El AP elegido no aceptó: volver al mejor que responda
+    WiFi.disconnect();
+    connectToWiFi();
+  }
+}
+
 void WiFiManager::initNTP() {
   timeClient.begin();
   timeClient.update();
   Serial.println("NTP initialized");
 }
 
-String WiFiManager::getCurrentTimestamp() {
+void WiFiManager::getCurrentTimestamp(char* buffer, size_t size) {
   timeClient.update();
   unsigned long epochTime = timeClient.getEpochTime();
   
-  // Convertir a formato ISO 8601
+  // Convertir a formato ISO 8601 (gmtime_r: sin buffer estático compartido)
   time_t rawTime = epochTime;
-  struct tm* timeInfo = gmtime(&rawTime);
+  struct tm timeInfo;
+  gmtime_r(&rawTime, &timeInfo);
   
-  char buffer[30];
-  strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", timeInfo);
+  strftime(buffer, size, "%Y-%m-%dT%H:%M:%SZ", &timeInfo);
+}
+
+bool WiFiManager::isTimeSet() {
+  // Falso si se arrancó sin red y NTP aún no respondió (la hora epoch sería ~1970)
+  return timeClient.isTimeSet();
+}
+
+unsigned long WiFiManager::getEpochTime() {
+  // Sin update(): valor en caché, barato para llamar desde el loop
+  return timeClient.getEpochTime();
+}
+
+uint64_t WiFiManager::getEpochMillis() {
+  // NTPClient solo da segundos: se ancla la hora epoch a millis() y se avanza con
+  // millis(), así las diferencias entre marcas (muestra -> publicación) son exactas
+  uint64_t now = millis();
+  uint64_t ntpMillis = (uint64_t)timeClient.getEpochTime() * 1000;
+  uint64_t estimate = epochOffsetMillis + now;
+  
+  // Reanclar si se separa del segundo NTP (primera sincronización, corrección o desborde de millis)
+  if (estimate + 1000 < ntpMillis || estimate > ntpMillis + 2000) {
+    epochOffsetMillis = ntpMillis - now;
+    estimate = ntpMillis;
+  }
+  return estimate;
+}
+
+void WiFiManager::formatTimestampMillis(char* buffer, size_t size, uint64_t epochMillis) {
+  time_t rawTime = epochMillis / 1000;
+  struct tm timeInfo;
+  gmtime_r(&rawTime, &timeInfo);
   
-  return String(buffer);
+  size_t length = strftime(buffer, size, "%Y-%m-%dT%H:%M:%S", &timeInfo);
+  snprintf(buffer + length, size - length, ".%03uZ", (unsigned)(epochMillis % 1000));
 }
\ No newline at end of file
@@ -14,18 +14,44 @@ private:
   static WebServer server;
   static WiFiUDP ntpUDP;
   static NTPClient timeClient;
+  static uint64_t epochOffsetMillis;
+  
+  // AP visible de una red guardada (resultado de escaneo)
+  struct Candidate {
+    uint8_t slot;
+    int32_t rssi;
+    int32_t channel;
+    uint8_t bssid[6];
+  };
+  
+  static unsigned long lastReconnectAttempt;
+  static unsigned long lastRoamCheck;
+  static unsigned long lastRoamScan;
+  static bool roamScanRunning;
   
   static void handleRoot();
   static void handleSubmit();
   static void handleNotFound();
   static bool activateDevice(const String& token, String& deviceId);
+  static int rankCandidates(int found, Candidate* candidates, int maxCandidates);
+  static bool connectToProfile(uint8_t slot, const Candidate* candidate);
+  static void finishRoamScan();
   
 public:
   static void startSetupMode();
   static void handleClient();
+  // Escanea y se asocia al AP conocido con mejor RSSI (todas las redes guardadas)
   static bool connectToWiFi();
+  // Desde el loop: reintento espaciado si no hay conexión y roaming si la señal cae
+  static void maintain();
   static void initNTP();
-  static String getCurrentTimestamp();
+  static bool isTimeSet();
+  static const size_t TIMESTAMP_SIZE = 21;  // "YYYY-MM-DDTHH:MM:SSZ" + '\0'
+  static const size_t TIMESTAMP_MS_SIZE = 25;  // "YYYY-MM-DDTHH:MM:SS.mmmZ" + '\0'
+  static void getCurrentTimestamp(char* buffer, size_t size);
+  static unsigned long getEpochTime();
+  static uint64_t getEpochMillis();
+  static void formatTimestampMillis(char* buffer, size_t size, uint64_t epochMillis);
 };
 
 #endif
\ No newline at end of file
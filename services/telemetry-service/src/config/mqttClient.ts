@@ -1,10 +1,26 @@
 // src/config/mqttClient.ts
 import mqtt from 'mqtt';
 import { telemetryService } from '../services/telemetryService';
-import { TelemetryInput } from '../types/telemetry';
+import { alertService } from '../services/alertsService';
+import { TelemetryInput, DeviceAlertMessage } from '../types/telemetry';
+import { decodeTimeSeriesBlock } from '../utils/timeSeriesBlock';
+import { ingestSubscriptions, parseDeviceTopic, parseShardList, shardForDevice } from '../utils/deviceTopic';
 import { telemetryNotificationService } from '../services/telemetryNotificationServiceInstance';
 
-let mqttClient: mqtt.MqttClient | null = null;
+let mqttClients: mqtt.MqttClient[] = [];
+let ingestTopics: string[] = [];
+let shardCount = 0;
+
+// Acuse de ingesta para herramientas de carga (firmware_esp32/native/fleet_sim)
+const INGEST_ACK_ENABLED = process.env.MQTT_INGEST_ACK === 'true';
+
+interface MqttBrokerConfig {
+  name: string;
+  host: string;
+  port: number;
+  username?: string;
+  password?: string;
+}
 
 export const initMqtt = (): void => {
   const host = process.env.MQTT_HOST!;
@@ -16,6 +32,40 @@ export const initMqtt = (): void => {
     throw new Error('MQTT_HOST, MQTT_PORT, MQTT_USERNAME, and MQTT_PASSWORD are required');
   }
 
+  // Reparto de la ingesta entre instancias: cada una consume un conjunto disjunto
+  // de shards (MQTT_SHARDS, p. ej. "0-3") de los MQTT_SHARD_COUNT del firmware
+  shardCount = parseInt(process.env.MQTT_SHARD_COUNT || '0');
+  const shards = shardCount > 0
+    ? parseShardList(process.env.MQTT_SHARDS || `0-${shardCount - 1}`, shardCount)
+    : [];
+  // Dispositivos sin shard (MQTT_SHARD_COUNT del firmware = 0): por defecto solo
+  // los escucha una instancia que consume todos los shards
+  const unsharded = process.env.MQTT_UNSHARDED_TOPICS
+    ? process.env.MQTT_UNSHARDED_TOPICS === 'true'
+    : !process.env.MQTT_SHARDS;
+  ingestTopics = ingestSubscriptions(shards, unsharded);
+  if (ingestTopics.length === 0) {
+    throw new Error('No MQTT ingest topics: set MQTT_SHARDS or MQTT_UNSHARDED_TOPICS=true');
+  }
+
+  const brokers: MqttBrokerConfig[] = [{ name: 'cloud', host, port, username, password }];
+
+  // Broker de la LAN (mosquitto): el firmware lo prefiere cuando responde más rápido
+  // y vuelve a la nube si cae, así que hay que escuchar en ambos
+  if (process.env.MQTT_LAN_HOST) {
+    brokers.push({
+      name: 'lan',
+      host: process.env.MQTT_LAN_HOST,
+      port: parseInt(process.env.MQTT_LAN_PORT || '1883'),
+      username: process.env.MQTT_LAN_USERNAME || undefined,
+      password: process.env.MQTT_LAN_PASSWORD || undefined
+    });
+  }
+
+  mqttClients = brokers.map(connectBroker);
+};
+
+const connectBroker = ({ name, host, port, username, password }: MqttBrokerConfig): mqtt.MqttClient => {
   const client = mqtt.connect({
     host,
     port,
@@ -26,33 +76,53 @@ export const initMqtt = (): void => {
     connectTimeout: 10000
   });
 
-  // Guardar referencia del cliente
-  mqttClient = client;
-
   client.on('connect', () => {
-    console.log(`MQTT connected to ${host}:${port}`);
+    console.log(`MQTT connected to ${host}:${port} (${name})`);
     
-    client.subscribe('devices/+/sensors', (err) => {
+    client.subscribe(ingestTopics, (err) => {
       if (err) {
-        console.error('MQTT subscribe error:', err);
+        console.error(`MQTT subscribe error (${name}):`, err);
       } else {
-        console.log('Successfully subscribed to devices/+/sensors');
+        console.log(`Successfully subscribed to ${ingestTopics.join(', ')} (${name})`);
       }
     });
   });
 
   client.on('message', async (topic, payload) => {
+    const receivedAt = Date.now();
     try {
-      // Extraer deviceId del topic: devices/{deviceId}/sensors
-      const topicParts = topic.split('/');
-      if (topicParts.length !== 3 || topicParts[0] !== 'devices' || topicParts[2] !== 'sensors') {
+      // Extraer deviceId del topic: [shard/{n}/]devices/{deviceId}/sensors | alerts | backlog
+      const parsed = parseDeviceTopic(topic);
+      if (!parsed) {
         console.warn(`Invalid topic format: ${topic}`);
         return;
       }
 
-      const deviceId = topicParts[1];
-      if (!deviceId) {
-        console.warn(`Missing deviceId in topic: ${topic}`);
+      const { deviceId, kind } = parsed;
+      if (parsed.shard !== null && parsed.shard !== shardForDevice(deviceId, shardCount)) {
+        // Se procesa igual: el aviso delata un MQTT_SHARD_COUNT distinto en el dispositivo
+        console.warn(`Device ${deviceId} published on shard ${parsed.shard}, expected ${shardForDevice(deviceId, shardCount)} of ${shardCount}`);
+      }
+
+      // Backlog offline: bloque binario comprimido, no JSON
+      if (kind === 'backlog') {
+        const block = decodeTimeSeriesBlock(payload);
+        const count = await telemetryService.processBacklog(deviceId, block);
+        console.log(`📦 Backlog of ${count} readings ingested for ${deviceId} (${payload.length} bytes)`);
+        return;
+      }
+
+      // Alertas del dispositivo: camino prioritario, sin persistir en Mongo ni RabbitMQ
+      if (kind === 'alerts') {
+        const alert: DeviceAlertMessage = JSON.parse(payload.toString());
+        if (!alert.sensorType || !alert.metric || typeof alert.value !== 'number') {
+          console.warn(`Invalid alert message from device ${deviceId}`);
+          return;
+        }
+
+        telemetryNotificationService.notifyDevice(deviceId, 'device_alert', { ...alert, deviceId });
+        await alertService.processDeviceAlert(deviceId, alert);
+        console.log(`🚨 Device alert ${alert.state} for ${deviceId} (${alert.sensorType}/${alert.metric}: ${alert.value})`);
         return;
       }
 
@@ -66,7 +136,7 @@ export const initMqtt = (): void => {
       }
 
       // Procesar telemetría en base de datos
-      await telemetryService.processTelemetry(deviceId, message);
+      await telemetryService.processTelemetry(deviceId, message, new Date(receivedAt));
       
       // 🚀 NUEVA FUNCIONALIDAD: Emitir notificación en tiempo real
       // Normalizar mensaje a formato batch para la notificación
@@ -93,6 +163,14 @@ export const initMqtt = (): void => {
 
       telemetryNotificationService.notifyDevice(deviceId, 'new_telemetry', notificationData);
 
+      if (INGEST_ACK_ENABLED) {
+        client.publish(`devices/${deviceId}/ingested`, JSON.stringify({
+          timestamp: notificationData.readings[0]?.timestamp,
+          receivedAt: new Date(receivedAt).toISOString(),
+          processingMs: Date.now() - receivedAt
+        }));
+      }
+
       console.log(`✅ Telemetry processed and notified for device ${deviceId} (${message.sensorType})`);
       
     } catch (error) {
@@ -105,30 +183,30 @@ export const initMqtt = (): void => {
   });
 
   client.on('error', (error) => {
-    console.error('MQTT connection error:', error);
+    console.error(`MQTT connection error (${name}):`, error);
   });
 
   client.on('reconnect', () => {
-    console.log('MQTT reconnecting...');
+    console.log(`MQTT reconnecting (${name})...`);
   });
 
   client.on('close', () => {
-    console.log('MQTT connection closed');
+    console.log(`MQTT connection closed (${name})`);
   });
+
+  return client;
 };
 
-// Función para cerrar el cliente MQTT
+// Función para cerrar los clientes MQTT
 export const closeMqtt = async (): Promise<void> => {
-  return new Promise((resolve) => {
-    if (mqttClient) {
-      console.log('Closing MQTT connection...');
-      mqttClient.end(false, {}, () => {
-        mqttClient = null;
-        console.log('MQTT connection closed successfully');
-        resolve();
-      });
-    } else {
-      resolve();
-    }
-  });
-};
\ No newline at end of file
+  if (mqttClients.length === 0) {
+    return;
+  }
+
+  console.log('Closing MQTT connections...');
+  await Promise.all(mqttClients.map((client) => new Promise<void>((resolve) => {
+    client.end(false, {}, () => resolve());
+  })));
+  mqttClients = [];
+  console.log('MQTT connections closed successfully');
+};
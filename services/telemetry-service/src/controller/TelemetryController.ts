@@ -128,6 +128,34 @@ export class TelemetryController {
     }
   }
 
+  /**
+   * GET /telemetry/delivery/:id
+   * Pérdida de mensajes y percentiles de latencia por salto
+   */
+  async getDelivery(req: Request, res: Response, next: NextFunction): Promise<void> {
+    try {
+      const { id } = req.params;
+      const from = req.query.from as string;
+      const to = req.query.to as string;
+
+      const options = {
+        from: from ? new Date(from) : undefined,
+        to: to ? new Date(to) : undefined
+      };
+
+      const stats = await telemetryService.getDeliveryStats(id, options);
+
+      if (!stats) {
+        res.status(404).json({ success: false, error: 'No sequenced telemetry found' });
+        return;
+      }
+
+      res.json({ success: true, data: stats });
+    } catch (err) {
+      next(err);
+    }
+  }
+
   /**
    * GET /telemetry/metrics/:id
    * Obtener lista de métricas disponibles para un dispositivo
@@ -7,10 +7,22 @@ export interface ITelemetryReading {
   timestamp: Date;
 }
 
+// Trazabilidad de entrega (solo mensajes en vivo con seq del firmware)
+export interface ITelemetryDelivery {
+  seq: number;
+  bootId: string;
+  sampledAt?: Date;
+  publishedAt?: Date;
+  receivedAt: Date;
+  gap: number;         // Mensajes que faltan justo antes de este
+  duplicate: boolean;  // seq ya visto o atrasado en este arranque
+}
+
 export interface ITelemetry extends Document {
   deviceId: mongoose.Types.ObjectId;
   sensorType: string;
   readings: ITelemetryReading[];
+  delivery?: ITelemetryDelivery;
   timestamp: Date; // Timestamp general del mensaje
 }
 
@@ -20,11 +32,22 @@ const TelemetryReadingSchema = new Schema<ITelemetryReading>({
   timestamp: { type: Date, required: true }
 }, { _id: false });
 
+const TelemetryDeliverySchema = new Schema<ITelemetryDelivery>({
+  seq: { type: Number, required: true },
+  bootId: { type: String, required: true },
+  sampledAt: { type: Date },
+  publishedAt: { type: Date },
+  receivedAt: { type: Date, required: true },
+  gap: { type: Number, default: 0 },
+  duplicate: { type: Boolean, default: false }
+}, { _id: false });
+
 const TelemetrySchema = new Schema<ITelemetry>(
   {
     deviceId: { type: Schema.Types.ObjectId, ref: 'Device', required: true },
     sensorType: { type: String, required: true },
     readings: [TelemetryReadingSchema],
+    delivery: { type: TelemetryDeliverySchema, required: false },
     timestamp: { type: Date, required: true, default: () => new Date() }
   },
   { timestamps: false }
@@ -49,6 +49,17 @@ router.get(
   }
 );
 
+// Pérdida y latencia de entrega
+router.get(
+  '/telemetry/delivery/:id',
+  authenticateToken,
+  validateQueryDates,
+  handleValidationErrors,
+  (req: Request, res: Response, next: NextFunction) => {
+    return ctrl.getDelivery(req, res, next);
+  }
+);
+
 // Métricas disponibles para un dispositivo
 router.get(
   '/telemetry/metrics/:id',
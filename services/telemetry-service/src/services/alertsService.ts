@@ -1,5 +1,6 @@
 // src/services/alertService.ts
 import axios from 'axios';
+import { DeviceAlertMessage } from '../types/telemetry';
 
 // 📏 UMBRALES DE ALERTA
 const SENSOR_THRESHOLDS = {
@@ -228,6 +229,27 @@ export class AlertService {
     }
   }
 
+  /**
+   * Procesa una alerta evaluada en el dispositivo (devices/{id}/alerts).
+   * Solo las activaciones generan notificación; el cooldown compartido evita
+   * duplicar la alerta cuando llegue la lectura periódica.
+   */
+  async processDeviceAlert(deviceId: string, alert: DeviceAlertMessage): Promise<void> {
+    if (alert.state !== 'raised') {
+      console.log(`✅ Device ${deviceId} cleared alert ${alert.sensorType}/${alert.metric} at ${alert.value}`);
+      return;
+    }
+
+    const timestamp = new Date(alert.timestamp);
+    await this.checkAndSendAlert(
+      deviceId,
+      alert.sensorType,
+      alert.metric,
+      alert.value,
+      isNaN(timestamp.getTime()) ? new Date() : timestamp
+    );
+  }
+
   /**
    * Método para testing - permite forzar una alerta
    */
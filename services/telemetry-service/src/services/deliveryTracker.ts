@@ -0,0 +1,39 @@
+// src/services/deliveryTracker.ts
+// Detección de huecos en la secuencia por arranque de cada dispositivo.
+// En memoria: con topics por shard (utils/deviceTopic.ts) un dispositivo
+// siempre llega a la misma instancia. Tras reiniciar el servicio el primer
+// mensaje de cada dispositivo solo fija la referencia.
+
+export interface DeliveryCheck {
+  gap: number;
+  duplicate: boolean;
+}
+
+interface DeviceSequence {
+  bootId: string;
+  nextSeq: number;
+}
+
+export class DeliveryTracker {
+  private devices = new Map<string, DeviceSequence>();
+
+  check(deviceId: string, bootId: string, seq: number): DeliveryCheck {
+    const state = this.devices.get(deviceId);
+
+    // Primer mensaje visto o dispositivo reiniciado: nueva secuencia
+    if (!state || state.bootId !== bootId) {
+      this.devices.set(deviceId, { bootId, nextSeq: seq + 1 });
+      return { gap: 0, duplicate: false };
+    }
+
+    if (seq < state.nextSeq) {
+      return { gap: 0, duplicate: true };
+    }
+
+    const gap = seq - state.nextSeq;
+    state.nextSeq = seq + 1;
+    return { gap, duplicate: false };
+  }
+}
+
+export const deliveryTracker = new DeliveryTracker();
@@ -1,22 +1,56 @@
 // src/services/telemetryService.ts
-import { Telemetry } from '../models/Telemetry';
+import { Telemetry, ITelemetryDelivery } from '../models/Telemetry';
 import { publishAlert } from '../utils/rabbitmq';
 import mongoose from 'mongoose';
 import { TelemetryInput, TelemetrySingle, TelemetryBatch, LatestReadingValue, DeviceUpdateEvent } from '../types/telemetry';
 import { alertService } from './alertsService'; 
+import { deliveryTracker } from './deliveryTracker';
+import { TimeSeriesBlock } from '../utils/timeSeriesBlock';
+
+// Percentiles de latencia por salto sobre los últimos N mensajes con seq
+const DELIVERY_STATS_LIMIT = 10000;
+
+interface LatencySummary {
+  count: number;
+  p50: number | null;
+  p95: number | null;
+  p99: number | null;
+  max: number | null;
+}
+
+const summarizeLatency = (values: number[]): LatencySummary => {
+  const sorted = values.filter((value) => Number.isFinite(value)).sort((a, b) => a - b);
+  const percentile = (p: number) =>
+    sorted.length ? sorted[Math.min(sorted.length - 1, Math.ceil(p * sorted.length) - 1)] : null;
+  return {
+    count: sorted.length,
+    p50: percentile(0.5),
+    p95: percentile(0.95),
+    p99: percentile(0.99),
+    max: sorted.length ? sorted[sorted.length - 1] : null
+  };
+};
+
+const parseOptionalDate = (value?: string): Date | undefined => {
+  if (!value) return undefined;
+  const date = new Date(value);
+  return isNaN(date.getTime()) ? undefined : date;
+};
 
 export class TelemetryService {
   
   /**
    * Función principal para procesar telemetría
    */
-  async processTelemetry(deviceId: string, data: TelemetryInput): Promise<void> {
+  async processTelemetry(deviceId: string, data: TelemetryInput, receivedAt: Date = new Date()): Promise<void> {
     try {
+      const delivery = this.checkDelivery(deviceId, data, receivedAt);
+
       // Detectar si es un batch o una lectura individual
       if ('readings' in data) {
-        await this.processBatchTelemetry(deviceId, data);
+        await this.processBatchTelemetry(deviceId, data, delivery);
       } else {
-        await this.processSingleTelemetry(deviceId, data);
+        await this.processSingleTelemetry(deviceId, data, delivery);
       }
     } catch (error) {
       console.error('Error processing telemetry:', error);
@@ -27,7 +61,11 @@ export class TelemetryService {
   /**
    * Procesar una sola lectura
    */
-  private async processSingleTelemetry(deviceId: string, data: TelemetrySingle): Promise<void> {
+  private async processSingleTelemetry(
+    deviceId: string,
+    data: TelemetrySingle,
+    delivery?: ITelemetryDelivery
+  ): Promise<void> {
     // Convertir a formato batch para reutilizar lógica
     const batchData: TelemetryBatch = {
       sensorType: data.sensorType,
@@ -38,13 +76,45 @@ export class TelemetryService {
       }]
     };
     
-    await this.processBatchTelemetry(deviceId, batchData);
+    await this.processBatchTelemetry(deviceId, batchData, delivery);
+  }
+
+  /**
+   * Registrar hora de recepción y detectar huecos en la secuencia del firmware
+   */
+  private checkDelivery(deviceId: string, data: TelemetryInput, receivedAt: Date): ITelemetryDelivery | undefined {
+    // Firmware anterior o lectura reenviada por un gateway ESP-NOW: sin secuencia
+    if (!Number.isInteger(data.seq) || typeof data.bootId !== 'string' || !data.bootId) {
+      return undefined;
+    }
+
+    const seq = data.seq as number;
+    const { gap, duplicate } = deliveryTracker.check(deviceId, data.bootId, seq);
+    if (gap > 0) {
+      console.warn(`⚠️ Gap of ${gap} message(s) from device ${deviceId} before seq ${seq} (boot ${data.bootId})`);
+    } else if (duplicate) {
+      console.warn(`⚠️ Duplicate or late seq ${seq} from device ${deviceId} (boot ${data.bootId})`);
+    }
+
+    return {
+      seq,
+      bootId: data.bootId,
+      sampledAt: parseOptionalDate(data.sampledAt),
+      publishedAt: parseOptionalDate(data.publishedAt),
+      receivedAt,
+      gap,
+      duplicate
+    };
   }
 
   /**
    * Procesar múltiples lecturas
    */
-  private async processBatchTelemetry(deviceId: string, data: TelemetryBatch): Promise<void> {
+  private async processBatchTelemetry(
+    deviceId: string,
+    data: TelemetryBatch,
+    delivery?: ITelemetryDelivery
+  ): Promise<void> {
     if (!Array.isArray(data.readings) || data.readings.length === 0) {
       throw new Error('No readings provided in batch');
     }
@@ -67,6 +137,7 @@ export class TelemetryService {
       deviceId: new mongoose.Types.ObjectId(deviceId),
       sensorType: data.sensorType,
       readings: validReadings,
+      delivery,
       timestamp: new Date()
     });
 
@@ -108,6 +179,35 @@ export class TelemetryService {
     console.log(`Processed ${validReadings.length} readings for device ${deviceId} (${data.sensorType})`);
   }
 
+  /**
+   * Procesar un bloque del backlog offline (lecturas antiguas ya decodificadas)
+   */
+  async processBacklog(deviceId: string, block: TimeSeriesBlock): Promise<number> {
+    if (block.samples.length === 0) {
+      return 0;
+    }
+
+    // Un documento por lectura, igual que en vivo, pero fechado con la hora de la muestra
+    // para que el histórico quede en orden
+    const docs = block.samples.map(sample => ({
+      deviceId: new mongoose.Types.ObjectId(deviceId),
+      sensorType: block.sensorType,
+      readings: block.metrics.map((metric, index) => ({
+        metric,
+        value: block.sensorType === 'pir' ? sample.values[index] !== 0 : sample.values[index],
+        timestamp: sample.timestamp
+      })),
+      timestamp: sample.timestamp
+    }));
+
+    await Telemetry.insertMany(docs, { ordered: false });
+
+    // Sin SENSOR_READING ni alertas IFTTT: son lecturas viejas que llegan después de las
+    // lecturas en vivo, y las alertas offline ya las evaluó y publicó el firmware
+    console.log(`Processed backlog of ${docs.length} readings for device ${deviceId} (${block.sensorType})`);
+    return docs.length;
+  }
+
   /**
    * Obtener histórico de telemetría por dispositivo
    */
@@ -286,6 +386,93 @@ export class TelemetryService {
     return await Telemetry.aggregate(pipeline as mongoose.PipelineStage[]);
   }
 
+  /**
+   * Pérdida y latencia por salto de los mensajes en vivo de un dispositivo:
+   * muestra -> publicación (dispositivo), publicación -> recepción (red y broker,
+   * incluye el desfase NTP) y recepción -> guardado (servicio)
+   */
+  async getDeliveryStats(
+    deviceId: string,
+    options: {
+      from?: Date;
+      to?: Date;
+    } = {}
+  ) {
+    const { from, to } = options;
+
+    const filter: any = {
+      deviceId: new mongoose.Types.ObjectId(deviceId),
+      'delivery.seq': { $exists: true }
+    };
+
+    if (from || to) {
+      filter.timestamp = {};
+      if (from) filter.timestamp.$gte = from;
+      if (to) filter.timestamp.$lte = to;
+    }
+
+    const docs = await Telemetry.find(filter, { delivery: 1, timestamp: 1 })
+      .sort({ timestamp: -1 })
+      .limit(DELIVERY_STATS_LIMIT)
+      .lean();
+
+    if (docs.length === 0) {
+      return null;
+    }
+
+    // Pérdida por arranque: seq esperados en el rango visto menos los distintos recibidos
+    const boots = new Map<string, { min: number; max: number; seen: Set<number> }>();
+    const sampleToPublish: number[] = [];
+    const publishToReceive: number[] = [];
+    const receiveToStore: number[] = [];
+    const endToEnd: number[] = [];
+    let duplicates = 0;
+
+    for (const doc of docs) {
+      const delivery = doc.delivery!;
+      const boot = boots.get(delivery.bootId) ?? { min: delivery.seq, max: delivery.seq, seen: new Set<number>() };
+      boot.min = Math.min(boot.min, delivery.seq);
+      boot.max = Math.max(boot.max, delivery.seq);
+      if (boot.seen.has(delivery.seq)) duplicates++;
+      boot.seen.add(delivery.seq);
+      boots.set(delivery.bootId, boot);
+
+      const sampled = delivery.sampledAt?.getTime();
+      const published = delivery.publishedAt?.getTime();
+      const received = delivery.receivedAt.getTime();
+      const stored = doc.timestamp.getTime();
+      if (sampled !== undefined && published !== undefined) sampleToPublish.push(published - sampled);
+      if (published !== undefined) publishToReceive.push(received - published);
+      receiveToStore.push(stored - received);
+      if (sampled !== undefined) endToEnd.push(stored - sampled);
+    }
+
+    let expected = 0;
+    let received = 0;
+    for (const boot of boots.values()) {
+      expected += boot.max - boot.min + 1;
+      received += boot.seen.size;
+    }
+    const missing = expected - received;
+
+    return {
+      messages: docs.length,
+      boots: boots.size,
+      expected,
+      missing,
+      duplicates,
+      lossRate: expected > 0 ? missing / expected : 0,
+      latencyMs: {
+        sampleToPublish: summarizeLatency(sampleToPublish),
+        publishToReceive: summarizeLatency(publishToReceive),
+        receiveToStore: summarizeLatency(receiveToStore),
+        endToEnd: summarizeLatency(endToEnd)
+      },
+      from: docs[docs.length - 1].timestamp,
+      to: docs[0].timestamp
+    };
+  }
+
   // 🧪 MÉTODO PARA TESTING DE ALERTAS
   async testAlert(deviceId: string, message?: string): Promise<void> {
     try {
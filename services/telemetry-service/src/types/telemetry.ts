@@ -5,12 +5,21 @@ export interface TelemetryReading {
   timestamp: string; // ISO string
 }
 
-export interface TelemetryBatch {
+// Campos de entrega que añade el firmware (MQTTClient::publishSensorData):
+// secuencia por arranque y marcas con ms para medir la latencia por salto
+export interface DeliveryTrace {
+  seq?: number;
+  bootId?: string;
+  sampledAt?: string;    // ISO con ms: adquisición en Sensor::readAndFormat()
+  publishedAt?: string;  // ISO con ms: entrega al socket MQTT
+}
+
+export interface TelemetryBatch extends DeliveryTrace {
   sensorType: string;
   readings: TelemetryReading[];
 }
 
-export interface TelemetrySingle {
+export interface TelemetrySingle extends DeliveryTrace {
   sensorType: string;
   metric: string;
   value: number | boolean;
@@ -19,6 +28,16 @@ export interface TelemetrySingle {
 
 export type TelemetryInput = TelemetrySingle | TelemetryBatch;
 
+// Alerta evaluada en el firmware (devices/{deviceId}/alerts)
+export interface DeviceAlertMessage {
+  sensorType: string;
+  metric: string;
+  value: number;
+  threshold: number;
+  state: 'raised' | 'cleared';
+  timestamp: string; // ISO string
+}
+
 export interface LatestReadingValue {
   [metric: string]: {
     value: number | boolean;
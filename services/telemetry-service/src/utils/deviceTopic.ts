@@ -0,0 +1,67 @@
+// src/utils/deviceTopic.ts
+// Topics de ingesta del firmware, con o sin prefijo de shard:
+//   devices/{deviceId}/{kind}
+//   shard/{n}/devices/{deviceId}/{kind}    n = FNV-1a(deviceId) % shardCount
+// El hash es el de MQTTClient::getShard() (firmware_esp32/src/mqttClient.cpp):
+// un dispositivo siempre cae en el mismo shard, así que un solo consumidor
+// recibe todas sus lecturas y se mantiene el orden por dispositivo.
+
+export const INGEST_KINDS = ['sensors', 'alerts', 'backlog'] as const;
+export type IngestKind = typeof INGEST_KINDS[number];
+
+export interface DeviceTopic {
+  deviceId: string;
+  kind: IngestKind;
+  shard: number | null;
+}
+
+export const shardForDevice = (deviceId: string, shardCount: number): number => {
+  if (shardCount <= 0) return 0;
+  let hash = 0x811c9dc5;
+  for (let i = 0; i < deviceId.length; i++) {
+    hash ^= deviceId.charCodeAt(i) & 0xff;
+    hash = Math.imul(hash, 0x01000193) >>> 0;
+  }
+  return hash % shardCount;
+};
+
+export const parseDeviceTopic = (topic: string): DeviceTopic | null => {
+  const parts = topic.split('/');
+  let shard: number | null = null;
+
+  if (parts[0] === 'shard') {
+    shard = Number(parts[1]);
+    if (!Number.isInteger(shard) || shard < 0) return null;
+    parts.splice(0, 2);
+  }
+
+  if (parts.length !== 3 || parts[0] !== 'devices' || !parts[1] ||
+      !(INGEST_KINDS as readonly string[]).includes(parts[2])) {
+    return null;
+  }
+  return { deviceId: parts[1], kind: parts[2] as IngestKind, shard };
+};
+
+// "0-3,8" -> [0, 1, 2, 3, 8]
+export const parseShardList = (spec: string, shardCount: number): number[] => {
+  const shards = new Set<number>();
+  for (const item of spec.split(',').map((part) => part.trim()).filter(Boolean)) {
+    const [from, to = from] = item.split('-').map((value) => Number(value.trim()));
+    if (!Number.isInteger(from) || !Number.isInteger(to) || from > to || from < 0 || to >= shardCount) {
+      throw new Error(`Invalid shard range '${item}' for ${shardCount} shards`);
+    }
+    for (let shard = from; shard <= to; shard++) shards.add(shard);
+  }
+  return [...shards].sort((a, b) => a - b);
+};
+
+export const ingestSubscriptions = (shards: number[], unsharded: boolean): string[] => {
+  const topics: string[] = [];
+  if (unsharded) {
+    topics.push(...INGEST_KINDS.map((kind) => `devices/+/${kind}`));
+  }
+  for (const shard of shards) {
+    topics.push(...INGEST_KINDS.map((kind) => `shard/${shard}/devices/+/${kind}`));
+  }
+  return topics;
+};
@@ -0,0 +1,122 @@
+// src/utils/timeSeriesBlock.ts
+// Decodificador de los bloques comprimidos del backlog offline del firmware
+// (firmware_esp32/src/timeSeriesBlock.h): timestamps delta-of-delta y valores
+// float32 comprimidos con XOR (estilo Gorilla).
+
+const BLOCK_MAGIC = 0x47;
+const BLOCK_VERSION = 1;
+
+export interface TimeSeriesSample {
+  timestamp: Date;
+  values: number[];
+}
+
+export interface TimeSeriesBlock {
+  sensorType: string;
+  metrics: string[];
+  samples: TimeSeriesSample[];
+}
+
+class BitReader {
+  private position: number;
+
+  constructor(private data: Buffer, startByte: number) {
+    this.position = startByte * 8;
+  }
+
+  read(bits: number): number {
+    if (this.position + bits > this.data.length * 8) {
+      throw new Error('Truncated time-series block');
+    }
+    let value = 0;
+    for (let i = 0; i < bits; i++) {
+      const byte = this.data[this.position >> 3];
+      const bit = (byte >> (7 - (this.position & 7))) & 1;
+      value = value * 2 + bit;
+      this.position++;
+    }
+    return value;
+  }
+}
+
+const floatView = new DataView(new ArrayBuffer(4));
+
+const bitsToFloat = (bits: number): number => {
+  floatView.setUint32(0, bits >>> 0);
+  // Precisión de float32: 23.4 en lugar de 23.399999618530273
+  return parseFloat(floatView.getFloat32(0).toPrecision(7));
+};
+
+const readDeltaOfDelta = (reader: BitReader): number => {
+  if (reader.read(1) === 0) return 0;
+  if (reader.read(1) === 0) return reader.read(7) - 63;
+  if (reader.read(1) === 0) return reader.read(9) - 255;
+  if (reader.read(1) === 0) return reader.read(12) - 2047;
+  return reader.read(32) | 0;
+};
+
+export const decodeTimeSeriesBlock = (data: Buffer): TimeSeriesBlock => {
+  if (data.length < 6 || data[0] !== BLOCK_MAGIC || data[1] !== BLOCK_VERSION) {
+    throw new Error('Invalid time-series block header');
+  }
+
+  let offset = 2;
+  const readString = (): string => {
+    const length = data[offset++];
+    const text = data.toString('ascii', offset, offset + length);
+    offset += length;
+    return text;
+  };
+
+  const sensorType = readString();
+  const metricCount = data[offset++];
+  const metrics: string[] = [];
+  for (let i = 0; i < metricCount; i++) {
+    metrics.push(readString());
+  }
+  if (offset + 2 > data.length) {
+    throw new Error('Invalid time-series block header');
+  }
+  const sampleCount = data.readUInt16LE(offset);
+  offset += 2;
+
+  const reader = new BitReader(data, offset);
+  const samples: TimeSeriesSample[] = [];
+
+  let timestamp = 0;
+  let delta = 0;
+  const previousBits: number[] = new Array(metricCount).fill(0);
+  const leading: number[] = new Array(metricCount).fill(0);
+  const trailing: number[] = new Array(metricCount).fill(0);
+
+  for (let n = 0; n < sampleCount; n++) {
+    if (n === 0) {
+      timestamp = reader.read(32);
+    } else {
+      delta += readDeltaOfDelta(reader);
+      timestamp += delta;
+    }
+
+    const values: number[] = [];
+    for (let m = 0; m < metricCount; m++) {
+      if (n === 0) {
+        previousBits[m] = reader.read(32);
+      } else if (reader.read(1) === 1) {
+        if (reader.read(1) === 1) {
+          // Ventana nueva: ceros a la izquierda + longitud significativa
+          leading[m] = reader.read(5);
+          const meaningful = reader.read(5) + 1;
+          trailing[m] = 32 - leading[m] - meaningful;
+        }
+        const meaningful = 32 - leading[m] - trailing[m];
+        const xor = (reader.read(meaningful) * Math.pow(2, trailing[m])) >>> 0;
+        previousBits[m] = (previousBits[m] ^ xor) >>> 0;
+      }
+      values.push(bitsToFloat(previousBits[m]));
+    }
+
+    samples.push({ timestamp: new Date(timestamp * 1000), values });
+  }
+
+  return { sensorType, metrics, samples };
+};